@@ -0,0 +1,433 @@
+#ifndef __CPPUTILS_BENCHES_BENCH_H__
+#define __CPPUTILS_BENCHES_BENCH_H__
+
+/*
+  a minimal harness in the style of google benchmark:
+
+  static void BM_Foo(bench::State& state) {
+      auto n = state.range(0);
+      while (state.KeepRunning()) {
+          ...
+      }
+      state.SetItemsProcessed(state.iterations() * n);
+  }
+  CPPUTILS_BENCH(BM_Foo)->Arg(1024)->Arg(65536);
+
+  CPPUTILS_BENCH_MAIN()
+
+  command line options:
+    --benchmark_filter=<substring>
+    --benchmark_min_time=<seconds>
+    --benchmark_format=<console|json>
+    --benchmark_out=<filename>  (always in json)
+*/
+
+#include <stdint.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace cpputils { namespace bench {
+
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* s_sink;
+    s_sink = &value;
+#endif
+}
+
+class State final {
+public:
+    State(uint64_t max_iterations, const std::vector<int64_t>& args)
+        : m_max_iterations(max_iterations), m_args(args) {}
+
+    bool KeepRunning() {
+        if (m_iterations == 0) {
+            ResumeTiming();
+        }
+        if (m_iterations < m_max_iterations) {
+            ++m_iterations;
+            return true;
+        }
+        PauseTiming();
+        return false;
+    }
+
+    void PauseTiming() {
+        m_elapsed += Clock::now() - m_begin;
+        m_cpu_elapsed += std::clock() - m_cpu_begin;
+    }
+
+    void ResumeTiming() {
+        m_begin = Clock::now();
+        m_cpu_begin = std::clock();
+    }
+
+    int64_t range(uint32_t idx = 0) const {
+        return m_args[idx];
+    }
+
+    uint64_t iterations() const {
+        return m_iterations;
+    }
+
+    void SetItemsProcessed(uint64_t n) {
+        m_items_processed = n;
+    }
+
+    void SetBytesProcessed(uint64_t n) {
+        m_bytes_processed = n;
+    }
+
+    void SetLabel(const std::string& label) {
+        m_label = label;
+    }
+
+private:
+    friend class Runner;
+    typedef std::chrono::steady_clock Clock;
+
+private:
+    const uint64_t m_max_iterations;
+    const std::vector<int64_t>& m_args;
+    uint64_t m_iterations = 0;
+    uint64_t m_items_processed = 0;
+    uint64_t m_bytes_processed = 0;
+    std::string m_label;
+    Clock::time_point m_begin;
+    Clock::duration m_elapsed = Clock::duration::zero();
+    /* cpu time of the process, which includes all threads */
+    std::clock_t m_cpu_begin = 0;
+    std::clock_t m_cpu_elapsed = 0;
+};
+
+typedef void (*BenchFunc)(State&);
+
+class Benchmark final {
+public:
+    Benchmark(const char* name, BenchFunc func) : m_name(name), m_func(func) {}
+
+    Benchmark* Arg(int64_t arg) {
+        m_args_list.push_back(std::vector<int64_t>(1, arg));
+        return this;
+    }
+
+    Benchmark* Args(const std::vector<int64_t>& args) {
+        m_args_list.push_back(args);
+        return this;
+    }
+
+    /** adds the cartesian product of `lists`. */
+    Benchmark* ArgsProduct(const std::vector<std::vector<int64_t>>& lists) {
+        std::vector<int64_t> args(lists.size());
+        DoArgsProduct(lists, 0, &args);
+        return this;
+    }
+
+private:
+    void DoArgsProduct(const std::vector<std::vector<int64_t>>& lists,
+                       uint32_t idx, std::vector<int64_t>* args) {
+        if (idx == lists.size()) {
+            m_args_list.push_back(*args);
+            return;
+        }
+        for (auto it = lists[idx].begin(); it != lists[idx].end(); ++it) {
+            (*args)[idx] = *it;
+            DoArgsProduct(lists, idx + 1, args);
+        }
+    }
+
+private:
+    friend class Runner;
+    std::string m_name;
+    BenchFunc m_func;
+    std::vector<std::vector<int64_t>> m_args_list;
+};
+
+inline std::vector<Benchmark*>* GetBenchmarks() {
+    static std::vector<Benchmark*> s_benchmarks;
+    return &s_benchmarks;
+}
+
+inline Benchmark* Register(const char* name, BenchFunc func) {
+    auto b = new Benchmark(name, func);
+    GetBenchmarks()->push_back(b);
+    return b;
+}
+
+class Runner final {
+public:
+    int Run(int argc, char* argv[]) {
+        std::string filter, format = "console", out;
+        double min_time = 0.5;
+        for (int i = 1; i < argc; ++i) {
+            const char* arg = argv[i];
+            if (ParseFlag(arg, "--benchmark_filter=", &filter) ||
+                ParseFlag(arg, "--benchmark_format=", &format) ||
+                ParseFlag(arg, "--benchmark_out=", &out)) {
+                continue;
+            }
+            std::string value;
+            if (ParseFlag(arg, "--benchmark_min_time=", &value)) {
+                min_time = atof(value.c_str());
+                continue;
+            }
+            fprintf(stderr, "unknown option [%s]\n", arg);
+            return -1;
+        }
+
+        auto benchmarks = GetBenchmarks();
+        for (auto b = benchmarks->begin(); b != benchmarks->end(); ++b) {
+            auto& args_list = (*b)->m_args_list;
+            if (args_list.empty()) {
+                args_list.push_back(std::vector<int64_t>());
+            }
+            for (auto args = args_list.begin(); args != args_list.end();
+                 ++args) {
+                std::string name = (*b)->m_name;
+                for (auto it = args->begin(); it != args->end(); ++it) {
+                    name += "/" + std::to_string(*it);
+                }
+                if (!filter.empty() && name.find(filter) == std::string::npos) {
+                    continue;
+                }
+                RunOne(name, (*b)->m_func, *args, min_time);
+                if (format == "console") {
+                    PrintConsole(m_results.back());
+                }
+            }
+        }
+
+        std::string json = ToJson(argv[0]);
+        if (format == "json") {
+            fputs(json.c_str(), stdout);
+        }
+        if (!out.empty()) {
+            FILE* fp = fopen(out.c_str(), "w");
+            if (!fp) {
+                fprintf(stderr, "open [%s] failed.\n", out.c_str());
+                return -1;
+            }
+            fputs(json.c_str(), fp);
+            fclose(fp);
+        }
+        return 0;
+    }
+
+private:
+    struct Result final {
+        std::string name;
+        std::string label;
+        uint64_t iterations;
+        double ns_per_iteration;
+        double cpu_ns_per_iteration;
+        double items_per_second;
+        double bytes_per_second;
+    };
+
+private:
+    static bool ParseFlag(const char* arg, const char* prefix,
+                          std::string* value) {
+        auto len = strlen(prefix);
+        if (strncmp(arg, prefix, len) != 0) {
+            return false;
+        }
+        *value = arg + len;
+        return true;
+    }
+
+    void RunOne(const std::string& name, BenchFunc func,
+                const std::vector<int64_t>& args, double min_time) {
+        uint64_t iterations = 1;
+        while (true) {
+            State state(iterations, args);
+            func(state);
+            double seconds =
+                std::chrono::duration<double>(state.m_elapsed).count();
+            if (seconds >= min_time || iterations >= 1000000000) {
+                Result res;
+                res.name = name;
+                res.label = state.m_label;
+                res.iterations = state.m_iterations;
+                res.ns_per_iteration = seconds * 1e9 / state.m_iterations;
+                res.cpu_ns_per_iteration = (double)state.m_cpu_elapsed /
+                    CLOCKS_PER_SEC * 1e9 / state.m_iterations;
+                res.items_per_second = state.m_items_processed / seconds;
+                res.bytes_per_second = state.m_bytes_processed / seconds;
+                m_results.push_back(res);
+                return;
+            }
+
+            // predicts iterations needed like google benchmark does
+            double multiplier = (seconds <= 0) ? 10 : min_time * 1.4 / seconds;
+            if (multiplier > 10) {
+                multiplier = 10;
+            }
+            auto next = (uint64_t)(iterations * multiplier);
+            iterations = (next > iterations) ? next : iterations + 1;
+        }
+    }
+
+    static void PrintConsole(const Result& res) {
+        printf("%-48s %14.1f ns %14.1f ns %12llu", res.name.c_str(),
+               res.ns_per_iteration, res.cpu_ns_per_iteration,
+               (unsigned long long)res.iterations);
+        if (res.items_per_second > 0) {
+            printf(" items/s=%.4g", res.items_per_second);
+        }
+        if (res.bytes_per_second > 0) {
+            printf(" bytes/s=%.4g", res.bytes_per_second);
+        }
+        if (!res.label.empty()) {
+            printf(" %s", res.label.c_str());
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    static void AppendJsonString(const std::string& s, std::string* output) {
+        output->push_back('"');
+        for (auto it = s.begin(); it != s.end(); ++it) {
+            const char c = *it;
+            if (c == '"' || c == '\\') {
+                output->push_back('\\');
+                output->push_back(c);
+            } else if ((unsigned char)c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+                output->append(buf);
+            } else {
+                output->push_back(c);
+            }
+        }
+        output->push_back('"');
+    }
+
+    std::string ToJson(const char* executable) const {
+        std::string json = "{\n  \"context\": {\n    \"executable\": ";
+        AppendJsonString(executable, &json);
+        json += ",\n    \"library_build_type\": ";
+#ifdef NDEBUG
+        json += "\"release\"";
+#else
+        json += "\"debug\"";
+#endif
+        json += "\n  },\n  \"benchmarks\": [";
+        for (uint32_t i = 0; i < m_results.size(); ++i) {
+            auto& res = m_results[i];
+            if (i > 0) {
+                json += ",";
+            }
+            json += "\n    {\n      \"name\": ";
+            AppendJsonString(res.name, &json);
+            json += ",\n      \"label\": ";
+            AppendJsonString(res.label, &json);
+            char buf[512];
+            snprintf(buf, sizeof(buf),
+                     ",\n      \"iterations\": %llu,\n"
+                     "      \"real_time\": %.3f,\n"
+                     "      \"cpu_time\": %.3f,\n"
+                     "      \"time_unit\": \"ns\",\n"
+                     "      \"items_per_second\": %.6g,\n"
+                     "      \"bytes_per_second\": %.6g\n    }",
+                     (unsigned long long)res.iterations, res.ns_per_iteration,
+                     res.cpu_ns_per_iteration, res.items_per_second,
+                     res.bytes_per_second);
+            json += buf;
+        }
+        json += "\n  ]\n}\n";
+        return json;
+    }
+
+private:
+    std::vector<Result> m_results;
+};
+
+/* -------------------------------------------------------------------------- */
+
+static constexpr int64_t DIST_SEQUENTIAL = 0;
+static constexpr int64_t DIST_UNIFORM = 1;
+static constexpr int64_t DIST_ZIPFIAN = 2;
+
+inline const char* GetDistName(int64_t dist) {
+    switch (dist) {
+        case DIST_SEQUENTIAL:
+            return "sequential";
+        case DIST_UNIFORM:
+            return "uniform";
+        case DIST_ZIPFIAN:
+            return "zipfian";
+        default:
+            return "unknown";
+    }
+}
+
+/** generates `n` keys in [0, n) with a fixed seed. zipfian keys use s = 0.99
+ * and ranks are mapped to keys by a random permutation, so that hot keys are
+ * not adjacent. */
+inline std::vector<uint32_t> GenKeys(uint32_t n, int64_t dist) {
+    std::vector<uint32_t> keys(n);
+    std::mt19937_64 gen(n);
+
+    if (dist == DIST_SEQUENTIAL) {
+        for (uint32_t i = 0; i < n; ++i) {
+            keys[i] = i;
+        }
+    } else if (dist == DIST_UNIFORM) {
+        std::uniform_int_distribution<uint32_t> d(0, n - 1);
+        for (uint32_t i = 0; i < n; ++i) {
+            keys[i] = d(gen);
+        }
+    } else {
+        std::vector<double> cdf(n);
+        double sum = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(i + 1.0, 0.99);
+            cdf[i] = sum;
+        }
+        // fisher-yates shuffle, which is the same on all platforms unlike
+        // `std::shuffle()`
+        std::vector<uint32_t> perm(n);
+        for (uint32_t i = 0; i < n; ++i) {
+            perm[i] = i;
+        }
+        for (uint32_t i = n; i > 1; --i) {
+            std::swap(perm[i - 1], perm[gen() % i]);
+        }
+
+        std::uniform_real_distribution<double> d(0, sum);
+        for (uint32_t i = 0; i < n; ++i) {
+            auto rank = std::lower_bound(cdf.begin(), cdf.end(), d(gen)) -
+                cdf.begin();
+            keys[i] = perm[rank];
+        }
+    }
+
+    return keys;
+}
+
+}}
+
+#define CPPUTILS_BENCH_CONCAT2(a, b) a##b
+#define CPPUTILS_BENCH_CONCAT(a, b) CPPUTILS_BENCH_CONCAT2(a, b)
+
+#define CPPUTILS_BENCH(func)                                    \
+    static ::cpputils::bench::Benchmark* CPPUTILS_BENCH_CONCAT( \
+        __cpputils_bench_, __LINE__) = ::cpputils::bench::Register(#func, func)
+
+#define CPPUTILS_BENCH_MAIN()                               \
+    int main(int argc, char* argv[]) {                      \
+        return ::cpputils::bench::Runner().Run(argc, argv); \
+    }
+
+#endif
@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "cpputils/compact_addr_manager.h"
+#include <cstdlib>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+namespace {
+
+class ChunkAllocator final : public CompactAddrManager::Allocator {
+public:
+    ~ChunkAllocator() {
+        for (auto it = m_chunks.begin(); it != m_chunks.end(); ++it) {
+            free(*it);
+        }
+    }
+    uint64_t GetAllocatedSize() const override {
+        return m_allocated_size;
+    }
+    pair<uintptr_t, uint64_t> Alloc(uint64_t needed) override {
+        if (needed < CHUNK_SIZE) {
+            needed = CHUNK_SIZE;
+        }
+        auto ptr = malloc(needed);
+        if (!ptr) {
+            return pair<uintptr_t, uint64_t>(UINTPTR_MAX, 0);
+        }
+        m_allocated_size += needed;
+        m_chunks.push_back(ptr);
+        return pair<uintptr_t, uint64_t>((uintptr_t)ptr, needed);
+    }
+
+private:
+    static constexpr uint64_t CHUNK_SIZE = 1 << 20;
+    uint64_t m_allocated_size = 0;
+    vector<void*> m_chunks;
+};
+
+}
+
+static constexpr uint32_t OP_NUM = 1 << 16;
+
+/* random sizes in [16, 16 + `max_size`), freed in random order */
+static vector<uint32_t> GenSizes(uint32_t max_size) {
+    vector<uint32_t> sizes(OP_NUM);
+    mt19937 gen(max_size);
+    uniform_int_distribution<uint32_t> d(0, max_size - 1);
+    for (auto it = sizes.begin(); it != sizes.end(); ++it) {
+        *it = 16 + d(gen);
+    }
+    return sizes;
+}
+
+// arg: max block size
+static void BM_CompactAddrManagerAllocFree(State& state) {
+    auto sizes = GenSizes(state.range(0));
+    vector<uint32_t> order(sizes.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    shuffle(order.begin(), order.end(), mt19937(0));
+
+    vector<uintptr_t> addrs(sizes.size());
+    ChunkAllocator ar;
+    CompactAddrManager mgr(&ar);
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < sizes.size(); ++i) {
+            addrs[i] = mgr.Alloc(sizes[i]);
+        }
+        for (auto it = order.begin(); it != order.end(); ++it) {
+            mgr.Free(addrs[*it], sizes[*it]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * sizes.size() * 2);
+}
+
+static void BM_MallocFree(State& state) {
+    auto sizes = GenSizes(state.range(0));
+    vector<uint32_t> order(sizes.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    shuffle(order.begin(), order.end(), mt19937(0));
+
+    vector<void*> ptrs(sizes.size());
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < sizes.size(); ++i) {
+            ptrs[i] = malloc(sizes[i]);
+        }
+        for (auto it = order.begin(); it != order.end(); ++it) {
+            free(ptrs[*it]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * sizes.size() * 2);
+}
+
+CPPUTILS_BENCH(BM_CompactAddrManagerAllocFree)->Arg(64)->Arg(4096);
+CPPUTILS_BENCH(BM_MallocFree)->Arg(64)->Arg(4096);
+
+CPPUTILS_BENCH_MAIN()
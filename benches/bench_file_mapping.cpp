@@ -0,0 +1,67 @@
+#include "bench.h"
+#include "cpputils/file_mapping.h"
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+static const char* g_filename = "bench_file_mapping.tmp";
+
+static bool PrepareFile(uint64_t size) {
+    FILE* fp = fopen(g_filename, "wb");
+    if (!fp) {
+        return false;
+    }
+    vector<char> buf(1 << 16, 'x');
+    while (size > 0) {
+        auto n = (size < buf.size()) ? size : buf.size();
+        fwrite(buf.data(), 1, n, fp);
+        size -= n;
+    }
+    fclose(fp);
+    return true;
+}
+
+/* reads one byte per cache line */
+static uint64_t Touch(const char* data, uint64_t size) {
+    uint64_t sum = 0;
+    for (uint64_t i = 0; i < size; i += 64) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+// arg: file size
+static void BM_FileMappingRead(State& state) {
+    const uint64_t size = state.range(0);
+    if (!PrepareFile(size)) {
+        return;
+    }
+    while (state.KeepRunning()) {
+        FileMapping fm;
+        fm.Init(g_filename, FileMapping::READ);
+        DoNotOptimize(Touch((const char*)fm.data(), fm.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+    remove(g_filename);
+}
+
+static void BM_FreadRead(State& state) {
+    const uint64_t size = state.range(0);
+    if (!PrepareFile(size)) {
+        return;
+    }
+    vector<char> buf(size);
+    while (state.KeepRunning()) {
+        FILE* fp = fopen(g_filename, "rb");
+        auto n = fread(buf.data(), 1, size, fp);
+        fclose(fp);
+        DoNotOptimize(Touch(buf.data(), n));
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+    remove(g_filename);
+}
+
+CPPUTILS_BENCH(BM_FileMappingRead)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 26);
+CPPUTILS_BENCH(BM_FreadRead)->Arg(1 << 16)->Arg(1 << 20)->Arg(1 << 26);
+
+CPPUTILS_BENCH_MAIN()
@@ -0,0 +1,155 @@
+#include "bench.h"
+#include "cpputils/number_utils.h"
+#include <cstdio>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+static constexpr uint32_t NUMBER_NUM = 1 << 16;
+
+/* fields as they come from a splitter */
+static vector<string> GenIntFields() {
+    vector<string> fields;
+    mt19937_64 gen(1234);
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        fields.push_back(to_string((int64_t)(gen() >> (gen() % 64))));
+    }
+    return fields;
+}
+
+static vector<string> GenDoubleFields() {
+    vector<string> fields;
+    mt19937_64 gen(5678);
+    char buf[32];
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        snprintf(buf, sizeof(buf), "%.*f", (int)(gen() % 8),
+                 (double)(gen() % 100000000) / 100.0);
+        fields.push_back(buf);
+    }
+    return fields;
+}
+
+static void BM_ParseInt(State& state) {
+    auto fields = GenIntFields();
+    while (state.KeepRunning()) {
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            int64_t v;
+            DoNotOptimize(ParseInt(it->data(), it->size(), &v));
+            DoNotOptimize(v);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fields.size());
+}
+
+/* copies the field to a string as it is not null-terminated */
+static void BM_StdStoll(State& state) {
+    auto fields = GenIntFields();
+    while (state.KeepRunning()) {
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            DoNotOptimize(stoll(string(it->data(), it->size())));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fields.size());
+}
+
+static void BM_ParseDouble(State& state) {
+    auto fields = GenDoubleFields();
+    while (state.KeepRunning()) {
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            double v;
+            DoNotOptimize(ParseDouble(it->data(), it->size(), &v));
+            DoNotOptimize(v);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fields.size());
+}
+
+static void BM_StdStod(State& state) {
+    auto fields = GenDoubleFields();
+    while (state.KeepRunning()) {
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            DoNotOptimize(stod(string(it->data(), it->size())));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * fields.size());
+}
+
+static void BM_FormatInt(State& state) {
+    mt19937_64 gen(1234);
+    vector<int64_t> values;
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        values.push_back((int64_t)(gen() >> (gen() % 64)));
+    }
+
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    while (state.KeepRunning()) {
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            DoNotOptimize(FormatInt(*it, buf));
+            DoNotOptimize(buf);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void BM_Snprintf(State& state) {
+    mt19937_64 gen(1234);
+    vector<int64_t> values;
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        values.push_back((int64_t)(gen() >> (gen() % 64)));
+    }
+
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    while (state.KeepRunning()) {
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            DoNotOptimize(snprintf(buf, sizeof(buf), "%lld", (long long)*it));
+            DoNotOptimize(buf);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void BM_FormatDouble(State& state) {
+    mt19937_64 gen(5678);
+    vector<double> values;
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        values.push_back((double)(gen() % 100000000) / 100.0);
+    }
+
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    while (state.KeepRunning()) {
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            DoNotOptimize(FormatDouble(*it, buf));
+            DoNotOptimize(buf);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+/* always round-trips but not the shortest */
+static void BM_Snprintf17g(State& state) {
+    mt19937_64 gen(5678);
+    vector<double> values;
+    for (uint32_t i = 0; i < NUMBER_NUM; ++i) {
+        values.push_back((double)(gen() % 100000000) / 100.0);
+    }
+
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    while (state.KeepRunning()) {
+        for (auto it = values.begin(); it != values.end(); ++it) {
+            DoNotOptimize(snprintf(buf, sizeof(buf), "%.17g", *it));
+            DoNotOptimize(buf);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+CPPUTILS_BENCH(BM_ParseInt);
+CPPUTILS_BENCH(BM_StdStoll);
+CPPUTILS_BENCH(BM_ParseDouble);
+CPPUTILS_BENCH(BM_StdStod);
+CPPUTILS_BENCH(BM_FormatInt);
+CPPUTILS_BENCH(BM_Snprintf);
+CPPUTILS_BENCH(BM_FormatDouble);
+CPPUTILS_BENCH(BM_Snprintf17g);
+
+CPPUTILS_BENCH_MAIN()
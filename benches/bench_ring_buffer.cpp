@@ -0,0 +1,99 @@
+#include "bench.h"
+#include "cpputils/ring_buffer.h"
+#include "cpputils/seqlock_ring_buffer.h"
+#include <deque>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+static constexpr uint32_t PUSH_NUM = 1 << 20;
+
+// arg: capacity
+static void BM_RingBufferPushBack(State& state) {
+    const uint32_t capacity = state.range(0);
+    while (state.KeepRunning()) {
+        RingBuffer<uint64_t> rb(capacity);
+        for (uint32_t i = 0; i < PUSH_NUM; ++i) {
+            rb.PushBack(i);
+        }
+        DoNotOptimize(rb.back());
+    }
+    state.SetItemsProcessed(state.iterations() * PUSH_NUM);
+}
+
+static void BM_SeqlockRingBufferPushBack(State& state) {
+    const uint32_t capacity = state.range(0);
+    while (state.KeepRunning()) {
+        SeqlockRingBuffer<uint64_t> rb(capacity);
+        for (uint32_t i = 0; i < PUSH_NUM; ++i) {
+            rb.PushBack(i);
+        }
+        DoNotOptimize(rb.size());
+    }
+    state.SetItemsProcessed(state.iterations() * PUSH_NUM);
+}
+
+static void BM_DequePushBack(State& state) {
+    const uint32_t capacity = state.range(0);
+    while (state.KeepRunning()) {
+        deque<uint64_t> dq;
+        for (uint32_t i = 0; i < PUSH_NUM; ++i) {
+            if (dq.size() == capacity) {
+                dq.pop_front();
+            }
+            dq.push_back(i);
+        }
+        DoNotOptimize(dq.back());
+    }
+    state.SetItemsProcessed(state.iterations() * PUSH_NUM);
+}
+
+static void BM_RingBufferAt(State& state) {
+    const uint32_t capacity = state.range(0);
+    RingBuffer<uint64_t> rb(capacity);
+    for (uint32_t i = 0; i < capacity + capacity / 2; ++i) {
+        rb.PushBack(i);
+    }
+    auto idx = GenKeys(capacity, DIST_UNIFORM);
+
+    while (state.KeepRunning()) {
+        uint64_t sum = 0;
+        for (auto it = idx.begin(); it != idx.end(); ++it) {
+            sum += rb.At(*it);
+        }
+        DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * idx.size());
+}
+
+static void BM_DequeAt(State& state) {
+    const uint32_t capacity = state.range(0);
+    deque<uint64_t> dq;
+    for (uint32_t i = 0; i < capacity + capacity / 2; ++i) {
+        if (dq.size() == capacity) {
+            dq.pop_front();
+        }
+        dq.push_back(i);
+    }
+    auto idx = GenKeys(capacity, DIST_UNIFORM);
+
+    while (state.KeepRunning()) {
+        uint64_t sum = 0;
+        for (auto it = idx.begin(); it != idx.end(); ++it) {
+            sum += dq[*it];
+        }
+        DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * idx.size());
+}
+
+CPPUTILS_BENCH(BM_RingBufferPushBack)->Arg(64)->Arg(4096)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_SeqlockRingBufferPushBack)
+    ->Arg(64)
+    ->Arg(4096)
+    ->Arg(1 << 20);
+CPPUTILS_BENCH(BM_DequePushBack)->Arg(64)->Arg(4096)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_RingBufferAt)->Arg(64)->Arg(4096)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_DequeAt)->Arg(64)->Arg(4096)->Arg(1 << 20);
+
+CPPUTILS_BENCH_MAIN()
@@ -0,0 +1,368 @@
+#include "bench.h"
+#include "cpputils/compact_skiplist.h"
+#include "cpputils/filtered_skiplist.h"
+#include "cpputils/flat_hash_map.h"
+#include "cpputils/frozen_index.h"
+#include "cpputils/indexed_skiplist_map.h"
+#include "cpputils/skiplist.h"
+#include "cpputils/unrolled_skiplist.h"
+#include <map>
+#include <set>
+#include <unordered_map>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+namespace {
+
+struct SkipListSetAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(key);
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    bool Erase(uint32_t key) {
+        return c.Remove(key);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.GetBeginIterator(); it != c.GetEndIterator(); ++it) {
+            sum += *it;
+        }
+        return sum;
+    }
+    SkipListSet<uint32_t> c;
+};
+
+struct UnrolledSkipListSetAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(key);
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    bool Erase(uint32_t key) {
+        return c.Remove(key);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.GetBeginIterator(); it != c.GetEndIterator(); ++it) {
+            sum += *it;
+        }
+        return sum;
+    }
+    UnrolledSkipListSet<uint32_t> c;
+};
+
+struct CompactSkipListSetAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(key);
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    bool Erase(uint32_t key) {
+        return c.Remove(key);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.GetBeginIterator(); it != c.GetEndIterator(); ++it) {
+            sum += *it;
+        }
+        return sum;
+    }
+    CompactSkipListSet<uint32_t> c;
+};
+
+struct StdSetAdapter final {
+    void Insert(uint32_t key) {
+        c.insert(key);
+    }
+    bool Find(uint32_t key) const {
+        return (c.find(key) != c.end());
+    }
+    bool Erase(uint32_t key) {
+        return (c.erase(key) > 0);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.begin(); it != c.end(); ++it) {
+            sum += *it;
+        }
+        return sum;
+    }
+    set<uint32_t> c;
+};
+
+struct SkipListMapAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(make_pair(key, (uint64_t)key));
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    bool Erase(uint32_t key) {
+        return c.Remove(key);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.GetBeginIterator(); it != c.GetEndIterator(); ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    SkipListMap<uint32_t, uint64_t> c;
+};
+
+struct StdMapAdapter final {
+    void Insert(uint32_t key) {
+        c.insert(make_pair(key, (uint64_t)key));
+    }
+    bool Find(uint32_t key) const {
+        return (c.find(key) != c.end());
+    }
+    bool Erase(uint32_t key) {
+        return (c.erase(key) > 0);
+    }
+    uint64_t Scan() const {
+        uint64_t sum = 0;
+        for (auto it = c.begin(); it != c.end(); ++it) {
+            sum += it->second;
+        }
+        return sum;
+    }
+    map<uint32_t, uint64_t> c;
+};
+
+struct FilteredSkipListSetAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(key);
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    FilteredSkipListSet<uint32_t> c;
+};
+
+struct FlatHashMapAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(make_pair(key, (uint64_t)key));
+    }
+    bool Find(uint32_t key) const {
+        return (c.Lookup(key) != c.GetEndIterator());
+    }
+    FlatHashMap<uint32_t, uint64_t> c;
+};
+
+struct IndexedSkipListMapAdapter final {
+    void Insert(uint32_t key) {
+        c.Insert(make_pair(key, (uint64_t)key));
+    }
+    bool Find(uint32_t key) const {
+        return (c.Find(key) != nullptr);
+    }
+    IndexedSkipListMap<uint32_t, uint64_t> c;
+};
+
+struct StdUnorderedMapAdapter final {
+    void Insert(uint32_t key) {
+        c.insert(make_pair(key, (uint64_t)key));
+    }
+    bool Find(uint32_t key) const {
+        return (c.find(key) != c.end());
+    }
+    unordered_map<uint32_t, uint64_t> c;
+};
+
+}
+
+// args: number of keys, key distribution
+static const vector<vector<int64_t>> g_args = {
+    {1 << 10, 1 << 16, 1 << 20},
+    {DIST_SEQUENTIAL, DIST_UNIFORM, DIST_ZIPFIAN},
+};
+
+template <typename Adapter>
+static void BM_Insert(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    while (state.KeepRunning()) {
+        auto adapter = new Adapter();
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            adapter->Insert(*it);
+        }
+        state.PauseTiming(); // excludes destruction
+        delete adapter;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+template <typename Adapter>
+static void BM_Lookup(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    Adapter adapter;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        adapter.Insert(*it);
+    }
+
+    // probes are shuffled so that sequential keys don't benefit from caches
+    auto probes = keys;
+    shuffle(probes.begin(), probes.end(), mt19937(0));
+
+    while (state.KeepRunning()) {
+        for (auto it = probes.begin(); it != probes.end(); ++it) {
+            DoNotOptimize(adapter.Find(*it));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+/* all probes miss: keys are even and probes are odd ones between them */
+template <typename Adapter>
+static void BM_LookupMiss(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    Adapter adapter;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        adapter.Insert(*it * 2);
+    }
+
+    auto probes = keys;
+    for (auto it = probes.begin(); it != probes.end(); ++it) {
+        *it = *it * 2 + 1;
+    }
+    shuffle(probes.begin(), probes.end(), mt19937(0));
+
+    while (state.KeepRunning()) {
+        for (auto it = probes.begin(); it != probes.end(); ++it) {
+            DoNotOptimize(adapter.Find(*it));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+/* the same as `BM_Lookup<SkipListSetAdapter>` on a frozen copy */
+static void BM_FrozenSetLookup(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    SkipListSet<uint32_t> list;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        list.Insert(*it);
+    }
+    FrozenSet<uint32_t> index;
+    Freeze(list, &index);
+
+    auto probes = keys;
+    shuffle(probes.begin(), probes.end(), mt19937(0));
+
+    while (state.KeepRunning()) {
+        for (auto it = probes.begin(); it != probes.end(); ++it) {
+            DoNotOptimize(index.Lookup(*it) != index.GetEndIterator());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * probes.size());
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+template <typename Adapter>
+static void BM_Scan(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    Adapter adapter;
+    for (auto it = keys.begin(); it != keys.end(); ++it) {
+        adapter.Insert(*it);
+    }
+
+    while (state.KeepRunning()) {
+        DoNotOptimize(adapter.Scan());
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+template <typename Adapter>
+static void BM_InsertAndRemove(State& state) {
+    auto keys = GenKeys(state.range(0), state.range(1));
+    Adapter adapter;
+    while (state.KeepRunning()) {
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            adapter.Insert(*it);
+        }
+        for (auto it = keys.begin(); it != keys.end(); ++it) {
+            adapter.Erase(*it);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size() * 2);
+    state.SetLabel(GetDistName(state.range(1)));
+}
+
+/* drains a timer queue whose deadlines are shared by 16 timers on average */
+template <bool UsePopFront>
+static void BM_DrainTimers(State& state) {
+    const uint64_t n = state.range(0);
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        auto timers = new SkipListMultiMap<uint64_t, uint64_t>();
+        for (uint64_t i = 0; i < n; ++i) {
+            timers->Insert(make_pair(i / 16, i));
+        }
+        state.ResumeTiming();
+
+        if (UsePopFront) {
+            while (timers->PopFront()) {
+            }
+        } else {
+            while (!timers->IsEmpty()) {
+                timers->Remove(timers->GetBeginIterator()->first);
+            }
+        }
+
+        state.PauseTiming();
+        delete timers;
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+CPPUTILS_BENCH(BM_Insert<SkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<UnrolledSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<CompactSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<StdSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<SkipListMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<StdMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<FlatHashMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<IndexedSkipListMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Insert<StdUnorderedMapAdapter>)->ArgsProduct(g_args);
+
+CPPUTILS_BENCH(BM_Lookup<SkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<UnrolledSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<CompactSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<StdSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<SkipListMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<StdMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<FlatHashMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<IndexedSkipListMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Lookup<StdUnorderedMapAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_FrozenSetLookup)->ArgsProduct(g_args);
+
+CPPUTILS_BENCH(BM_LookupMiss<SkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_LookupMiss<FilteredSkipListSetAdapter>)
+    ->ArgsProduct(g_args);
+
+CPPUTILS_BENCH(BM_Scan<SkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Scan<UnrolledSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Scan<CompactSkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_Scan<StdSetAdapter>)->ArgsProduct(g_args);
+
+CPPUTILS_BENCH(BM_InsertAndRemove<SkipListSetAdapter>)->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_InsertAndRemove<UnrolledSkipListSetAdapter>)
+    ->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_InsertAndRemove<CompactSkipListSetAdapter>)
+    ->ArgsProduct(g_args);
+CPPUTILS_BENCH(BM_InsertAndRemove<StdSetAdapter>)->ArgsProduct(g_args);
+
+CPPUTILS_BENCH(BM_DrainTimers<true>)->Arg(1 << 16)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_DrainTimers<false>)->Arg(1 << 16)->Arg(1 << 20);
+
+CPPUTILS_BENCH_MAIN()
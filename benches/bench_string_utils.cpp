@@ -0,0 +1,337 @@
+#include "bench.h"
+#include "cpputils/csv_tokenizer.h"
+#include "cpputils/string_pool.h"
+#include "cpputils/string_utils.h"
+#include <unordered_map>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+/* `len` bytes of lowercase letters and ',' with `needle` inserted about every
+ * `interval` bytes */
+static string GenText(uint32_t len, const string& needle, uint32_t interval) {
+    string text;
+    text.reserve(len + needle.size());
+    mt19937 gen(len);
+    uniform_int_distribution<int> d(0, 26);
+    while (text.size() < len) {
+        if (interval > 0 && text.size() % interval == 0) {
+            text += needle;
+        }
+        int c = d(gen);
+        text.push_back((c == 26) ? ',' : (char)('a' + c));
+    }
+    return text;
+}
+
+static string StdStringReplace(const string& text, const string& search,
+                               const string& replace) {
+    string ret;
+    string::size_type begin = 0;
+    while (true) {
+        auto pos = text.find(search, begin);
+        if (pos == string::npos) {
+            ret.append(text, begin, string::npos);
+            return ret;
+        }
+        ret.append(text, begin, pos - begin);
+        ret += replace;
+        begin = pos + search.size();
+    }
+}
+
+// args: text size, interval of matches
+static void BM_StringReplace(State& state) {
+    const string search = "needle", replace = "NEEDLE!";
+    auto text = GenText(state.range(0), search, state.range(1));
+    while (state.KeepRunning()) {
+        DoNotOptimize(StringReplace(text.data(), text.size(), search.data(),
+                                    search.size(), replace.data(),
+                                    replace.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* the same input fed in 64KB chunks to a sink that only counts bytes */
+static void BM_StringReplacer(State& state) {
+    const string search = "needle", replace = "NEEDLE!";
+    auto text = GenText(state.range(0), search, state.range(1));
+    const uint64_t chunk_size = 64 * 1024;
+    uint64_t output_size = 0;
+    StringReplacer replacer(search.data(), search.size(), replace.data(),
+                            replace.size(),
+                            [&output_size](const char*, unsigned int len) {
+                                output_size += len;
+                                return true;
+                            });
+    while (state.KeepRunning()) {
+        for (uint64_t pos = 0; pos < text.size(); pos += chunk_size) {
+            replacer.Feed(text.data() + pos,
+                          min(chunk_size, text.size() - pos));
+        }
+        replacer.Finish();
+        DoNotOptimize(output_size);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_StdStringFindReplace(State& state) {
+    const string search = "needle", replace = "NEEDLE!";
+    auto text = GenText(state.range(0), search, state.range(1));
+    while (state.KeepRunning()) {
+        DoNotOptimize(StdStringReplace(text, search, replace));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// arg: text size
+static void BM_StringSplitter(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    while (state.KeepRunning()) {
+        StringSplitter splitter(text.data(), text.size());
+        uint64_t fields = 0;
+        while (splitter.Next(",", 1).first) {
+            ++fields;
+        }
+        DoNotOptimize(fields);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_StdStringFindSplit(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    while (state.KeepRunning()) {
+        uint64_t fields = 0;
+        string::size_type begin = 0;
+        while (true) {
+            ++fields;
+            auto pos = text.find(',', begin);
+            if (pos == string::npos) {
+                break;
+            }
+            begin = pos + 1;
+        }
+        DoNotOptimize(fields);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* csv records of 8 fields, a quarter of which are quoted with commas */
+static string GenCsv(uint32_t len) {
+    string text;
+    text.reserve(len + 64);
+    mt19937 gen(len);
+    uniform_int_distribution<int> d(0, 25);
+    for (uint32_t field = 0; text.size() < len; ++field) {
+        const bool quoted = (gen() % 4 == 0);
+        if (quoted) {
+            text.push_back('"');
+        }
+        const uint32_t flen = gen() % 16;
+        for (uint32_t i = 0; i < flen; ++i) {
+            text.push_back('a' + d(gen));
+            if (quoted && i == flen / 2) {
+                text.push_back(',');
+            }
+        }
+        if (quoted) {
+            text.push_back('"');
+        }
+        text.push_back((field % 8 == 7) ? '\n' : ',');
+    }
+    return text;
+}
+
+// arg: text size
+static void BM_CsvTokenizer(State& state) {
+    auto text = GenCsv(state.range(0));
+    while (state.KeepRunning()) {
+        CsvTokenizer tokenizer(text.data(), text.size());
+        CsvField field;
+        uint64_t fields = 0;
+        while (tokenizer.Next(&field)) {
+            DoNotOptimize(field);
+            ++fields;
+        }
+        DoNotOptimize(fields);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* tracks quotes char by char */
+static void BM_CsvCharByChar(State& state) {
+    auto text = GenCsv(state.range(0));
+    while (state.KeepRunning()) {
+        uint64_t fields = 0;
+        bool in_quote = false;
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        for (auto cur = begin; cur != end; ++cur) {
+            if (*cur == '"') {
+                in_quote = !in_quote;
+            } else if (!in_quote && (*cur == ',' || *cur == '\n')) {
+                DoNotOptimize(make_pair(begin, cur - begin));
+                begin = cur + 1;
+                ++fields;
+            }
+        }
+        DoNotOptimize(fields);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* `len` bytes of text padded with `pad` whitespaces at both ends */
+static string GenPaddedText(uint32_t len, uint32_t pad) {
+    const string ws = " \t\r\n";
+    string text;
+    for (uint32_t i = 0; i < pad; ++i) {
+        text.push_back(ws[i % ws.size()]);
+    }
+    text += GenText(len, "", 0);
+    for (uint32_t i = 0; i < pad; ++i) {
+        text.push_back(ws[i % ws.size()]);
+    }
+    return text;
+}
+
+static bool IsSpace(char c) {
+    return (c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+            c == '\r');
+}
+
+// args: text size, whitespaces at each end
+static void BM_StringTrimBoth(State& state) {
+    auto text = GenPaddedText(state.range(0), state.range(1));
+    const auto ws = ByteSet::Whitespace();
+    while (state.KeepRunning()) {
+        DoNotOptimize(StringTrimBoth(text.data(), text.size(), ws));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1) * 2);
+}
+
+static void BM_CharLoopTrimBoth(State& state) {
+    auto text = GenPaddedText(state.range(0), state.range(1));
+    while (state.KeepRunning()) {
+        const char* begin = text.data();
+        const char* end = begin + text.size();
+        while (begin < end && IsSpace(*begin)) {
+            ++begin;
+        }
+        while (end > begin && IsSpace(end[-1])) {
+            --end;
+        }
+        DoNotOptimize(make_pair(begin, end - begin));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1) * 2);
+}
+
+// arg: text size. the only match is at the end.
+static void BM_StringFindFirstOf(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    text.push_back('!');
+    const ByteSet chars("!?;", 3);
+    while (state.KeepRunning()) {
+        DoNotOptimize(StringFindFirstOf(text.data(), text.size(), chars));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_StdStringFindFirstOf(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    text.push_back('!');
+    while (state.KeepRunning()) {
+        DoNotOptimize(text.find_first_of("!?;"));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+// arg: text size
+static void BM_StringCount(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    while (state.KeepRunning()) {
+        DoNotOptimize(StringCount(text.data(), text.size(), ','));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static void BM_StdCount(State& state) {
+    auto text = GenText(state.range(0), "", 0);
+    while (state.KeepRunning()) {
+        DoNotOptimize(count(text.begin(), text.end(), ','));
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* `len` bytes of fields drawn from `distinct` hostnames, separated by ',' */
+static string GenTokens(uint32_t len, uint32_t distinct) {
+    string text;
+    text.reserve(len + 32);
+    mt19937 gen(len + distinct);
+    while (text.size() < len) {
+        text += "host-" + to_string(gen() % distinct) + ".example.com,";
+    }
+    return text;
+}
+
+// args: text size, distinct tokens
+static void BM_StringPoolIntern(State& state) {
+    auto text = GenTokens(state.range(0), state.range(1));
+    while (state.KeepRunning()) {
+        StringPool pool;
+        StringSplitter splitter(text.data(), text.size());
+        uint64_t sum = 0;
+        while (true) {
+            auto field = splitter.Next(",", 1);
+            if (!field.first) {
+                break;
+            }
+            sum += pool.Intern(field.first, field.second);
+        }
+        DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/* the usual way: a `std::string` per token as the map key */
+static void BM_StdStringIntern(State& state) {
+    auto text = GenTokens(state.range(0), state.range(1));
+    while (state.KeepRunning()) {
+        unordered_map<string, uint32_t> ids;
+        StringSplitter splitter(text.data(), text.size());
+        uint64_t sum = 0;
+        while (true) {
+            auto field = splitter.Next(",", 1);
+            if (!field.first) {
+                break;
+            }
+            auto ret = ids.insert(make_pair(string(field.first, field.second),
+                                            (uint32_t)ids.size()));
+            sum += ret.first->second;
+        }
+        DoNotOptimize(sum);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+static const vector<vector<int64_t>> g_replace_args = {
+    {1 << 12, 1 << 20},
+    {64, 4096},
+};
+
+CPPUTILS_BENCH(BM_StringReplace)->ArgsProduct(g_replace_args);
+CPPUTILS_BENCH(BM_StdStringFindReplace)->ArgsProduct(g_replace_args);
+CPPUTILS_BENCH(BM_StringReplacer)->ArgsProduct(g_replace_args);
+CPPUTILS_BENCH(BM_StringSplitter)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StdStringFindSplit)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_CsvTokenizer)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_CsvCharByChar)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StringTrimBoth)->ArgsProduct({{64}, {4, 256}});
+CPPUTILS_BENCH(BM_CharLoopTrimBoth)->ArgsProduct({{64}, {4, 256}});
+CPPUTILS_BENCH(BM_StringFindFirstOf)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StdStringFindFirstOf)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StringCount)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StdCount)->Arg(1 << 12)->Arg(1 << 20);
+CPPUTILS_BENCH(BM_StringPoolIntern)->ArgsProduct({{1 << 20}, {64, 65536}});
+CPPUTILS_BENCH(BM_StdStringIntern)->ArgsProduct({{1 << 20}, {64, 65536}});
+
+CPPUTILS_BENCH_MAIN()
@@ -0,0 +1,96 @@
+#include "bench.h"
+#include "cpputils/skiplist.h"
+#include "cpputils/timing_wheel.h"
+#include <memory>
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+/*
+  each iteration schedules `n` timers with delays in [0, 65536) ticks,
+  cancels a quarter of them and advances 1024 ticks at a time until all of
+  the others expire.
+*/
+
+static constexpr uint64_t MAX_DELAY = 65536;
+static constexpr uint64_t ADVANCE_STEP = 1024;
+
+static inline uint64_t NextDelay(uint64_t* state) {
+    // xorshift64, cheap enough not to dominate adding a timer
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x & (MAX_DELAY - 1);
+}
+
+// arg: number of timers
+static void BM_TimingWheel(State& state) {
+    const uint64_t n = state.range(0);
+    unique_ptr<TimerNode[]> timers(new TimerNode[n]);
+
+    while (state.KeepRunning()) {
+        TimingWheel wheel(1, 0);
+        uint64_t seed = 88172645463325252ull;
+        for (uint64_t i = 0; i < n; ++i) {
+            wheel.Add(&timers[i], NextDelay(&seed));
+        }
+        for (uint64_t i = 0; i < n; i += 4) {
+            wheel.Cancel(&timers[i]);
+        }
+
+        uint64_t now = 0, expired = 0;
+        while (!wheel.IsEmpty()) {
+            now += ADVANCE_STEP;
+            expired += wheel.Advance(now, [](TimerNode*) -> void {});
+        }
+        DoNotOptimize(expired);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+struct SkipListTimer final {
+    std::pair<uint64_t, uint64_t> key; // {expire tick, sequence}
+};
+
+// a timer queue ordered by expire ticks
+static void BM_SkipListMapTimerQueue(State& state) {
+    const uint64_t n = state.range(0);
+    unique_ptr<SkipListTimer[]> timers(new SkipListTimer[n]);
+
+    while (state.KeepRunning()) {
+        SkipListMap<std::pair<uint64_t, uint64_t>, SkipListTimer*> queue;
+        uint64_t seed = 88172645463325252ull;
+        for (uint64_t i = 0; i < n; ++i) {
+            timers[i].key = std::make_pair(NextDelay(&seed), i);
+            queue.TryEmplace(timers[i].key, &timers[i]);
+        }
+        for (uint64_t i = 0; i < n; i += 4) {
+            queue.Remove(timers[i].key);
+        }
+
+        uint64_t now = 0, expired = 0;
+        while (!queue.IsEmpty()) {
+            now += ADVANCE_STEP;
+            expired += queue.PopWhile(
+                [now](const std::pair<std::pair<uint64_t, uint64_t>,
+                                      SkipListTimer*>& v) -> bool {
+                    return (v.first.first < now);
+                },
+                [](std::pair<std::pair<uint64_t, uint64_t>, SkipListTimer*>&&)
+                    -> void {});
+        }
+        DoNotOptimize(expired);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// 100M timers need more than 6GB in `SkipListMap`
+CPPUTILS_BENCH(BM_TimingWheel)
+    ->Arg(1000000)
+    ->Arg(10000000)
+    ->Arg(100000000);
+CPPUTILS_BENCH(BM_SkipListMapTimerQueue)->Arg(1000000)->Arg(10000000);
+
+CPPUTILS_BENCH_MAIN()
@@ -0,0 +1,45 @@
+#include "bench.h"
+#include "cpputils/trace.h"
+using namespace std;
+using namespace cpputils;
+using namespace cpputils::bench;
+
+static constexpr uint32_t SPAN_NUM = 1 << 16;
+
+static void BM_TraceNow(State& state) {
+    while (state.KeepRunning()) {
+        uint64_t sum = 0;
+        for (uint32_t i = 0; i < SPAN_NUM; ++i) {
+            sum += TraceNow();
+        }
+        DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN_NUM);
+}
+
+// events are overwritten in the ring buffer without being collected
+static void BM_TraceSpan(State& state) {
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < SPAN_NUM; ++i) {
+            TraceSpan span("bench");
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * SPAN_NUM);
+}
+
+static void BM_TraceCollect(State& state) {
+    TraceCollector collector(0);
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < 4096; ++i) {
+            TraceSpan span("bench");
+        }
+        DoNotOptimize(collector.Collect());
+    }
+    state.SetItemsProcessed(state.iterations() * 4096);
+}
+
+CPPUTILS_BENCH(BM_TraceNow);
+CPPUTILS_BENCH(BM_TraceSpan);
+CPPUTILS_BENCH(BM_TraceCollect);
+
+CPPUTILS_BENCH_MAIN()
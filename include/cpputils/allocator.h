@@ -2,6 +2,7 @@
 #define __CPPUTILS_ALLOCATOR_H__
 
 #include <stdint.h>
+#include <cstddef> // max_align_t
 
 namespace cpputils {
 
@@ -10,6 +11,39 @@ public:
     virtual ~Allocator() {}
     virtual void* Alloc(uint64_t bytes) = 0;
     virtual void Free(void* ptr) = 0;
+
+    /*
+      the aligned and sized versions are not virtual, so that subclasses which
+      only override the two functions above still work, and are customized
+      by overriding `DoAlloc()` and `DoFree()`. a subclass declaring
+      `Alloc()` or `Free()` hides them, which can be made visible again by
+      `using Allocator::Alloc;` and `using Allocator::Free;`.
+    */
+
+    /** `alignment` MUST be a power of 2. */
+    void* Alloc(uint64_t bytes, uint64_t alignment) {
+        return DoAlloc(bytes, alignment);
+    }
+
+    /** `bytes` MUST be the size passed to `Alloc()`. */
+    void Free(void* ptr, uint64_t bytes) {
+        DoFree(ptr, bytes);
+    }
+
+protected:
+    /** the default implementation returns nullptr if `alignment` >
+     * `alignof(max_align_t)`. */
+    virtual void* DoAlloc(uint64_t bytes, uint64_t alignment) {
+        if (alignment > alignof(std::max_align_t)) {
+            return nullptr;
+        }
+        return Alloc(bytes);
+    }
+
+    virtual void DoFree(void* ptr, uint64_t bytes) {
+        (void)bytes;
+        Free(ptr);
+    }
 };
 
 }
@@ -0,0 +1,97 @@
+#ifndef __CPPUTILS_ARENA_ALLOCATOR_H__
+#define __CPPUTILS_ARENA_ALLOCATOR_H__
+
+#include "cpputils/allocator.h"
+#include <vector>
+
+namespace cpputils {
+
+/**
+   a bump-pointer allocator. `Free()` does nothing, and all memory allocated is
+   reclaimed at once by `Reset()` or `Release()`.
+*/
+class ArenaAllocator : public Allocator {
+public:
+    static constexpr uint64_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+public:
+    ArenaAllocator(uint64_t block_size = DEFAULT_BLOCK_SIZE)
+        : m_block_size(block_size) {}
+
+    ~ArenaAllocator() {
+        Release();
+    }
+
+    /** takes over all blocks of `other`, which becomes empty. */
+    ArenaAllocator(ArenaAllocator&& other) : m_block_size(other.m_block_size) {
+        DoMove(&other);
+    }
+
+    ArenaAllocator& operator=(ArenaAllocator&& other) {
+        if (&other != this) {
+            Release();
+            m_block_size = other.m_block_size;
+            DoMove(&other);
+        }
+        return *this;
+    }
+
+    void* Alloc(uint64_t bytes) override;
+    void Free(void*) override {}
+
+    using Allocator::Alloc;
+    using Allocator::Free;
+
+    /** makes all blocks available for later allocations without returning
+     * them to the system. */
+    void Reset() {
+        m_cur = 0;
+        m_offset = 0;
+    }
+
+    /** returns all blocks to the system. */
+    void Release();
+
+    /** returns the number of bytes obtained from the system. */
+    uint64_t GetAllocatedSize() const {
+        return m_allocated_size;
+    }
+
+private:
+    struct Block final {
+        char* base;
+        uint64_t size;
+    };
+
+    void* AllocFromBlocks(uint64_t bytes, uint64_t alignment);
+
+    void DoMove(ArenaAllocator* other) {
+        m_allocated_size = other->m_allocated_size;
+        m_offset = other->m_offset;
+        m_cur = other->m_cur;
+        m_blocks = std::move(other->m_blocks);
+        other->m_blocks.clear();
+        other->m_allocated_size = 0;
+        other->m_offset = 0;
+        other->m_cur = 0;
+    }
+
+protected:
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override;
+    void DoFree(void*, uint64_t) override {}
+
+private:
+    uint64_t m_block_size;
+    uint64_t m_allocated_size = 0;
+    uint64_t m_offset = 0; // offset in the current block
+    uint32_t m_cur = 0; // index of the current block
+    std::vector<Block> m_blocks;
+
+private:
+    ArenaAllocator(const ArenaAllocator&) = delete;
+    ArenaAllocator& operator=(const ArenaAllocator&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef __CPPUTILS_BIT_UTILS_H__
+#define __CPPUTILS_BIT_UTILS_H__
+
+#include <stdint.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cpputils {
+
+namespace internal {
+
+/* `x` MUST NOT be 0 */
+inline uint32_t CountTrailingZeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+/* `x` MUST NOT be 0 */
+inline uint32_t CountLeadingZeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanReverse64(&idx, x);
+    return 63 - idx;
+#else
+    return __builtin_clzll(x);
+#endif
+}
+
+/* floor(log2(x)) for x > 0, usable in constant expressions */
+constexpr uint32_t Log2(uint64_t x) {
+    return (x <= 1) ? 0 : 1 + Log2(x >> 1);
+}
+
+inline void Prefetch(const void* p) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch((const char*)p, _MM_HINT_T0);
+#elif defined(_MSC_VER)
+    (void)p;
+#else
+    __builtin_prefetch(p);
+#endif
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef __CPPUTILS_BLOOM_FILTER_H__
+#define __CPPUTILS_BLOOM_FILTER_H__
+
+#include <stdint.h>
+
+namespace cpputils {
+
+/**
+   a split block bloom filter on 64-bit hashes. each key sets one bit in each
+   of the 8 words of a 32-byte block, so a query reads a single cache line and
+   the 8 probes are independent of each other, which compilers vectorize.
+   about 1% false positives at 10 bits per key.
+*/
+class BloomFilter final {
+public:
+    static constexpr uint32_t DEFAULT_BITS_PER_KEY = 10;
+
+public:
+    BloomFilter() {}
+    ~BloomFilter() {
+        Destroy();
+    }
+
+    BloomFilter(BloomFilter&&);
+    BloomFilter& operator=(BloomFilter&&);
+
+    /** clears the filter and resizes it for `key_num` keys. */
+    bool Init(uint64_t key_num, uint32_t bits_per_key = DEFAULT_BITS_PER_KEY);
+    void Destroy();
+
+    /** `hash` SHOULD be well mixed in all bits. does nothing if not
+     * initialized. */
+    void Add(uint64_t hash);
+    /** always true if not initialized. */
+    bool MayContain(uint64_t hash) const;
+
+    /** unsets all bits. */
+    void Clear();
+
+    /** returns the number of keys the filter is sized for. */
+    uint64_t GetCapacity() const {
+        return m_capacity;
+    }
+
+    uint64_t GetMemoryUsage() const {
+        return m_block_num * sizeof(Block);
+    }
+
+private:
+    struct Block final {
+        uint32_t words[8];
+    };
+
+    Block* GetBlock(uint64_t hash) const {
+        // maps the high 32 bits to [0, m_block_num) without division
+        return &m_blocks[((hash >> 32) * m_block_num) >> 32];
+    }
+
+private:
+    Block* m_blocks = nullptr;
+    uint64_t m_block_num = 0;
+    uint64_t m_capacity = 0;
+
+private:
+    BloomFilter(const BloomFilter&) = delete;
+    BloomFilter& operator=(const BloomFilter&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,516 @@
+#ifndef __CPPUTILS_COMPACT_SKIPLIST_H__
+#define __CPPUTILS_COMPACT_SKIPLIST_H__
+
+#include "skiplist.h"
+#include <algorithm> // std::fill
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace cpputils {
+
+/*
+  a skiplist whose nodes are allocated from one contiguous buffer and linked
+  by 32-bit offsets (in units of 8 bytes, so the buffer can grow up to 32GB).
+  the buffer is position-independent: `GetBuffer()`/`GetBufferSize()` can be
+  copied elsewhere, e.g. written to a file or sent to another process, and
+  loaded by `Load()`.
+
+  `Value` MUST be trivially copyable. `Comparator` is the same as `SkipList`.
+  the buffer may be reallocated by `Insert()`, which invalidates pointers to
+  values but not iterators.
+*/
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Allocator>
+class CompactSkipList final : public Allocator {
+private:
+    static constexpr uint32_t MAX_LEVEL = 12;
+    static constexpr uint32_t MAGIC = 0x4c4b5343; // "CSKL"
+    static constexpr uint64_t UNIT = 8;
+    static constexpr uint64_t MAX_BUFFER_SIZE = UNIT * UINT32_MAX;
+    static constexpr uint64_t INITIAL_BUFFER_SIZE = 4096;
+
+    /* `std::pair` is not trivially copyable because of its assignments. */
+    static_assert(std::is_trivially_copy_constructible<Value>::value &&
+                      std::is_trivially_destructible<Value>::value,
+                  "`Value` MUST be trivially copyable.");
+    static_assert(alignof(Value) <= UNIT, "alignment of `Value` is too large.");
+
+private:
+    /* offset 0 in a buffer is the header, which is also the head node. */
+    struct Header final {
+        uint32_t magic;
+        uint32_t value_size;
+        uint64_t used; // in bytes
+        uint64_t count;
+        uint32_t level;
+        uint32_t free_list[MAX_LEVEL]; // freed nodes of each level
+        uint32_t forward[MAX_LEVEL];
+    };
+
+    /* placed after `Value` in each node. the first forward link of a freed
+     * node points to the next freed one. */
+    struct NodeMeta final {
+        uint32_t level;
+        uint32_t forward[0];
+    };
+
+    static constexpr uint64_t HEADER_SIZE =
+        (sizeof(Header) + UNIT - 1) & ~(UNIT - 1);
+    static constexpr uint64_t META_OFFSET =
+        (sizeof(Value) + alignof(NodeMeta) - 1) & ~(alignof(NodeMeta) - 1);
+
+public:
+    class Iterator final {
+    public:
+        Value* operator->() {
+            return m_list->GetValue(m_node);
+        }
+        const Value* operator->() const {
+            return m_list->GetValue(m_node);
+        }
+        Value& operator*() {
+            return *m_list->GetValue(m_node);
+        }
+        const Value& operator*() const {
+            return *m_list->GetValue(m_node);
+        }
+        bool operator==(const Iterator& it) const {
+            return (m_node == it.m_node);
+        }
+        bool operator!=(const Iterator& it) const {
+            return (m_node != it.m_node);
+        }
+        void operator++() {
+            m_node = m_list->GetForward(m_node)[0];
+        }
+
+    private:
+        friend class CompactSkipList;
+        Iterator(const CompactSkipList* list = nullptr, uint32_t node = 0)
+            : m_list(list), m_node(node) {}
+
+    private:
+        const CompactSkipList* m_list;
+        uint32_t m_node;
+    };
+
+public:
+    CompactSkipList() {
+        xoshiro256ss_init(&m_rand, (uintptr_t)this);
+    }
+
+    ~CompactSkipList() {
+        if (m_buf) {
+            this->DoFree(m_buf, m_buf_size);
+        }
+    }
+
+    std::pair<Iterator, bool> Insert(const Value& value) {
+        if (!m_buf && !Reserve(INITIAL_BUFFER_SIZE)) {
+            return std::pair<Iterator, bool>(Iterator(), false);
+        }
+
+        const Key& key = m_get_key(value);
+
+        uint32_t ge_diff = UINT32_MAX;
+        uint32_t update[MAX_LEVEL];
+        auto node = DoLookupGreaterEqual(key, &ge_diff, update);
+        if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+            return std::pair<Iterator, bool>(Iterator(this, node), false);
+        }
+
+        // `value` may be in the buffer and moved by `AllocNode()`
+        const Value copied(value);
+
+        const uint32_t level = GenRandomLevel();
+        node = AllocNode(level);
+        if (!node) {
+            return std::pair<Iterator, bool>(Iterator(), false);
+        }
+
+        memcpy((void*)GetValue(node), &copied, sizeof(Value));
+        auto meta = GetNodeMeta(node);
+        meta->level = level;
+
+        auto header = GetHeader();
+        if (level > header->level) {
+            for (uint32_t i = header->level; i < level; ++i) {
+                update[i] = 0;
+            }
+            header->level = level;
+        }
+
+        for (uint32_t i = 0; i < level; ++i) {
+            auto prev_forward = GetForward(update[i]);
+            meta->forward[i] = prev_forward[i];
+            prev_forward[i] = node;
+        }
+        ++header->count;
+
+        return std::pair<Iterator, bool>(Iterator(this, node), true);
+    }
+
+    bool Remove(const Key& key, Value* value = nullptr) {
+        if (!m_buf) {
+            return false;
+        }
+
+        uint32_t ge_diff = UINT32_MAX;
+        uint32_t update[MAX_LEVEL];
+        auto node = DoLookupGreaterEqual(key, &ge_diff, update);
+        if (!node || ge_diff != SKIPLIST_DIFF_EQ) {
+            return false;
+        }
+
+        auto meta = GetNodeMeta(node);
+        auto header = GetHeader();
+        for (uint32_t level = 0; level < meta->level; ++level) {
+            GetForward(update[level])[level] = meta->forward[level];
+        }
+
+        if (value) {
+            memcpy((void*)value, GetValue(node), sizeof(Value));
+        }
+
+        meta->forward[0] = header->free_list[meta->level - 1];
+        header->free_list[meta->level - 1] = node;
+        --header->count;
+
+        while (header->level > 0 && !header->forward[header->level - 1]) {
+            --header->level;
+        }
+
+        return true;
+    }
+
+    /** keeps the buffer for later insertions. */
+    void Clear() {
+        if (m_buf) {
+            InitHeader();
+        }
+    }
+
+    Iterator Lookup(const Key& key) const {
+        if (!m_buf) {
+            return Iterator();
+        }
+        uint32_t ge_diff = UINT32_MAX;
+        auto node = DoLookupGreaterEqual(key, &ge_diff);
+        if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+            return Iterator(this, node);
+        }
+        return Iterator();
+    }
+
+    Iterator LookupGreaterEqual(const Key& key) const {
+        if (!m_buf) {
+            return Iterator();
+        }
+        return Iterator(this, DoLookupGreaterEqual(key));
+    }
+
+    Iterator LookupLessThan(const Key& key) const {
+        if (!m_buf) {
+            return Iterator();
+        }
+        return Iterator(this, DoLookupLessThan(key));
+    }
+
+    bool IsEmpty() const {
+        return (!m_buf || GetHeader()->count == 0);
+    }
+
+    uint64_t size() const {
+        return m_buf ? GetHeader()->count : 0;
+    }
+
+    Iterator GetBeginIterator() const {
+        if (!m_buf) {
+            return Iterator();
+        }
+        return Iterator(this, GetHeader()->forward[0]);
+    }
+
+    Iterator GetEndIterator() const {
+        return Iterator();
+    }
+
+    /** contents of the list. nullptr if nothing was inserted. */
+    const void* GetBuffer() const {
+        return m_buf;
+    }
+
+    uint64_t GetBufferSize() const {
+        return m_buf ? GetHeader()->used : 0;
+    }
+
+    /**
+       @brief replaces the contents with a copy of `data` got from
+       `GetBuffer()` of a list of the same type. the copy is checked so that
+       no link points outside of it, and the contents are unchanged if
+       `data` is corrupted. the order of keys is not checked: an unordered
+       buffer makes lookups return wrong results, but is still safe to use.
+    */
+    bool Load(const void* data, uint64_t size, std::string* errmsg = nullptr) {
+        auto header = (const Header*)data;
+        if (size < HEADER_SIZE || header->magic != MAGIC ||
+            header->value_size != sizeof(Value) ||
+            header->used < HEADER_SIZE || header->used > size) {
+            if (errmsg) {
+                *errmsg = "invalid compact skiplist data";
+            }
+            return false;
+        }
+
+        const uint64_t used = header->used;
+        auto buf = (char*)this->Alloc(used);
+        if (!buf) {
+            if (errmsg) {
+                *errmsg = "allocate buffer failed";
+            }
+            return false;
+        }
+        // checks the copy, which cannot be modified by others
+        memcpy(buf, data, used);
+
+        std::swap(m_buf, buf);
+        const uint64_t old_size = m_buf_size;
+        m_buf_size = used;
+        if (!Check()) {
+            std::swap(m_buf, buf);
+            m_buf_size = old_size;
+            this->DoFree(buf, used);
+            if (errmsg) {
+                *errmsg = "corrupted compact skiplist data";
+            }
+            return false;
+        }
+
+        if (buf) {
+            this->DoFree(buf, old_size);
+        }
+        return true;
+    }
+
+private:
+    Header* GetHeader() const {
+        return (Header*)m_buf;
+    }
+
+    Value* GetValue(uint32_t node) const {
+        return (Value*)(m_buf + (uint64_t)node * UNIT);
+    }
+
+    NodeMeta* GetNodeMeta(uint32_t node) const {
+        return (NodeMeta*)(m_buf + (uint64_t)node * UNIT + META_OFFSET);
+    }
+
+    /* node 0 is the header */
+    uint32_t* GetForward(uint32_t node) const {
+        return node ? GetNodeMeta(node)->forward : GetHeader()->forward;
+    }
+
+    void InitHeader() {
+        auto header = GetHeader();
+        memset(header, 0, HEADER_SIZE);
+        header->magic = MAGIC;
+        header->value_size = sizeof(Value);
+        header->used = HEADER_SIZE;
+    }
+
+    bool Reserve(uint64_t size) {
+        auto buf = (char*)this->Alloc(size);
+        if (!buf) {
+            return false;
+        }
+
+        if (m_buf) {
+            memcpy(buf, m_buf, GetHeader()->used);
+            this->DoFree(m_buf, m_buf_size);
+            m_buf = buf;
+        } else {
+            m_buf = buf;
+            InitHeader();
+        }
+        m_buf_size = size;
+        return true;
+    }
+
+    /* returns 0 if failed */
+    uint32_t AllocNode(uint32_t level) {
+        auto header = GetHeader();
+        auto node = header->free_list[level - 1];
+        if (node) {
+            header->free_list[level - 1] = GetNodeMeta(node)->forward[0];
+            return node;
+        }
+
+        const uint64_t node_size = GetNodeSize(level);
+        if (header->used + node_size > m_buf_size) {
+            uint64_t new_size = m_buf_size * 2;
+            if (new_size > MAX_BUFFER_SIZE) {
+                new_size = MAX_BUFFER_SIZE;
+            }
+            if (header->used + node_size > new_size || !Reserve(new_size)) {
+                return 0;
+            }
+            header = GetHeader();
+        }
+
+        node = header->used / UNIT;
+        header->used += node_size;
+        return node;
+    }
+
+    // ge_diff: the greater or equal diff value of the lastest comparison
+    uint32_t DoLookupLessThan(const Key& key, uint32_t* ge_diff = nullptr,
+                              uint32_t* update = nullptr) const {
+        uint32_t prev = 0;
+        for (uint32_t l = GetHeader()->level; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto node = GetForward(prev)[level];
+            while (node) {
+                uint32_t cur_diff = m_cmp(m_get_key(*GetValue(node)), key);
+                if (cur_diff & SKIPLIST_DIFF_GE) {
+                    if (ge_diff) {
+                        *ge_diff = cur_diff;
+                    }
+                    break;
+                }
+                prev = node;
+                node = GetNodeMeta(node)->forward[level];
+            }
+
+            if (update) {
+                update[level] = prev;
+            }
+        }
+
+        return prev;
+    }
+
+    uint32_t DoLookupGreaterEqual(const Key& key, uint32_t* ge_diff = nullptr,
+                                  uint32_t* update = nullptr) const {
+        auto node = DoLookupLessThan(key, ge_diff, update);
+        return GetForward(node)[0];
+    }
+
+    uint32_t GenRandomLevel() const {
+        uint32_t level = 1;
+        while (level < MAX_LEVEL && xoshiro256ss_next(&m_rand) % 4 == 0) {
+            ++level;
+        }
+        return level;
+    }
+
+    static uint64_t GetNodeSize(uint32_t level) {
+        return (META_OFFSET + sizeof(NodeMeta) + sizeof(uint32_t) * level +
+                UNIT - 1) &
+            ~(UNIT - 1);
+    }
+
+    /* nodes are laid out one by one in [HEADER_SIZE, used), which are
+     * scanned first. then every list and free list is walked, and each link
+     * MUST point to a node of enough levels. a node linked on level l + 1
+     * MUST also be linked on level l in the same order, so that a lookup
+     * going down from it stays in the lists, and freed nodes MUST NOT be
+     * linked. */
+    bool Check() const {
+        auto header = GetHeader();
+        const uint64_t used = header->used;
+        if (used % UNIT != 0 || used / UNIT > UINT32_MAX ||
+            header->level > MAX_LEVEL) {
+            return false;
+        }
+
+        // levels of nodes indexed by offsets in units, 0 if not a node
+        std::vector<uint8_t> levels(used / UNIT, 0);
+        uint64_t node_num = 0;
+        for (uint64_t offset = HEADER_SIZE; offset < used;) {
+            if (offset + META_OFFSET + sizeof(NodeMeta) > used) {
+                return false;
+            }
+            const uint32_t level = GetNodeMeta(offset / UNIT)->level;
+            if (level == 0 || level > MAX_LEVEL ||
+                offset + GetNodeSize(level) > used) {
+                return false;
+            }
+            levels[offset / UNIT] = level;
+            offset += GetNodeSize(level);
+            ++node_num;
+        }
+
+        // freed nodes are marked as non-nodes, so that they cannot be linked
+        // or freed twice
+        for (uint32_t level = 0; level < MAX_LEVEL; ++level) {
+            for (uint32_t node = header->free_list[level]; node;) {
+                if (node >= levels.size() || levels[node] != level + 1) {
+                    return false;
+                }
+                levels[node] = 0;
+                node = GetNodeMeta(node)->forward[0];
+            }
+        }
+
+        // 1-based positions of nodes in the list of the level below, 0 if
+        // not linked there
+        std::vector<uint32_t> lower_pos(levels.size(), 0);
+        std::vector<uint32_t> pos(levels.size(), 0);
+        for (uint32_t level = 0; level < MAX_LEVEL; ++level) {
+            uint32_t n = 0, last_lower_pos = 0;
+            for (uint32_t node = header->forward[level]; node;
+                 node = GetNodeMeta(node)->forward[level]) {
+                if (node >= levels.size() || levels[node] <= level ||
+                    ++n > node_num) {
+                    return false;
+                }
+                if (level > 0) {
+                    if (lower_pos[node] <= last_lower_pos) {
+                        return false;
+                    }
+                    last_lower_pos = lower_pos[node];
+                }
+                pos[node] = n;
+            }
+            if (level == 0 && n != header->count) {
+                return false;
+            }
+            lower_pos.swap(pos);
+            std::fill(pos.begin(), pos.end(), 0);
+        }
+        return true;
+    }
+
+private:
+    char* m_buf = nullptr;
+    uint64_t m_buf_size = 0;
+    Comparator m_cmp;
+    GetKeyFromValue m_get_key;
+    mutable Xoshiro256ss m_rand;
+
+private:
+    CompactSkipList(const CompactSkipList&) = delete;
+    CompactSkipList& operator=(const CompactSkipList&) = delete;
+};
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Allocator = GenericCpuAllocator>
+using CompactSkipListSet =
+    CompactSkipList<Value, Value, Comparator,
+                    internal::SkipListReturnSelfFromValue<Value>, Allocator>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Allocator = GenericCpuAllocator>
+using CompactSkipListMap =
+    CompactSkipList<Key, std::pair<Key, Value>, Comparator,
+                    internal::SkipListReturnFirstOfPair<Key, Value>,
+                    Allocator>;
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef __CPPUTILS_CSV_TOKENIZER_H__
+#define __CPPUTILS_CSV_TOKENIZER_H__
+
+#include <stdint.h>
+#include <string>
+
+namespace cpputils {
+
+struct CsvField final {
+    const char* data;
+    unsigned int size;
+    /* the field contains quotes and should be processed by `CsvUnescape()`.
+     * quotes around a field without escaped quotes are removed from `data`
+     * directly. */
+    bool need_unescape;
+    /* the last field of a record */
+    bool is_last;
+};
+
+/* removes quotes in a quoted field and replaces escaped quotes ("") with ". */
+void CsvUnescape(const char* data, unsigned int size, std::string* out,
+                 char quote = '"');
+
+/*
+  splits fields and records separated by `delim` and '\n' outside quotes. a
+  '\r' before '\n' is removed. fields refer to the input without copying.
+
+  the input is scanned in 64-byte blocks. for each block, bitmasks of quotes and
+  separators are computed, and quoted areas are found by the prefix xor of the
+  quote mask.
+*/
+class CsvTokenizer final {
+public:
+    CsvTokenizer(char delim = ',', char quote = '"')
+        : m_delim(delim), m_quote(quote) {}
+
+    CsvTokenizer(const char* s, unsigned int l, char delim = ',',
+                 char quote = '"')
+        : m_delim(delim), m_quote(quote) {
+        Reset(s, l);
+    }
+
+    void Reset(const char* s, unsigned int l);
+
+    /* returns false if there are no more fields */
+    bool Next(CsvField* field);
+
+private:
+    void LoadBlock();
+    void SetField(unsigned int begin, unsigned int end, bool is_last,
+                  CsvField* field) const;
+
+private:
+    const char m_delim;
+    const char m_quote;
+
+    const char* m_text = nullptr;
+    unsigned int m_len = 0;
+    unsigned int m_field_begin = 1; // > m_len means end
+    bool m_after_delim = false;
+
+    uint64_t m_block_begin = 0;
+    uint64_t m_block_end = 0;
+    uint64_t m_sep_mask = 0; // separators not yet returned in current block
+    uint64_t m_quote_mask = 0; // quotes in current block
+    uint64_t m_in_quote = 0; // all ones if the last block ends in quotes
+};
+
+}
+
+#endif
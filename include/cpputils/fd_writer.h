@@ -0,0 +1,54 @@
+#ifndef __CPPUTILS_FD_WRITER_H__
+#define __CPPUTILS_FD_WRITER_H__
+
+#ifndef _MSC_VER
+
+#include <stdint.h>
+
+namespace cpputils {
+
+/**
+   batches small writes to a file descriptor in a fixed-size buffer. a write
+   that doesn't fit is sent with the buffered data by one `writev()`. can be
+   used as a `StringReplacer::Sink` by a lambda calling `Write()`.
+*/
+class FdWriter final {
+public:
+    static constexpr uint32_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+public:
+    /** `fd` is not owned. */
+    FdWriter(int fd, uint32_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    /** flushes and ignores errors. */
+    ~FdWriter();
+
+    /** returns false with `errno` set on failure. */
+    bool Write(const char* data, uint64_t len);
+    bool Flush();
+
+    /** returns the number of bytes written to `fd`, excluding buffered ones. */
+    uint64_t GetWrittenSize() const {
+        return m_written;
+    }
+
+private:
+    bool WriteAll(const char* data, uint64_t len);
+
+private:
+    const int m_fd;
+    const uint32_t m_capacity;
+    uint32_t m_size = 0;
+    uint64_t m_written = 0;
+    char* m_buf;
+
+private:
+    FdWriter(const FdWriter&) = delete;
+    FdWriter& operator=(const FdWriter&) = delete;
+};
+
+}
+
+#endif
+
+#endif
@@ -18,6 +18,9 @@ class FileMapping final {
 public:
     static constexpr uint32_t READ = 1;
     static constexpr uint32_t WRITE = 2;
+    /** changes are visible to other processes and written back to the file.
+     * views are always shared on windows. */
+    static constexpr uint32_t SHARED = 4;
 
 public:
     FileMapping() {}
@@ -30,7 +33,8 @@ public:
     void operator=(FileMapping&&);
 
     /**
-       @param permission MUST be one of: READ, WRITE or READ|WRITE
+       @param permission MUST be one of: READ, WRITE or READ|WRITE, optionally
+       with SHARED
        @param offset no alignment is required.
     */
     bool Init(const char* filename, uint32_t permission, uint64_t offset = 0,
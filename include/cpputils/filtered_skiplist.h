@@ -0,0 +1,243 @@
+#ifndef __CPPUTILS_FILTERED_SKIPLIST_H__
+#define __CPPUTILS_FILTERED_SKIPLIST_H__
+
+#include "cpputils/bloom_filter.h"
+#include "cpputils/flat_hash_map.h" // FlatHash
+#include "cpputils/skiplist.h"
+#include <atomic>
+
+namespace cpputils {
+
+struct FilterStats final {
+    uint64_t memory_bytes = 0;
+    uint64_t capacity = 0; // number of keys the filter is sized for
+    uint64_t lookups = 0;
+    uint64_t filtered = 0; // lookups answered by the filter only
+    /** lookups passing the filter but not found */
+    uint64_t false_positives = 0;
+    uint64_t rebuilds = 0;
+};
+
+/**
+   a `SkipList` with a bloom filter of its keys, so that `Lookup()` of a
+   missing key usually returns after reading one cache line instead of
+   descending the list. the filter grows with insertions, and is rebuilt from
+   the list after removals leave too many stale keys in it.
+
+   statistics are updated by relaxed loads and stores, which may lose counts
+   under concurrent lookups.
+*/
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Hash = internal::FlatHash<Key>,
+          typename Allocator = GenericCpuAllocator>
+class FilteredSkipList final {
+private:
+    static constexpr uint64_t MIN_FILTER_CAPACITY = 1024;
+
+public:
+    typedef SkipList<Key, Value, Comparator, GetKeyFromValue, Allocator> List;
+    typedef typename List::Iterator Iterator;
+
+public:
+    FilteredSkipList(uint32_t bits_per_key = BloomFilter::DEFAULT_BITS_PER_KEY)
+        : m_bits_per_key(bits_per_key) {
+        m_filter.Init(MIN_FILTER_CAPACITY, m_bits_per_key);
+    }
+
+    template <typename ValueType>
+    std::pair<Iterator, bool> Insert(ValueType&& value) {
+        return OnInsert(m_list.Insert(std::forward<ValueType>(value)));
+    }
+
+    template <typename... Args>
+    std::pair<Iterator, bool> Emplace(Args&&... args) {
+        return OnInsert(m_list.Emplace(std::forward<Args>(args)...));
+    }
+
+    template <typename KeyType, typename... Args>
+    std::pair<Iterator, bool> TryEmplace(KeyType&& key, Args&&... args) {
+        return OnInsert(m_list.TryEmplace(std::forward<KeyType>(key),
+                                          std::forward<Args>(args)...));
+    }
+
+    template <typename KeyType, typename MappedType>
+    std::pair<Iterator, bool> InsertOrAssign(KeyType&& key,
+                                             MappedType&& mapped) {
+        return OnInsert(
+            m_list.InsertOrAssign(std::forward<KeyType>(key),
+                                  std::forward<MappedType>(mapped)));
+    }
+
+    template <typename ValueType = Value>
+    bool Remove(const Key& key, ValueType* value = nullptr) {
+        if (!m_filter.MayContain(m_hash(key)) || !m_list.Remove(key, value)) {
+            return false;
+        }
+
+        --m_size;
+        ++m_stale;
+        // removed keys still set bits, which raise the false positive rate
+        if (m_stale > m_size / 2 && m_stale >= MIN_FILTER_CAPACITY / 4) {
+            RebuildFilter();
+        }
+        return true;
+    }
+
+    void Clear() {
+        m_list.Clear();
+        m_size = 0;
+        m_stale = 0;
+        m_filter.Clear();
+    }
+
+    Iterator Lookup(const Key& key) const {
+        Increase(&m_lookups);
+        if (!m_filter.MayContain(m_hash(key))) {
+            Increase(&m_filtered);
+            return m_list.GetEndIterator();
+        }
+
+        auto it = m_list.Lookup(key);
+        if (it == m_list.GetEndIterator()) {
+            Increase(&m_false_positives);
+        }
+        return it;
+    }
+
+    Iterator LookupGreaterEqual(const Key& key) const {
+        return m_list.LookupGreaterEqual(key);
+    }
+
+    template <typename KeyType,
+              typename = internal::SkipListEnableIfTransparent<Comparator,
+                                                               KeyType>>
+    Iterator LookupGreaterEqual(const KeyType& key) const {
+        return m_list.LookupGreaterEqual(key);
+    }
+
+    Iterator LookupLessThan(const Key& key) const {
+        return m_list.LookupLessThan(key);
+    }
+
+    template <typename KeyType,
+              typename = internal::SkipListEnableIfTransparent<Comparator,
+                                                               KeyType>>
+    Iterator LookupLessThan(const KeyType& key) const {
+        return m_list.LookupLessThan(key);
+    }
+
+    bool IsEmpty() const {
+        return m_list.IsEmpty();
+    }
+
+    uint64_t size() const {
+        return m_size;
+    }
+
+    Iterator GetBeginIterator() const {
+        return m_list.GetBeginIterator();
+    }
+
+    Iterator GetEndIterator() const {
+        return m_list.GetEndIterator();
+    }
+
+    const List& GetList() const {
+        return m_list;
+    }
+
+    /** resizes the filter for the current keys and removes stale ones. */
+    bool RebuildFilter() {
+        uint64_t capacity = m_size * 2;
+        if (capacity < MIN_FILTER_CAPACITY) {
+            capacity = MIN_FILTER_CAPACITY;
+        }
+        if (!m_filter.Init(capacity, m_bits_per_key)) {
+            return false;
+        }
+
+        for (auto it = m_list.GetBeginIterator();
+             it != m_list.GetEndIterator(); ++it) {
+            m_filter.Add(m_hash(m_get_key(*it)));
+        }
+        m_stale = 0;
+        ++m_rebuilds;
+        return true;
+    }
+
+    FilterStats GetFilterStats() const {
+        FilterStats stats;
+        stats.memory_bytes = m_filter.GetMemoryUsage();
+        stats.capacity = m_filter.GetCapacity();
+        stats.lookups = m_lookups.load(std::memory_order_relaxed);
+        stats.filtered = m_filtered.load(std::memory_order_relaxed);
+        stats.false_positives =
+            m_false_positives.load(std::memory_order_relaxed);
+        stats.rebuilds = m_rebuilds;
+        return stats;
+    }
+
+    void ResetFilterStats() {
+        m_lookups.store(0, std::memory_order_relaxed);
+        m_filtered.store(0, std::memory_order_relaxed);
+        m_false_positives.store(0, std::memory_order_relaxed);
+        m_rebuilds = 0;
+    }
+
+private:
+    static void Increase(std::atomic<uint64_t>* counter) {
+        counter->store(counter->load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    }
+
+    std::pair<Iterator, bool> OnInsert(std::pair<Iterator, bool> ret) {
+        if (ret.second) {
+            ++m_size;
+            // keeps the old filter if there is no memory for a larger one
+            if (m_size + m_stale <= m_filter.GetCapacity() ||
+                !RebuildFilter()) {
+                m_filter.Add(m_hash(m_get_key(*ret.first)));
+            }
+        }
+        return ret;
+    }
+
+private:
+    List m_list;
+    BloomFilter m_filter;
+    const uint32_t m_bits_per_key;
+    uint64_t m_size = 0;
+    uint64_t m_stale = 0; // removed keys still in the filter
+    uint64_t m_rebuilds = 0;
+    mutable std::atomic<uint64_t> m_lookups{0};
+    mutable std::atomic<uint64_t> m_filtered{0};
+    mutable std::atomic<uint64_t> m_false_positives{0};
+    Hash m_hash;
+    GetKeyFromValue m_get_key;
+
+private:
+    FilteredSkipList(const FilteredSkipList&) = delete;
+    FilteredSkipList& operator=(const FilteredSkipList&) = delete;
+};
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Hash = internal::FlatHash<Value>,
+          typename Allocator = GenericCpuAllocator>
+using FilteredSkipListSet =
+    FilteredSkipList<Value, Value, Comparator,
+                     internal::SkipListReturnSelfFromValue<Value>, Hash,
+                     Allocator>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Hash = internal::FlatHash<Key>,
+          typename Allocator = GenericCpuAllocator>
+using FilteredSkipListMap =
+    FilteredSkipList<Key, std::pair<Key, Value>, Comparator,
+                     internal::SkipListReturnFirstOfPair<Key, Value>, Hash,
+                     Allocator>;
+
+}
+
+#endif
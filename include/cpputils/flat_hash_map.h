@@ -0,0 +1,457 @@
+#ifndef __CPPUTILS_FLAT_HASH_MAP_H__
+#define __CPPUTILS_FLAT_HASH_MAP_H__
+
+#include "cpputils/bit_utils.h"
+#include "cpputils/skiplist.h" // SkipListReturn*
+#include "cpputils/string_utils.h" // StringHash
+#include <functional>
+#include <string>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace cpputils {
+
+namespace internal {
+
+static constexpr uint32_t FLAT_HASH_GROUP_SIZE = 16;
+static constexpr int8_t FLAT_HASH_EMPTY = -128;
+static constexpr int8_t FLAT_HASH_DELETED = -2;
+
+/* bit i is set if ctrl[i] == c */
+static inline uint32_t FlatHashMatch(const int8_t* ctrl, int8_t c) {
+#ifdef __SSE2__
+    auto group = _mm_loadu_si128((const __m128i*)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(c)));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < FLAT_HASH_GROUP_SIZE; ++i) {
+        mask |= (uint32_t)(ctrl[i] == c) << i;
+    }
+    return mask;
+#endif
+}
+
+/* bit i is set if ctrl[i] is empty or deleted, i.e. negative */
+static inline uint32_t FlatHashMatchFree(const int8_t* ctrl) {
+#ifdef __SSE2__
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < FLAT_HASH_GROUP_SIZE; ++i) {
+        mask |= (uint32_t)(ctrl[i] < 0) << i;
+    }
+    return mask;
+#endif
+}
+
+/* `std::hash` of integers is usually the identity, so its result is mixed by
+ * the finalizer of murmur3 to make both the low and high bits usable. */
+template <typename Key>
+struct FlatHash final {
+    uint64_t operator()(const Key& key) const {
+        uint64_t h = std::hash<Key>()(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+template <>
+struct FlatHash<std::string> final {
+    uint64_t operator()(const std::string& key) const {
+        return StringHash(key.data(), key.size());
+    }
+};
+
+}
+
+/**
+   an open-addressing hash table in the layout of SwissTable: one control byte
+   per slot holds 7 bits of the hash, and 16 of them are matched at a time with
+   SSE2. the load factor is at most 7/8.
+
+   `Hash` has the form of `uint64_t func(const Key&)`, and `Equal` has the form
+   of `bool func(const Key&, const Key&)`. memory comes from `Allocator` like
+   `SkipList`. iterators and pointers to values are invalidated by insertions
+   that grow the table.
+*/
+template <typename Key, typename Value, typename Hash, typename Equal,
+          typename GetKeyFromValue, typename Allocator>
+class FlatHashTable final : public Allocator {
+public:
+    class Iterator final {
+    public:
+        Value* operator->() {
+            return &m_table->m_slots[m_idx];
+        }
+        const Value* operator->() const {
+            return &m_table->m_slots[m_idx];
+        }
+        Value& operator*() {
+            return m_table->m_slots[m_idx];
+        }
+        const Value& operator*() const {
+            return m_table->m_slots[m_idx];
+        }
+        bool operator==(const Iterator& it) const {
+            return (m_idx == it.m_idx);
+        }
+        bool operator!=(const Iterator& it) const {
+            return (m_idx != it.m_idx);
+        }
+        void operator++() {
+            m_idx = m_table->SkipFree(m_idx + 1);
+        }
+
+    private:
+        friend class FlatHashTable;
+        Iterator(const FlatHashTable* table, uint64_t idx)
+            : m_table(table), m_idx(idx) {}
+
+    private:
+        const FlatHashTable* m_table;
+        uint64_t m_idx;
+    };
+
+public:
+    FlatHashTable() {}
+
+    ~FlatHashTable() {
+        DoDestroy();
+    }
+
+    /** memory of `other` is moved along with its allocator. */
+    FlatHashTable(FlatHashTable&& other) : Allocator(std::move(other)) {
+        DoMove(&other);
+    }
+
+    FlatHashTable& operator=(FlatHashTable&& other) {
+        if (&other != this) {
+            DoDestroy();
+            Allocator::operator=(std::move(other));
+            DoMove(&other);
+        }
+        return *this;
+    }
+
+    std::pair<Iterator, bool> Insert(const Value& value) {
+        return DoInsert(m_get_key(value), value);
+    }
+
+    std::pair<Iterator, bool> Insert(Value&& value) {
+        return DoInsert(m_get_key(value), std::move(value));
+    }
+
+    /** constructs a temporary value to get its key. */
+    template <typename... Args>
+    std::pair<Iterator, bool> Emplace(Args&&... args) {
+        Value value(std::forward<Args>(args)...);
+        return DoInsert(m_get_key(value), std::move(value));
+    }
+
+    /**
+       @brief for maps only. constructs the value as `{key, mapped(args...)}`
+       only if `key` does not exist.
+    */
+    template <typename... Args>
+    std::pair<Iterator, bool> TryEmplace(const Key& key, Args&&... args) {
+        return DoInsert(key, std::piecewise_construct,
+                        std::forward_as_tuple(key),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /**
+       @brief for maps only. assigns `mapped` to the existing value of `key`,
+       or inserts `{key, mapped}`. the second of the returned value is true if
+       inserted.
+    */
+    template <typename MappedType>
+    std::pair<Iterator, bool> InsertOrAssign(const Key& key,
+                                             MappedType&& mapped) {
+        auto ret = DoInsert(key, key, std::forward<MappedType>(mapped));
+        if (!ret.second && ret.first != GetEndIterator()) {
+            ret.first->second = std::forward<MappedType>(mapped);
+        }
+        return ret;
+    }
+
+    template <typename ValueType = Value>
+    bool Remove(const Key& key, ValueType* value = nullptr) {
+        if (m_size == 0) {
+            return false;
+        }
+
+        const uint64_t idx = Find(key, m_hash(key));
+        if (idx == m_capacity) {
+            return false;
+        }
+
+        if (value) {
+            *value = std::move(m_slots[idx]);
+        }
+        m_slots[idx].~Value();
+        SetCtrl(idx, internal::FLAT_HASH_DELETED);
+        --m_size;
+        return true;
+    }
+
+    Iterator Lookup(const Key& key) const {
+        if (m_size == 0) {
+            return GetEndIterator();
+        }
+        return Iterator(this, Find(key, m_hash(key)));
+    }
+
+    void Clear() {
+        DoDestroy();
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_size = 0;
+        m_growth_left = 0;
+    }
+
+    /** makes room for `n` values without rehashing. */
+    bool Reserve(uint64_t n) {
+        uint64_t capacity = internal::FLAT_HASH_GROUP_SIZE;
+        while (GetMaxLoad(capacity) < n) {
+            capacity <<= 1;
+        }
+        if (capacity <= m_capacity) {
+            return true;
+        }
+        return Rehash(capacity);
+    }
+
+    uint64_t size() const {
+        return m_size;
+    }
+
+    uint64_t GetCapacity() const {
+        return m_capacity;
+    }
+
+    bool IsEmpty() const {
+        return (m_size == 0);
+    }
+
+    Iterator GetBeginIterator() const {
+        return Iterator(this, SkipFree(0));
+    }
+
+    Iterator GetEndIterator() const {
+        return Iterator(this, m_capacity);
+    }
+
+private:
+    static uint64_t GetMaxLoad(uint64_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    static uint64_t GetCtrlSize(uint64_t capacity) {
+        // the first group is mirrored after the last slot for unaligned loads
+        const uint64_t align = alignof(Value);
+        return (capacity + internal::FLAT_HASH_GROUP_SIZE + align - 1) &
+            ~(align - 1);
+    }
+
+    static uint64_t GetMemSize(uint64_t capacity) {
+        return GetCtrlSize(capacity) + sizeof(Value) * capacity;
+    }
+
+    static constexpr uint64_t GetMemAlignment() {
+        return (alignof(Value) > internal::FLAT_HASH_GROUP_SIZE)
+            ? alignof(Value)
+            : internal::FLAT_HASH_GROUP_SIZE;
+    }
+
+    static int8_t GetH2(uint64_t hash) {
+        return hash & 0x7f;
+    }
+
+    void SetCtrl(uint64_t idx, int8_t c) {
+        m_ctrl[idx] = c;
+        if (idx < internal::FLAT_HASH_GROUP_SIZE) {
+            m_ctrl[m_capacity + idx] = c;
+        }
+    }
+
+    /* returns the index of the first full slot since `idx`, or `m_capacity` */
+    uint64_t SkipFree(uint64_t idx) const {
+        while (idx < m_capacity && m_ctrl[idx] < 0) {
+            ++idx;
+        }
+        return idx;
+    }
+
+    /* groups are probed in triangular numbers, which visits every group */
+    uint64_t Find(const Key& key, uint64_t hash) const {
+        const uint64_t mask = m_capacity - 1;
+        const int8_t h2 = GetH2(hash);
+        uint64_t pos = (hash >> 7) & mask;
+        for (uint64_t step = 0;;) {
+            const int8_t* group = m_ctrl + pos;
+            uint32_t match = internal::FlatHashMatch(group, h2);
+            while (match) {
+                const uint64_t idx =
+                    (pos + internal::CountTrailingZeros(match)) & mask;
+                if (m_equal(m_get_key(m_slots[idx]), key)) {
+                    return idx;
+                }
+                match &= match - 1;
+            }
+            if (internal::FlatHashMatch(group, internal::FLAT_HASH_EMPTY)) {
+                return m_capacity;
+            }
+            step += internal::FLAT_HASH_GROUP_SIZE;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    /* returns the first empty or deleted slot for `hash` */
+    uint64_t FindFree(uint64_t hash) const {
+        const uint64_t mask = m_capacity - 1;
+        uint64_t pos = (hash >> 7) & mask;
+        for (uint64_t step = 0;;) {
+            const uint32_t match = internal::FlatHashMatchFree(m_ctrl + pos);
+            if (match) {
+                return (pos + internal::CountTrailingZeros(match)) & mask;
+            }
+            step += internal::FLAT_HASH_GROUP_SIZE;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    template <typename... Args>
+    std::pair<Iterator, bool> DoInsert(const Key& key, Args&&... args) {
+        const uint64_t hash = m_hash(key);
+        if (m_size > 0) {
+            const uint64_t idx = Find(key, hash);
+            if (idx != m_capacity) {
+                return std::pair<Iterator, bool>(Iterator(this, idx), false);
+            }
+        }
+
+        uint64_t idx = (m_capacity > 0) ? FindFree(hash) : 0;
+        if (m_capacity == 0 ||
+            (m_growth_left == 0 && m_ctrl[idx] == internal::FLAT_HASH_EMPTY)) {
+            // rehashes in place if more than half of the used are deleted
+            uint64_t capacity = internal::FLAT_HASH_GROUP_SIZE;
+            if (m_capacity > 0) {
+                capacity = (m_size * 2 > GetMaxLoad(m_capacity))
+                    ? m_capacity * 2
+                    : m_capacity;
+            }
+            if (!Rehash(capacity)) {
+                return std::pair<Iterator, bool>(GetEndIterator(), false);
+            }
+            idx = FindFree(hash);
+        }
+
+        new (&m_slots[idx]) Value(std::forward<Args>(args)...);
+        if (m_ctrl[idx] == internal::FLAT_HASH_EMPTY) {
+            --m_growth_left;
+        }
+        SetCtrl(idx, GetH2(hash));
+        ++m_size;
+        return std::pair<Iterator, bool>(Iterator(this, idx), true);
+    }
+
+    bool Rehash(uint64_t capacity) {
+        auto mem =
+            (char*)this->DoAlloc(GetMemSize(capacity), GetMemAlignment());
+        if (!mem) {
+            return false;
+        }
+
+        auto old_ctrl = m_ctrl;
+        auto old_slots = m_slots;
+        const uint64_t old_capacity = m_capacity;
+
+        m_ctrl = (int8_t*)mem;
+        m_slots = (Value*)(mem + GetCtrlSize(capacity));
+        m_capacity = capacity;
+        m_growth_left = GetMaxLoad(capacity) - m_size;
+        memset(m_ctrl, internal::FLAT_HASH_EMPTY,
+               capacity + internal::FLAT_HASH_GROUP_SIZE);
+
+        for (uint64_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                auto value = &old_slots[i];
+                const uint64_t hash = m_hash(m_get_key(*value));
+                const uint64_t idx = FindFree(hash);
+                new (&m_slots[idx]) Value(std::move(*value));
+                value->~Value();
+                SetCtrl(idx, GetH2(hash));
+            }
+        }
+
+        if (old_ctrl) {
+            this->DoFree(old_ctrl, GetMemSize(old_capacity));
+        }
+        return true;
+    }
+
+    void DoDestroy() {
+        if (!m_ctrl) {
+            return;
+        }
+        for (uint64_t i = 0; i < m_capacity; ++i) {
+            if (m_ctrl[i] >= 0) {
+                m_slots[i].~Value();
+            }
+        }
+        this->DoFree(m_ctrl, GetMemSize(m_capacity));
+    }
+
+    void DoMove(FlatHashTable* other) {
+        m_ctrl = other->m_ctrl;
+        m_slots = other->m_slots;
+        m_capacity = other->m_capacity;
+        m_size = other->m_size;
+        m_growth_left = other->m_growth_left;
+        other->m_ctrl = nullptr;
+        other->m_slots = nullptr;
+        other->m_capacity = 0;
+        other->m_size = 0;
+        other->m_growth_left = 0;
+    }
+
+private:
+    int8_t* m_ctrl = nullptr;
+    Value* m_slots = nullptr;
+    uint64_t m_capacity = 0; // 0 or a power of 2 >= FLAT_HASH_GROUP_SIZE
+    uint64_t m_size = 0;
+    uint64_t m_growth_left = 0; // empty slots that can be used before rehash
+    Hash m_hash;
+    Equal m_equal;
+    GetKeyFromValue m_get_key;
+
+private:
+    FlatHashTable(const FlatHashTable&) = delete;
+    FlatHashTable& operator=(const FlatHashTable&) = delete;
+};
+
+template <typename Value, typename Hash = internal::FlatHash<Value>,
+          typename Equal = std::equal_to<Value>,
+          typename Allocator = GenericCpuAllocator>
+using FlatHashSet =
+    FlatHashTable<Value, Value, Hash, Equal,
+                  internal::SkipListReturnSelfFromValue<Value>, Allocator>;
+
+template <typename Key, typename Value,
+          typename Hash = internal::FlatHash<Key>,
+          typename Equal = std::equal_to<Key>,
+          typename Allocator = GenericCpuAllocator>
+using FlatHashMap =
+    FlatHashTable<Key, std::pair<Key, Value>, Hash, Equal,
+                  internal::SkipListReturnFirstOfPair<Key, Value>, Allocator>;
+
+}
+
+#endif
@@ -0,0 +1,408 @@
+#ifndef __CPPUTILS_FROZEN_INDEX_H__
+#define __CPPUTILS_FROZEN_INDEX_H__
+
+#include "cpputils/bit_utils.h"
+#include "cpputils/file_mapping.h"
+#include "cpputils/skiplist.h"
+#include <cerrno>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+namespace cpputils {
+
+/*
+  an immutable snapshot of sorted values in the Eytzinger layout, i.e. a
+  complete binary search tree stored in BFS order: node k has children 2k and
+  2k + 1. the top levels of the tree share a few cache lines, and the nodes a
+  search visits next are prefetched, so lookups are much faster than those of
+  `SkipList` on large read-only data.
+
+  the snapshot is one contiguous buffer, which can be written to a file and
+  opened by `FileMapping` without copying. `Value` MUST be trivially copyable
+  and the file can only be read on machines of the same byte order.
+  `Comparator` is the same as `SkipList`.
+*/
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Allocator>
+class FrozenIndex final : public Allocator {
+private:
+    static constexpr uint32_t MAGIC = 0x495a5246; // "FRZI"
+
+    static_assert(std::is_trivially_copy_constructible<Value>::value &&
+                      std::is_trivially_destructible<Value>::value,
+                  "`Value` MUST be trivially copyable.");
+
+    struct Header final {
+        uint32_t magic;
+        uint32_t value_size;
+        uint64_t count;
+    };
+
+    /* values start at a cache line boundary of a mapped file */
+    static constexpr uint64_t HEADER_SIZE = 64;
+    static_assert(alignof(Value) <= HEADER_SIZE,
+                  "alignment of `Value` is too large.");
+
+    template <typename KeyType>
+    using EnableIfTransparent =
+        internal::SkipListEnableIfTransparent<Comparator, KeyType>;
+
+    /* descendants of node k some levels below, i.e. [k * stride, (k + 1) *
+     * stride), are about one cache line and prefetched together */
+    static constexpr uint64_t PREFETCH_STRIDE =
+        (sizeof(Value) <= 4) ? 16 :
+        (sizeof(Value) <= 8) ? 8 :
+        (sizeof(Value) <= 16) ? 4 :
+        (sizeof(Value) <= 32) ? 2 : 1;
+
+public:
+    class Iterator final {
+    public:
+        const Value* operator->() const {
+            return &m_index->m_values[m_node];
+        }
+        const Value& operator*() const {
+            return m_index->m_values[m_node];
+        }
+        bool operator==(const Iterator& it) const {
+            return (m_node == it.m_node);
+        }
+        bool operator!=(const Iterator& it) const {
+            return (m_node != it.m_node);
+        }
+        void operator++() {
+            m_node = m_index->GetNext(m_node);
+        }
+
+    private:
+        friend class FrozenIndex;
+        Iterator(const FrozenIndex* index = nullptr, uint64_t node = 0)
+            : m_index(index), m_node(node) {}
+
+    private:
+        const FrozenIndex* m_index;
+        uint64_t m_node; // 0 is the end
+    };
+
+public:
+    FrozenIndex() {}
+
+    ~FrozenIndex() {
+        Destroy();
+    }
+
+    /**
+       @brief replaces the contents with values in [begin, end), which MUST be
+       sorted by `Comparator`.
+    */
+    template <typename InputIterator>
+    bool Build(InputIterator begin, InputIterator end,
+               std::string* errmsg = nullptr) {
+        uint64_t count = 0;
+        for (auto it = begin; it != end; ++it) {
+            ++count;
+        }
+
+        const uint64_t size = HEADER_SIZE + sizeof(Value) * (count + 1);
+        auto buf = (char*)this->DoAlloc(size, HEADER_SIZE);
+        if (!buf) {
+            if (errmsg) {
+                *errmsg = "allocate buffer failed";
+            }
+            return false;
+        }
+
+        Destroy();
+        m_buf = buf;
+        m_buf_size = size;
+        m_count = count;
+        auto values = (Value*)(buf + HEADER_SIZE);
+        m_values = values;
+
+        auto header = (Header*)buf;
+        memset(header, 0, HEADER_SIZE);
+        header->magic = MAGIC;
+        header->value_size = sizeof(Value);
+        header->count = count;
+        memset((void*)values, 0, sizeof(Value)); // the unused node 0
+
+        // an in-order traversal of the tree visits values in sorted order
+        uint64_t node = GetFirst();
+        for (auto it = begin; it != end; ++it) {
+            new (&values[node]) Value(*it);
+            node = GetNext(node);
+        }
+        return true;
+    }
+
+    bool WriteToFile(const char* filename,
+                     std::string* errmsg = nullptr) const {
+        auto fp = fopen(filename, "wb");
+        if (!fp) {
+            if (errmsg) {
+                *errmsg = "open [" + std::string(filename) +
+                    "] failed: " + strerror(errno);
+            }
+            return false;
+        }
+
+        const uint64_t size = GetBufferSize();
+        bool ok = (fwrite(GetBuffer(), 1, size, fp) == size);
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok && errmsg) {
+            *errmsg = "write [" + std::string(filename) +
+                "] failed: " + strerror(errno);
+        }
+        return ok;
+    }
+
+    /** maps `filename` written by `WriteToFile()` without copying. */
+    bool Open(const char* filename, std::string* errmsg = nullptr) {
+        FileMapping fm;
+        if (!fm.Init(filename, FileMapping::READ, 0, UINT64_MAX, errmsg)) {
+            return false;
+        }
+        if (!Check(fm.data(), fm.size(), errmsg)) {
+            return false;
+        }
+
+        Destroy();
+        m_fm = std::move(fm);
+        Attach((const char*)m_fm.data());
+        return true;
+    }
+
+    /** replaces the contents with a copy of `data` got from `GetBuffer()` of
+     * an index of the same type. */
+    bool Load(const void* data, uint64_t size, std::string* errmsg = nullptr) {
+        if (!Check(data, size, errmsg)) {
+            return false;
+        }
+
+        size = HEADER_SIZE + sizeof(Value) * (((Header*)data)->count + 1);
+        auto buf = (char*)this->DoAlloc(size, HEADER_SIZE);
+        if (!buf) {
+            if (errmsg) {
+                *errmsg = "allocate buffer failed";
+            }
+            return false;
+        }
+        memcpy(buf, data, size);
+
+        Destroy();
+        m_buf = buf;
+        m_buf_size = size;
+        Attach(buf);
+        return true;
+    }
+
+    Iterator Lookup(const Key& key) const {
+        return DoLookup(key);
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator Lookup(const KeyType& key) const {
+        return DoLookup(key);
+    }
+
+    Iterator LookupGreaterEqual(const Key& key) const {
+        return Iterator(this, LowerBound(key));
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator LookupGreaterEqual(const KeyType& key) const {
+        return Iterator(this, LowerBound(key));
+    }
+
+    Iterator LookupLessThan(const Key& key) const {
+        return DoLookupLessThan(key);
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator LookupLessThan(const KeyType& key) const {
+        return DoLookupLessThan(key);
+    }
+
+    bool IsEmpty() const {
+        return (m_count == 0);
+    }
+
+    uint64_t size() const {
+        return m_count;
+    }
+
+    Iterator GetBeginIterator() const {
+        return Iterator(this, GetFirst());
+    }
+
+    Iterator GetEndIterator() const {
+        return Iterator();
+    }
+
+    /** contents of the index. nullptr if not built. */
+    const void* GetBuffer() const {
+        return m_values ? (const char*)m_values - HEADER_SIZE : nullptr;
+    }
+
+    uint64_t GetBufferSize() const {
+        return m_values ? HEADER_SIZE + sizeof(Value) * (m_count + 1) : 0;
+    }
+
+private:
+    bool Check(const void* data, uint64_t size, std::string* errmsg) const {
+        auto header = (const Header*)data;
+        if (!data || size < HEADER_SIZE || header->magic != MAGIC ||
+            header->value_size != sizeof(Value) ||
+            header->count >= (size - HEADER_SIZE) / sizeof(Value)) {
+            if (errmsg) {
+                *errmsg = "invalid frozen index data";
+            }
+            return false;
+        }
+        return true;
+    }
+
+    void Attach(const char* buf) {
+        m_count = ((const Header*)buf)->count;
+        m_values = (Value*)(buf + HEADER_SIZE);
+    }
+
+    void Destroy() {
+        if (m_buf) {
+            this->DoFree(m_buf, m_buf_size);
+            m_buf = nullptr;
+            m_buf_size = 0;
+        }
+        m_fm.Destroy();
+        m_values = nullptr;
+        m_count = 0;
+    }
+
+    /* returns the first node >= `key`, or 0 if not found. */
+    template <typename KeyType>
+    Iterator DoLookup(const KeyType& key) const {
+        const uint64_t node = LowerBound(key);
+        if (node &&
+            m_cmp(m_get_key(m_values[node]), key) == SKIPLIST_DIFF_EQ) {
+            return Iterator(this, node);
+        }
+        return Iterator();
+    }
+
+    template <typename KeyType>
+    Iterator DoLookupLessThan(const KeyType& key) const {
+        const uint64_t node = LowerBound(key);
+        return Iterator(this, node ? GetPrev(node) : GetLast());
+    }
+
+    template <typename KeyType>
+    uint64_t LowerBound(const KeyType& key) const {
+        uint64_t node = 1;
+        while (node <= m_count) {
+            internal::Prefetch(m_values + node * PREFETCH_STRIDE);
+            node = 2 * node +
+                (m_cmp(m_get_key(m_values[node]), key) == SKIPLIST_DIFF_LT);
+        }
+        // goes back to the last node where the search turned left
+        return node >> (internal::CountTrailingZeros(~node) + 1);
+    }
+
+    uint64_t GetFirst() const {
+        if (m_count == 0) {
+            return 0;
+        }
+        uint64_t node = 1;
+        while (2 * node <= m_count) {
+            node = 2 * node;
+        }
+        return node;
+    }
+
+    uint64_t GetLast() const {
+        if (m_count == 0) {
+            return 0;
+        }
+        uint64_t node = 1;
+        while (2 * node + 1 <= m_count) {
+            node = 2 * node + 1;
+        }
+        return node;
+    }
+
+    /* the in-order successor, or 0 if `node` is the last one */
+    uint64_t GetNext(uint64_t node) const {
+        if (2 * node + 1 <= m_count) {
+            node = 2 * node + 1;
+            while (2 * node <= m_count) {
+                node = 2 * node;
+            }
+            return node;
+        }
+        // goes up until `node` is a left child
+        while (node & 1) {
+            node >>= 1;
+        }
+        return node >> 1;
+    }
+
+    /* the in-order predecessor, or 0 if `node` is the first one */
+    uint64_t GetPrev(uint64_t node) const {
+        if (2 * node <= m_count) {
+            node = 2 * node;
+            while (2 * node + 1 <= m_count) {
+                node = 2 * node + 1;
+            }
+            return node;
+        }
+        // goes up until `node` is a right child
+        while (node > 1 && !(node & 1)) {
+            node >>= 1;
+        }
+        return node >> 1;
+    }
+
+private:
+    char* m_buf = nullptr; // owned buffer, or nullptr if mapped
+    uint64_t m_buf_size = 0;
+    FileMapping m_fm;
+    const Value* m_values = nullptr; // node k is `m_values[k]`
+    uint64_t m_count = 0;
+    Comparator m_cmp;
+    GetKeyFromValue m_get_key;
+
+private:
+    FrozenIndex(const FrozenIndex&) = delete;
+    FrozenIndex& operator=(const FrozenIndex&) = delete;
+};
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Allocator = GenericCpuAllocator>
+using FrozenSet =
+    FrozenIndex<Value, Value, Comparator,
+                internal::SkipListReturnSelfFromValue<Value>, Allocator>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Allocator = GenericCpuAllocator>
+using FrozenMap =
+    FrozenIndex<Key, std::pair<Key, Value>, Comparator,
+                internal::SkipListReturnFirstOfPair<Key, Value>, Allocator>;
+
+/** builds `index` from values of `list` in order. */
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Allocator, bool AllowDuplicates,
+          uint32_t MaxLevel, uint32_t BranchingFactor, typename IndexAllocator>
+bool Freeze(const SkipList<Key, Value, Comparator, GetKeyFromValue, Allocator,
+                           AllowDuplicates, MaxLevel, BranchingFactor>& list,
+            FrozenIndex<Key, Value, Comparator, GetKeyFromValue,
+                        IndexAllocator>* index,
+            std::string* errmsg = nullptr) {
+    return index->Build(list.GetBeginIterator(), list.GetEndIterator(),
+                        errmsg);
+}
+
+}
+
+#endif
@@ -14,6 +14,30 @@ public:
     void Free(void* ptr) override {
         ::free(ptr);
     }
+
+    using Allocator::Alloc;
+    using Allocator::Free;
+
+protected:
+    /* calls libc directly rather than `Alloc()`/`Free()`, so that
+     * subclasses overriding them are not called twice. */
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override {
+        if (alignment <= alignof(std::max_align_t)) {
+            return ::malloc(bytes);
+        }
+#ifdef _MSC_VER
+        // memory returned by `_aligned_malloc()` cannot be passed to `free()`
+        return nullptr;
+#else
+        // `aligned_alloc()` requires `bytes` to be a multiple of `alignment`
+        return ::aligned_alloc(alignment,
+                               (bytes + alignment - 1) & ~(alignment - 1));
+#endif
+    }
+
+    void DoFree(void* ptr, uint64_t) override {
+        ::free(ptr);
+    }
 };
 
 }
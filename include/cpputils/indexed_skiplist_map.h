@@ -0,0 +1,173 @@
+#ifndef __CPPUTILS_INDEXED_SKIPLIST_MAP_H__
+#define __CPPUTILS_INDEXED_SKIPLIST_MAP_H__
+
+#include "cpputils/flat_hash_map.h"
+#include "cpputils/skiplist.h"
+
+namespace cpputils {
+
+namespace internal {
+
+template <typename Key, typename Value>
+struct IndexedSkipListReturnKeyOfPtr final {
+    const Key& operator()(std::pair<Key, Value>* const& p) const {
+        return p->first;
+    }
+};
+
+}
+
+/**
+   a `SkipListMap` for ordered operations with a `FlatHashTable` of pointers to
+   its values for point lookups in O(1). keys are stored only once in the list,
+   and the table costs one pointer per value.
+
+   values MUST NOT be modified through the list directly, e.g. by `Merge()`,
+   which would leave the table stale.
+*/
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Hash = internal::FlatHash<Key>,
+          typename Equal = std::equal_to<Key>,
+          typename Allocator = GenericCpuAllocator>
+class IndexedSkipListMap final {
+public:
+    typedef SkipListMap<Key, Value, Comparator, Allocator> List;
+    typedef typename List::Iterator Iterator;
+
+public:
+    /**
+       @brief inserts `value` if its key does not exist. the first of the
+       returned value points to the value with the same key, or is nullptr if
+       there is no memory.
+    */
+    std::pair<std::pair<Key, Value>*, bool>
+    Insert(const std::pair<Key, Value>& value) {
+        return DoInsert(value.first, value);
+    }
+
+    std::pair<std::pair<Key, Value>*, bool>
+    Insert(std::pair<Key, Value>&& value) {
+        return DoInsert(value.first, std::move(value));
+    }
+
+    /** constructs the value as `{key, mapped(args...)}` only if `key` does
+     * not exist. */
+    template <typename... Args>
+    std::pair<std::pair<Key, Value>*, bool> TryEmplace(const Key& key,
+                                                       Args&&... args) {
+        return DoInsert(key, std::piecewise_construct,
+                        std::forward_as_tuple(key),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+
+    /** assigns `mapped` to the existing value of `key`, or inserts
+     * `{key, mapped}`. */
+    template <typename MappedType>
+    std::pair<std::pair<Key, Value>*, bool> InsertOrAssign(
+        const Key& key, MappedType&& mapped) {
+        auto ret = DoInsert(key, key, std::forward<MappedType>(mapped));
+        if (!ret.second && ret.first) {
+            ret.first->second = std::forward<MappedType>(mapped);
+        }
+        return ret;
+    }
+
+    template <typename ValueType = std::pair<Key, Value>>
+    bool Remove(const Key& key, ValueType* value = nullptr) {
+        if (!m_index.Remove(key)) {
+            return false;
+        }
+        return m_list.Remove(key, value);
+    }
+
+    void Clear() {
+        m_index.Clear();
+        m_list.Clear();
+    }
+
+    /** point lookup in O(1). returns nullptr if not found. */
+    std::pair<Key, Value>* Find(const Key& key) const {
+        auto it = m_index.Lookup(key);
+        if (it == m_index.GetEndIterator()) {
+            return nullptr;
+        }
+        return *it;
+    }
+
+    Iterator LookupGreaterEqual(const Key& key) const {
+        return m_list.LookupGreaterEqual(key);
+    }
+
+    template <typename KeyType,
+              typename = internal::SkipListEnableIfTransparent<Comparator,
+                                                               KeyType>>
+    Iterator LookupGreaterEqual(const KeyType& key) const {
+        return m_list.LookupGreaterEqual(key);
+    }
+
+    Iterator LookupLessThan(const Key& key) const {
+        return m_list.LookupLessThan(key);
+    }
+
+    template <typename KeyType,
+              typename = internal::SkipListEnableIfTransparent<Comparator,
+                                                               KeyType>>
+    Iterator LookupLessThan(const KeyType& key) const {
+        return m_list.LookupLessThan(key);
+    }
+
+    Iterator GetBeginIterator() const {
+        return m_list.GetBeginIterator();
+    }
+
+    Iterator GetEndIterator() const {
+        return m_list.GetEndIterator();
+    }
+
+    uint64_t size() const {
+        return m_index.size();
+    }
+
+    bool IsEmpty() const {
+        return m_index.IsEmpty();
+    }
+
+    const List& GetList() const {
+        return m_list;
+    }
+
+private:
+    template <typename... Args>
+    std::pair<std::pair<Key, Value>*, bool> DoInsert(const Key& key,
+                                                     Args&&... args) {
+        auto it = m_index.Lookup(key);
+        if (it != m_index.GetEndIterator()) {
+            return std::make_pair(*it, false);
+        }
+
+        auto ret = m_list.Emplace(std::forward<Args>(args)...);
+        if (!ret.second) {
+            return std::pair<std::pair<Key, Value>*, bool>(nullptr, false);
+        }
+
+        auto pvalue = &(*ret.first);
+        if (!m_index.Insert(pvalue).second) {
+            // `key` may refer to the moved value
+            m_list.Remove(pvalue->first);
+            return std::pair<std::pair<Key, Value>*, bool>(nullptr, false);
+        }
+        return std::make_pair(pvalue, true);
+    }
+
+private:
+    List m_list;
+    FlatHashTable<Key, std::pair<Key, Value>*, Hash, Equal,
+                  internal::IndexedSkipListReturnKeyOfPtr<Key, Value>,
+                  Allocator>
+        m_index;
+};
+
+}
+
+#endif
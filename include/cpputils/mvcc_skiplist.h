@@ -0,0 +1,554 @@
+#ifndef __CPPUTILS_MVCC_SKIPLIST_H__
+#define __CPPUTILS_MVCC_SKIPLIST_H__
+
+#include "skiplist.h"
+#include <atomic>
+
+namespace cpputils {
+
+/*
+  a skiplist with one writer and concurrent readers taking point-in-time
+  snapshots.
+
+  every `Insert()`/`Remove()` advances a sequence number. a removed node stays
+  linked until no snapshot older than its removal is alive, then it is
+  unlinked, and it is freed after all snapshots which may still be positioned
+  on it are released.
+
+  `Insert()`, `Remove()`, `Lookup()` and `Reclaim()` MUST be called by the
+  writer thread only. `GetSnapshot()` can be called by any thread, and each
+  `Snapshot` can be used by one thread at a time. at most `MaxSnapshotNum`
+  snapshots can be alive at the same time.
+*/
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Allocator,
+          uint32_t MaxSnapshotNum = 64>
+class MvccSkipList final : public Allocator {
+private:
+    static constexpr uint32_t MAX_LEVEL = 12;
+    static constexpr uint64_t SEQ_MAX = UINT64_MAX;
+    /* a slot being registered blocks reclamation until its sequence is set */
+    static constexpr uint64_t SLOT_PENDING = 0;
+    static constexpr uint32_t RECLAIM_INTERVAL = 64;
+
+private:
+    struct DataNode final {
+        uint64_t insert_seq;
+        std::atomic<uint64_t> remove_seq; // `SEQ_MAX` if not removed
+        uint64_t unlink_seq;
+        DataNode* next_retired;
+        uint32_t level;
+        std::atomic<DataNode*> forward[0];
+    };
+
+    struct HeadNode final {
+        uint64_t insert_seq;
+        std::atomic<uint64_t> remove_seq;
+        uint64_t unlink_seq;
+        DataNode* next_retired;
+        uint32_t level;
+        std::atomic<DataNode*> forward[MAX_LEVEL];
+    };
+
+    /* the value is followed by `DataNode`, whose atomics MUST be aligned */
+    static constexpr uint64_t NODE_OFFSET =
+        (sizeof(Value) + alignof(DataNode) - 1) & ~(alignof(DataNode) - 1);
+    static constexpr uint64_t NODE_ALIGNMENT =
+        (alignof(Value) > alignof(DataNode)) ? alignof(Value)
+                                             : alignof(DataNode);
+
+    /* nodes in the same list are in the order of their sequence numbers */
+    struct RetiredList final {
+        DataNode* head = nullptr;
+        DataNode* tail = nullptr;
+
+        void PushBack(DataNode* node) {
+            node->next_retired = nullptr;
+            if (tail) {
+                tail->next_retired = node;
+            } else {
+                head = node;
+            }
+            tail = node;
+        }
+        DataNode* PopFront() {
+            auto node = head;
+            head = node->next_retired;
+            if (!head) {
+                tail = nullptr;
+            }
+            return node;
+        }
+    };
+
+public:
+    class Snapshot;
+
+    class Iterator final {
+    public:
+        const Value* operator->() const {
+            return GetValueFromNode(m_node);
+        }
+        const Value& operator*() const {
+            return *GetValueFromNode(m_node);
+        }
+        bool operator==(const Iterator& it) const {
+            return (m_node == it.m_node);
+        }
+        bool operator!=(const Iterator& it) const {
+            return (m_node != it.m_node);
+        }
+        void operator++() {
+            m_node = SkipInvisible(
+                m_node->forward[0].load(std::memory_order_acquire), m_seq);
+        }
+
+    private:
+        friend class MvccSkipList;
+        friend class Snapshot;
+        Iterator(DataNode* node = nullptr, uint64_t seq = 0)
+            : m_node(node), m_seq(seq) {}
+
+    private:
+        DataNode* m_node;
+        uint64_t m_seq;
+    };
+
+    /* releases itself when destroyed. */
+    class Snapshot final {
+    public:
+        Snapshot() : m_list(nullptr), m_slot(0), m_seq(0) {}
+        Snapshot(Snapshot&& s)
+            : m_list(s.m_list), m_slot(s.m_slot), m_seq(s.m_seq) {
+            s.m_list = nullptr;
+        }
+        Snapshot& operator=(Snapshot&& s) {
+            if (&s != this) {
+                Release();
+                m_list = s.m_list;
+                m_slot = s.m_slot;
+                m_seq = s.m_seq;
+                s.m_list = nullptr;
+            }
+            return *this;
+        }
+        ~Snapshot() {
+            Release();
+        }
+
+        /** returns false if there were too many snapshots. */
+        bool IsValid() const {
+            return (m_list != nullptr);
+        }
+
+        uint64_t GetSequence() const {
+            return m_seq;
+        }
+
+        void Release() {
+            if (m_list) {
+                m_list->m_slots[m_slot].store(SEQ_MAX);
+                m_list = nullptr;
+            }
+        }
+
+        Iterator GetBeginIterator() const {
+            return Iterator(
+                SkipInvisible(
+                    m_list->m_head.forward[0].load(std::memory_order_acquire),
+                    m_seq),
+                m_seq);
+        }
+
+        Iterator GetEndIterator() const {
+            return Iterator();
+        }
+
+        Iterator Lookup(const Key& key) const {
+            auto node = m_list->DoReadLookupGreaterEqual(key);
+            while (node) {
+                if (m_list->m_cmp(m_list->m_get_key(*GetValueFromNode(node)),
+                                  key) != SKIPLIST_DIFF_EQ) {
+                    break;
+                }
+                if (IsVisible(node, m_seq)) {
+                    return Iterator(node, m_seq);
+                }
+                node = node->forward[0].load(std::memory_order_acquire);
+            }
+            return Iterator();
+        }
+
+        Iterator LookupGreaterEqual(const Key& key) const {
+            return Iterator(
+                SkipInvisible(m_list->DoReadLookupGreaterEqual(key), m_seq),
+                m_seq);
+        }
+
+    private:
+        friend class MvccSkipList;
+        Snapshot(const MvccSkipList* list, uint32_t slot, uint64_t seq)
+            : m_list(list), m_slot(slot), m_seq(seq) {}
+
+    private:
+        const MvccSkipList* m_list;
+        uint32_t m_slot;
+        uint64_t m_seq;
+
+    private:
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+    };
+
+public:
+    MvccSkipList() {
+        xoshiro256ss_init(&m_rand, (uintptr_t)this);
+        m_head.level = 0;
+        for (uint32_t i = 0; i < MAX_LEVEL; ++i) {
+            m_head.forward[i].store(nullptr, std::memory_order_relaxed);
+        }
+        for (uint32_t i = 0; i < MaxSnapshotNum; ++i) {
+            m_slots[i].store(SEQ_MAX, std::memory_order_relaxed);
+        }
+        m_seq.store(0, std::memory_order_relaxed);
+    }
+
+    /** all snapshots MUST be released before. */
+    ~MvccSkipList() {
+        DataNode* cur = m_head.forward[0].load(std::memory_order_relaxed);
+        while (cur) {
+            auto next = cur->forward[0].load(std::memory_order_relaxed);
+            DestroyNode(cur);
+            cur = next;
+        }
+        while (m_unlinked.head) {
+            DestroyNode(m_unlinked.PopFront());
+        }
+    }
+
+    /** returns the value inserted or the existing one with the same key, and
+     * whether the insertion took place. the value is nullptr if allocation
+     * failed. */
+    template <typename ValueType>
+    std::pair<const Value*, bool> Insert(ValueType&& value) {
+        const Key& key = m_get_key(value);
+
+        DataNode* update[MAX_LEVEL];
+        auto node = DoWriteLookup(key, update);
+        if (node) {
+            return std::pair<const Value*, bool>(GetValueFromNode(node),
+                                                 false);
+        }
+
+        node = DoInsert(std::forward<ValueType>(value), update);
+        if (!node) {
+            return std::pair<const Value*, bool>(nullptr, false);
+        }
+        return std::pair<const Value*, bool>(GetValueFromNode(node), true);
+    }
+
+    /** the value is copied to `value` because snapshots may still see it. */
+    template <typename ValueType = Value>
+    bool Remove(const Key& key, ValueType* value = nullptr) {
+        auto node = DoWriteLookup(key);
+        if (!node) {
+            return false;
+        }
+
+        if (value) {
+            *value = *GetValueFromNode(node);
+        }
+
+        const uint64_t seq = m_seq.load(std::memory_order_relaxed) + 1;
+        node->remove_seq.store(seq, std::memory_order_release);
+        m_seq.store(seq);
+        m_removed.PushBack(node);
+
+        ++m_retired_num;
+        if (m_retired_num >= RECLAIM_INTERVAL) {
+            Reclaim();
+        }
+
+        return true;
+    }
+
+    /** returns the latest value with `key` or nullptr if not found. */
+    const Value* Lookup(const Key& key) const {
+        auto node = DoWriteLookup(key);
+        return node ? GetValueFromNode(node) : nullptr;
+    }
+
+    bool IsEmpty() const {
+        return (DoFirstLive() == nullptr);
+    }
+
+    /** returns an invalid snapshot if too many snapshots are alive. */
+    Snapshot GetSnapshot() const {
+        for (uint32_t i = 0; i < MaxSnapshotNum; ++i) {
+            uint64_t expected = SEQ_MAX;
+            if (m_slots[i].compare_exchange_strong(expected, SLOT_PENDING)) {
+                // reading after the slot is taken makes sure that nodes
+                // which may be visible to this snapshot are not freed.
+                const uint64_t seq = m_seq.load();
+                m_slots[i].store(seq);
+                return Snapshot(this, i, seq);
+            }
+        }
+        return Snapshot();
+    }
+
+    /** unlinks removed nodes invisible to all snapshots and frees nodes no
+     * snapshot can reach. it is also called by `Remove()` periodically. */
+    void Reclaim() {
+        m_retired_num = 0;
+
+        FreeUnlinked(GetMinActiveSeq());
+
+        uint64_t min_seq = GetMinActiveSeq();
+        if (!m_removed.head || m_removed.head->remove_seq.load(
+                                   std::memory_order_relaxed) > min_seq) {
+            return;
+        }
+
+        const uint64_t seq = m_seq.load(std::memory_order_relaxed) + 1;
+        while (m_removed.head &&
+               m_removed.head->remove_seq.load(std::memory_order_relaxed) <=
+                   min_seq) {
+            auto node = m_removed.PopFront();
+            DoUnlink(node);
+            node->unlink_seq = seq;
+            m_unlinked.PushBack(node);
+        }
+        m_seq.store(seq);
+
+        // snapshots taken after `seq` cannot reach nodes unlinked
+        FreeUnlinked(GetMinActiveSeq());
+    }
+
+private:
+    static bool IsVisible(const DataNode* node, uint64_t seq) {
+        return (node->insert_seq <= seq &&
+                node->remove_seq.load(std::memory_order_acquire) > seq);
+    }
+
+    static DataNode* SkipInvisible(DataNode* node, uint64_t seq) {
+        while (node && !IsVisible(node, seq)) {
+            node = node->forward[0].load(std::memory_order_acquire);
+        }
+        return node;
+    }
+
+    uint64_t GetMinActiveSeq() const {
+        uint64_t min_seq = SEQ_MAX;
+        for (uint32_t i = 0; i < MaxSnapshotNum; ++i) {
+            uint64_t seq = m_slots[i].load();
+            if (seq < min_seq) {
+                min_seq = seq;
+            }
+        }
+        return min_seq;
+    }
+
+    void FreeUnlinked(uint64_t min_seq) {
+        while (m_unlinked.head && m_unlinked.head->unlink_seq <= min_seq) {
+            DestroyNode(m_unlinked.PopFront());
+        }
+    }
+
+    /* used by readers. removed nodes are included. */
+    DataNode* DoReadLookupGreaterEqual(const Key& key) const {
+        auto prev = (DataNode*)(&m_head);
+        for (uint32_t l = MAX_LEVEL; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto node = prev->forward[level].load(std::memory_order_acquire);
+            while (node) {
+                if (m_cmp(m_get_key(*GetValueFromNode(node)), key) &
+                    SKIPLIST_DIFF_GE) {
+                    break;
+                }
+                prev = node;
+                node = node->forward[level].load(std::memory_order_acquire);
+            }
+        }
+        return prev->forward[0].load(std::memory_order_acquire);
+    }
+
+    /* returns the first node whose key is not less than `key`, and its
+     * predecessors in `update`. used by the writer. */
+    DataNode* DoWriteLookupGreaterEqual(const Key& key,
+                                        DataNode** update) const {
+        auto prev = (DataNode*)(&m_head);
+        for (uint32_t l = m_head.level; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto node = prev->forward[level].load(std::memory_order_relaxed);
+            while (node) {
+                if (m_cmp(m_get_key(*GetValueFromNode(node)), key) &
+                    SKIPLIST_DIFF_GE) {
+                    break;
+                }
+                prev = node;
+                node = node->forward[level].load(std::memory_order_relaxed);
+            }
+            if (update) {
+                update[level] = prev;
+            }
+        }
+        return prev->forward[0].load(std::memory_order_relaxed);
+    }
+
+    /* returns the node with `key` which is not removed */
+    DataNode* DoWriteLookup(const Key& key,
+                            DataNode** update = nullptr) const {
+        auto node = DoWriteLookupGreaterEqual(key, update);
+        while (node &&
+               m_cmp(m_get_key(*GetValueFromNode(node)), key) ==
+                   SKIPLIST_DIFF_EQ) {
+            if (node->remove_seq.load(std::memory_order_relaxed) == SEQ_MAX) {
+                return node;
+            }
+            node = node->forward[0].load(std::memory_order_relaxed);
+        }
+        return nullptr;
+    }
+
+    DataNode* DoFirstLive() const {
+        auto node = m_head.forward[0].load(std::memory_order_relaxed);
+        while (node &&
+               node->remove_seq.load(std::memory_order_relaxed) != SEQ_MAX) {
+            node = node->forward[0].load(std::memory_order_relaxed);
+        }
+        return node;
+    }
+
+    template <typename ValueType>
+    DataNode* DoInsert(ValueType&& value, DataNode* update[]) {
+        const uint32_t level = GenRandomLevel();
+
+        auto base = (char*)this->DoAlloc(GetNodeSize(level), NODE_ALIGNMENT);
+        if (!base) {
+            return nullptr;
+        }
+        new (base) Value(std::forward<ValueType>(value));
+
+        const uint64_t seq = m_seq.load(std::memory_order_relaxed) + 1;
+
+        auto node = (DataNode*)(base + NODE_OFFSET);
+        node->insert_seq = seq;
+        node->remove_seq.store(SEQ_MAX, std::memory_order_relaxed);
+        node->unlink_seq = SEQ_MAX;
+        node->next_retired = nullptr;
+        node->level = level;
+
+        if (level > m_head.level) {
+            for (uint32_t i = m_head.level; i < level; ++i) {
+                update[i] = (DataNode*)(&m_head);
+            }
+            m_head.level = level;
+        }
+
+        // links from bottom to top so that readers always see a valid level 0
+        for (uint32_t i = 0; i < level; ++i) {
+            node->forward[i].store(
+                update[i]->forward[i].load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            update[i]->forward[i].store(node, std::memory_order_release);
+        }
+
+        m_seq.store(seq);
+        return node;
+    }
+
+    void DoUnlink(DataNode* node) {
+        const Key& key = m_get_key(*GetValueFromNode(node));
+
+        // nodes with the same key are not ordered by levels, so `node` is
+        // searched by address among them in levels it belongs to.
+        auto prev = (DataNode*)(&m_head);
+        for (uint32_t l = m_head.level; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto next = prev->forward[level].load(std::memory_order_relaxed);
+            while (next &&
+                   m_cmp(m_get_key(*GetValueFromNode(next)), key) ==
+                       SKIPLIST_DIFF_LT) {
+                prev = next;
+                next = next->forward[level].load(std::memory_order_relaxed);
+            }
+            if (level >= node->level) {
+                continue;
+            }
+
+            while (next != node) {
+                prev = next;
+                next = next->forward[level].load(std::memory_order_relaxed);
+            }
+            prev->forward[level].store(
+                node->forward[level].load(std::memory_order_relaxed),
+                std::memory_order_release);
+        }
+
+        while (m_head.level > 0 &&
+               !m_head.forward[m_head.level - 1].load(
+                   std::memory_order_relaxed)) {
+            --m_head.level;
+        }
+    }
+
+    void DestroyNode(DataNode* node) {
+        const uint64_t node_size = GetNodeSize(node->level);
+        auto pvalue = GetValueFromNode(node);
+        pvalue->~Value();
+        this->DoFree(pvalue, node_size);
+    }
+
+    uint32_t GenRandomLevel() const {
+        uint32_t level = 1;
+        while (level < MAX_LEVEL && xoshiro256ss_next(&m_rand) % 4 == 0) {
+            ++level;
+        }
+        return level;
+    }
+
+    static uint64_t GetNodeSize(uint32_t level) {
+        return NODE_OFFSET + sizeof(DataNode) +
+            (sizeof(std::atomic<DataNode*>) * level);
+    }
+
+    static Value* GetValueFromNode(const DataNode* node) {
+        return (Value*)((char*)node - NODE_OFFSET);
+    }
+
+private:
+    HeadNode m_head;
+    Comparator m_cmp;
+    GetKeyFromValue m_get_key;
+    mutable Xoshiro256ss m_rand;
+    std::atomic<uint64_t> m_seq;
+    mutable std::atomic<uint64_t> m_slots[MaxSnapshotNum];
+    RetiredList m_removed; // removed but still linked
+    RetiredList m_unlinked; // unlinked but may be reachable by snapshots
+    uint32_t m_retired_num = 0;
+
+private:
+    MvccSkipList(const MvccSkipList&) = delete;
+    MvccSkipList& operator=(const MvccSkipList&) = delete;
+};
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Allocator = GenericCpuAllocator>
+using MvccSkipListSet =
+    MvccSkipList<Value, Value, Comparator,
+                 internal::SkipListReturnSelfFromValue<Value>, Allocator>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Allocator = GenericCpuAllocator>
+using MvccSkipListMap =
+    MvccSkipList<Key, std::pair<Key, Value>, Comparator,
+                 internal::SkipListReturnFirstOfPair<Key, Value>, Allocator>;
+
+}
+
+#endif
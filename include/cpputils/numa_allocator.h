@@ -0,0 +1,117 @@
+#ifndef __CPPUTILS_NUMA_ALLOCATOR_H__
+#define __CPPUTILS_NUMA_ALLOCATOR_H__
+
+#ifdef __linux__
+
+#include "cpputils/allocator.h"
+#include "cpputils/compact_addr_manager.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace cpputils {
+
+/**
+   allocates memory bound to a NUMA node with `mbind()`. binding is best
+   effort: memory is still returned if the kernel refuses to bind it, e.g.
+   when `node` doesn't exist or the syscall is not permitted.
+
+   requests not greater than 2048 bytes are served by per-node, per-size
+   slabs without per-block headers, and larger ones are mapped separately.
+   this class is thread-safe.
+*/
+class NumaAllocator : public Allocator {
+public:
+    static constexpr int LOCAL_NODE = -1;
+    static constexpr uint32_t MAX_NODE_NUM = 64;
+
+public:
+    /** binds memory to `node`, or to the node of the calling thread at the
+     * time of allocation if `node` is `LOCAL_NODE`. */
+    NumaAllocator(int node = LOCAL_NODE);
+    ~NumaAllocator();
+
+    void* Alloc(uint64_t bytes) override;
+    void Free(void* ptr) override;
+
+    using Allocator::Alloc;
+    using Allocator::Free;
+
+    /** returns the number of bytes allocated and not freed on `node`. */
+    uint64_t GetNodeUsage(uint32_t node) const {
+        return (node < MAX_NODE_NUM)
+            ? m_usage[node].load(std::memory_order_relaxed)
+            : 0;
+    }
+
+    /** returns the node of the cpu which the calling thread runs on, or 0 if
+     * it cannot be determined. */
+    static uint32_t GetCurrentNode();
+
+protected:
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override;
+    void DoFree(void* ptr, uint64_t bytes) override;
+
+private:
+    struct NodeState;
+
+    NodeState* GetNodeState(uint32_t node);
+
+private:
+    const int m_node;
+    std::mutex m_lock;
+    NodeState* m_nodes[MAX_NODE_NUM];
+    std::atomic<uint64_t> m_usage[MAX_NODE_NUM];
+
+private:
+    NumaAllocator(const NumaAllocator&) = delete;
+    NumaAllocator& operator=(const NumaAllocator&) = delete;
+};
+
+/**
+   reserves an address range and commits pages bound to a NUMA node on
+   `Extend()`. memory is returned to the system when this object is
+   destroyed.
+*/
+class NumaVMAllocator final : public CompactAddrManager::VMAllocator {
+public:
+    /** see `NumaAllocator::NumaAllocator()` for `node`. */
+    NumaVMAllocator(int node = NumaAllocator::LOCAL_NODE) : m_node(node) {}
+    ~NumaVMAllocator() {
+        Destroy();
+    }
+
+    /** reserves `max_size` bytes of address space. */
+    bool Init(uint64_t max_size, std::string* errmsg = nullptr);
+    void Destroy();
+
+    uintptr_t GetReservedBase() const override {
+        return (uintptr_t)m_base;
+    }
+    uint64_t GetAllocatedSize() const override {
+        return m_allocated_size;
+    }
+    uint64_t Extend(uint64_t needed) override;
+
+    /** returns the number of bytes committed on `node`. */
+    uint64_t GetNodeUsage(uint32_t node) const {
+        return (node < NumaAllocator::MAX_NODE_NUM) ? m_usage[node] : 0;
+    }
+
+private:
+    const int m_node;
+    void* m_base = nullptr;
+    uint64_t m_reserved_size = 0;
+    uint64_t m_allocated_size = 0;
+    uint64_t m_usage[NumaAllocator::MAX_NODE_NUM] = {0};
+
+private:
+    NumaVMAllocator(const NumaVMAllocator&) = delete;
+    NumaVMAllocator& operator=(const NumaVMAllocator&) = delete;
+};
+
+}
+
+#endif // __linux__
+
+#endif
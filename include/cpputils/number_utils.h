@@ -0,0 +1,34 @@
+#ifndef __CPPUTILS_NUMBER_UTILS_H__
+#define __CPPUTILS_NUMBER_UTILS_H__
+
+#include <stdint.h>
+
+namespace cpputils {
+
+/*
+  parsing functions convert the whole [s, s + len) without allocations and
+  don't depend on locales. leading or trailing spaces are not allowed. they
+  return false if the string is not a valid number or out of range.
+*/
+
+bool ParseUInt(const char* s, unsigned int len, uint64_t* value);
+bool ParseInt(const char* s, unsigned int len, int64_t* value);
+bool ParseDouble(const char* s, unsigned int len, double* value);
+
+/** min size of buffers passed to formatting functions */
+static constexpr unsigned int NUMBER_FORMAT_BUF_SIZE = 32;
+
+/*
+  formatting functions write the number to `buf` without a terminating '\0',
+  and return the number of chars written.
+*/
+
+unsigned int FormatUInt(uint64_t value, char* buf);
+unsigned int FormatInt(int64_t value, char* buf);
+/** writes the shortest correctly rounded string that can be parsed back to
+ * the same value, e.g. "5e-324" for the smallest subnormal. */
+unsigned int FormatDouble(double value, char* buf);
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __CPPUTILS_POOL_ALLOCATOR_H__
+#define __CPPUTILS_POOL_ALLOCATOR_H__
+
+#include "cpputils/allocator.h"
+#include <cstdlib>
+
+namespace cpputils {
+
+/**
+   allocates blocks of `BlockSize` bytes from chunks containing
+   `BlocksPerChunk` blocks. freed blocks are kept in an intrusive free list and
+   chunks are returned to the system when the allocator is destroyed.
+
+   `Alloc()` returns nullptr if `bytes` > `BlockSize`. blocks are aligned to
+   `sizeof(void*)`.
+*/
+template <uint64_t BlockSize, uint32_t BlocksPerChunk = 1024>
+class PoolAllocator : public Allocator {
+private:
+    struct FreeNode final {
+        FreeNode* next;
+    };
+
+    static constexpr uint64_t STRIDE =
+        (((BlockSize < sizeof(FreeNode)) ? sizeof(FreeNode) : BlockSize) +
+         sizeof(void*) - 1) &
+        ~(sizeof(void*) - 1);
+
+    static_assert(BlocksPerChunk > 0, "`BlocksPerChunk` MUST be positive.");
+
+public:
+    PoolAllocator() {}
+
+    ~PoolAllocator() {
+        while (m_chunks) {
+            auto next = m_chunks->next;
+            ::free(m_chunks);
+            m_chunks = next;
+        }
+    }
+
+    void* Alloc(uint64_t bytes) override {
+        if (bytes > BlockSize) {
+            return nullptr;
+        }
+
+        if (m_free_list) {
+            auto node = m_free_list;
+            m_free_list = node->next;
+            return node;
+        }
+
+        if (m_cursor == m_end) {
+            // the first `FreeNode` of a chunk links all chunks together
+            auto chunk = (FreeNode*)::malloc(sizeof(FreeNode) +
+                                             STRIDE * BlocksPerChunk);
+            if (!chunk) {
+                return nullptr;
+            }
+            chunk->next = m_chunks;
+            m_chunks = chunk;
+            m_cursor = (char*)chunk + sizeof(FreeNode);
+            m_end = m_cursor + STRIDE * BlocksPerChunk;
+        }
+
+        auto ptr = m_cursor;
+        m_cursor += STRIDE;
+        return ptr;
+    }
+
+    void Free(void* ptr) override {
+        if (ptr) {
+            auto node = (FreeNode*)ptr;
+            node->next = m_free_list;
+            m_free_list = node;
+        }
+    }
+
+    using Allocator::Alloc;
+    using Allocator::Free;
+
+protected:
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override {
+        if (alignment > sizeof(void*)) {
+            return nullptr;
+        }
+        return PoolAllocator::Alloc(bytes);
+    }
+
+    void DoFree(void* ptr, uint64_t) override {
+        PoolAllocator::Free(ptr);
+    }
+
+private:
+    FreeNode* m_free_list = nullptr;
+    FreeNode* m_chunks = nullptr;
+    char* m_cursor = nullptr; // unused area of the latest chunk
+    char* m_end = nullptr;
+
+private:
+    PoolAllocator(const PoolAllocator&) = delete;
+    PoolAllocator& operator=(const PoolAllocator&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef __CPPUTILS_SEQLOCK_RING_BUFFER_H__
+#define __CPPUTILS_SEQLOCK_RING_BUFFER_H__
+
+#include <stdint.h>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+
+namespace cpputils {
+
+/*
+  a ring buffer that overwrites the oldest items like `RingBuffer`, with one
+  writer and any number of concurrent readers. the writer never waits for
+  readers. each slot has a sequence number which is odd while the slot is being
+  written, so readers can detect and retry slots overwritten during copying.
+
+  `T` MUST be trivially copyable.
+*/
+template <typename T>
+class SeqlockRingBuffer final {
+private:
+    static_assert(std::is_trivially_copy_constructible<T>::value &&
+                      std::is_trivially_destructible<T>::value,
+                  "`T` MUST be trivially copyable.");
+
+    /* `seq` is 2 * item index + 1 while writing and 2 * item index + 2 after
+     * that */
+    struct Slot final {
+        std::atomic<uint64_t> seq;
+        T value;
+    };
+
+public:
+    static constexpr uint32_t MAX_CAPACITY = (1u << 31);
+
+public:
+    /** @param capacity is rounded up to a power of 2, and is at most
+     * `MAX_CAPACITY` */
+    SeqlockRingBuffer(uint32_t capacity) {
+        if (capacity > MAX_CAPACITY) {
+            capacity = MAX_CAPACITY;
+        }
+        m_capacity = 1;
+        while (m_capacity < capacity) {
+            m_capacity <<= 1;
+        }
+        m_slots.reset(new Slot[m_capacity]);
+        for (uint32_t i = 0; i < m_capacity; ++i) {
+            m_slots[i].seq.store(0, std::memory_order_relaxed);
+        }
+        m_head.store(0, std::memory_order_release);
+    }
+
+    /** MUST be called by one thread at a time */
+    void PushBack(const T& item) {
+        const uint64_t idx = m_head.load(std::memory_order_relaxed);
+        auto slot = &m_slots[idx & (m_capacity - 1)];
+
+        slot->seq.store(idx * 2 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy((void*)&slot->value, &item, sizeof(T));
+        slot->seq.store(idx * 2 + 2, std::memory_order_release);
+
+        m_head.store(idx + 1, std::memory_order_release);
+    }
+
+    /**
+       @brief copies the last `num` items or fewer, from the oldest to the
+       newest, into `items`. items are consecutive as if the writer were
+       stopped at some point during the call.
+       @return the number of items copied.
+    */
+    uint32_t Snapshot(T* items, uint32_t num) const {
+        uint64_t end = m_head.load(std::memory_order_acquire);
+        if (num > m_capacity) {
+            num = m_capacity;
+        }
+        if (num > end) {
+            num = end;
+        }
+
+        uint64_t begin = end - num;
+        uint64_t idx = begin;
+        while (idx < end) {
+            if (ReadSlot(idx, &items[idx - begin])) {
+                ++idx;
+                continue;
+            }
+
+            /* overwritten, so that the writer is at least a whole buffer
+             * ahead and items read are out of the new window too. restarts
+             * from the new window. */
+            end = m_head.load(std::memory_order_acquire);
+            begin = end - num;
+            idx = begin;
+        }
+
+        return num;
+    }
+
+    /**
+       @brief copies at most `num` items in order, starting from the one
+       pushed as the `*next`-th, and sets `*next` to the index after the last
+       item read. items overwritten before being read are skipped, so a
+       reader can consume all items without locking the writer.
+       @return the number of items copied.
+    */
+    uint32_t ReadFrom(uint64_t* next, T* items, uint32_t num) const {
+        uint32_t count = 0;
+        uint64_t idx = *next;
+        while (count < num) {
+            const uint64_t head = m_head.load(std::memory_order_acquire);
+            if (idx >= head) {
+                break;
+            }
+            if (head - idx > m_capacity) {
+                idx = head - m_capacity;
+            }
+            if (ReadSlot(idx, &items[count])) {
+                ++count;
+            }
+            ++idx;
+        }
+
+        *next = idx;
+        return count;
+    }
+
+    /** the number of items available, which may change at any time */
+    uint32_t size() const {
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        return (head < m_capacity) ? head : m_capacity;
+    }
+
+    uint32_t capacity() const {
+        return m_capacity;
+    }
+
+private:
+    bool ReadSlot(uint64_t idx, T* item) const {
+        auto slot = &m_slots[idx & (m_capacity - 1)];
+        const uint64_t expected = idx * 2 + 2;
+        if (slot->seq.load(std::memory_order_acquire) != expected) {
+            return false;
+        }
+        memcpy((void*)item, (const void*)&slot->value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return (slot->seq.load(std::memory_order_relaxed) == expected);
+    }
+
+private:
+    uint32_t m_capacity;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<uint64_t> m_head; // index of the next item
+
+private:
+    SeqlockRingBuffer(const SeqlockRingBuffer&) = delete;
+    SeqlockRingBuffer& operator=(const SeqlockRingBuffer&) = delete;
+};
+
+}
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef __CPPUTILS_SHM_RING_BUFFER_H__
+#define __CPPUTILS_SHM_RING_BUFFER_H__
+
+#ifdef __linux__
+
+#include "file_mapping.h"
+#include <atomic>
+#include <string>
+
+namespace cpputils {
+
+/*
+  a ring buffer of fixed-size slots in a shared file mapping (e.g. a file in
+  /dev/shm), used to pass records between processes on the same host.
+
+  any number of producers can call `Push()` concurrently without locks. when
+  the buffer is full the oldest records are overwritten, so producers never
+  wait for the consumer. there should be only one consumer for a buffer, which
+  keeps its own read cursor and can block in `Wait()` until new records are
+  pushed.
+
+  a producer that crashes in `Push()` leaves its slot half-written. the
+  record is lost: the consumer skips it, and the next producer of the slot
+  takes it over once the crashed process has exited, or after about 1 second
+  if the crash happened before the producer recorded its pid. pids are
+  checked by `kill()`, so all processes MUST be in the same pid namespace.
+*/
+class ShmRingBuffer final {
+public:
+    ShmRingBuffer() {}
+    ~ShmRingBuffer() {
+        Destroy();
+    }
+
+    /**
+       @brief creates or truncates `filename` and initializes an empty buffer.
+       @param slot_size max size of a record
+       @param capacity number of slots. MUST be a power of 2.
+    */
+    bool Create(const char* filename, uint32_t slot_size, uint32_t capacity,
+                std::string* errmsg = nullptr);
+
+    /** @brief opens a buffer created by `Create()`. */
+    bool Init(const char* filename, std::string* errmsg = nullptr);
+
+    void Destroy();
+
+    /**
+       @brief returns false if `size` > slot size. may wait for another
+       producer writing the same slot, which is one whole buffer behind.
+    */
+    bool Push(const void* data, uint32_t size);
+
+    /**
+       @brief copies the next record to `data`, which MUST have at least
+       `GetSlotSize()` bytes.
+       @param dropped number of records overwritten before they were read
+       @return false if no record is available.
+    */
+    bool Pop(void* data, uint32_t* size, uint64_t* dropped = nullptr);
+
+    /**
+       @brief waits until a record may be available or `timeout_ms` elapses.
+       @return false if timed out.
+    */
+    bool Wait(uint32_t timeout_ms = UINT32_MAX);
+
+    uint32_t GetSlotSize() const;
+    uint32_t GetCapacity() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    static uint64_t GetHeaderSize();
+    static uint64_t GetSlotStride(uint32_t slot_size);
+    /* `wait_begin` is the time the caller started waiting for the writer,
+     * or nullptr if it does not wait. */
+    static bool IsStaleWriter(const Slot* slot, uint64_t* wait_begin);
+
+    bool DoInit(std::string* errmsg);
+    Slot* GetSlot(uint64_t seq) const;
+    bool HasRecord() const;
+
+private:
+    FileMapping m_fm;
+    Header* m_header = nullptr;
+    char* m_slots = nullptr;
+    uint64_t m_slot_stride = 0;
+    uint64_t m_cursor = 0; // next record to read
+
+private:
+    ShmRingBuffer(const ShmRingBuffer&) = delete;
+    ShmRingBuffer& operator=(const ShmRingBuffer&) = delete;
+};
+
+}
+
+#endif // __linux__
+
+#endif
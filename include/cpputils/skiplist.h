@@ -2,10 +2,15 @@
 #define __CPPUTILS_SKIPLIST_H__
 
 #include "generic_cpu_allocator.h"
+#include "bit_utils.h"
 #include "cutils/random/xoshiro256ss.h"
 #include <cstdint>
 #include <cstring>
+#include <new> // placement new
+#include <tuple>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace cpputils {
 
@@ -15,16 +20,89 @@ static constexpr uint32_t SKIPLIST_DIFF_GT = 2;
 static constexpr uint32_t SKIPLIST_DIFF_GE =
     (SKIPLIST_DIFF_EQ | SKIPLIST_DIFF_GT);
 
+namespace internal {
+
+template <typename T>
+struct SkipListVoid final {
+    typedef void type;
+};
+
+/* `Comparator::is_transparent` exists */
+template <typename Comparator, typename = void>
+struct SkipListIsTransparent : std::false_type {};
+
+template <typename Comparator>
+struct SkipListIsTransparent<
+    Comparator,
+    typename SkipListVoid<typename Comparator::is_transparent>::type>
+    : std::true_type {};
+
+/* enables overloads of heterogeneous keys */
+template <typename Comparator, typename KeyType>
+using SkipListEnableIfTransparent =
+    typename std::enable_if<SkipListIsTransparent<Comparator>::value,
+                            KeyType>::type;
+
+}
+
+struct SkipListStats final {
+    uint64_t count = 0; // number of values
+    /** level_node_num[i] is the number of nodes with more than i levels */
+    std::vector<uint64_t> level_node_num;
+    /** average number of nodes visited by looking up each value */
+    double avg_search_path = 0;
+    uint64_t memory_bytes = 0;
+};
+
 /*
   `Comparator` has the form of `uint32_t func(const Key& a, const Key& b)`,
   which returns `SKIPLIST_DIFF_LT`, `SKIPLIST_DIFF_EQ`, `SKIPLIST_DIFF_GT` for a
   < b, a == b, a > b, respectively.
+
+  if `Comparator` defines a member type `is_transparent`, like `std::less<>`,
+  lookups and removals also accept any `KeyType` that it can compare with `Key`
+  as `func(const Key&, const KeyType&)`, so no temporary `Key` is needed.
+  otherwise they take `const Key&` only.
+
+  if `AllowDuplicates` is true, values with equal keys are kept in insertion
+  order, and lookups and removals find the first one of them.
+
+  a node is promoted to the next level with probability 1 /
+  `BranchingFactor`, and has at most `MaxLevel` levels. lists of up to about
+  `BranchingFactor` ^ `MaxLevel` values are searched in O(log n).
 */
 template <typename Key, typename Value, typename Comparator,
-          typename GetKeyFromValue, typename Allocator>
+          typename GetKeyFromValue, typename Allocator,
+          bool AllowDuplicates = false, uint32_t MaxLevel = 12,
+          uint32_t BranchingFactor = 4>
 class SkipList final : public Allocator {
 private:
-    static constexpr uint32_t MAX_LEVEL = 12;
+    static_assert(MaxLevel >= 1 && MaxLevel <= 64,
+                  "`MaxLevel` MUST be in [1, 64].");
+    static_assert(BranchingFactor >= 2, "`BranchingFactor` MUST be >= 2.");
+
+    static constexpr uint32_t MAX_LEVEL = MaxLevel;
+
+    /* bits of a random number consumed per level if `BranchingFactor` is a
+     * power of 2, or 0 otherwise */
+    static constexpr uint32_t LEVEL_BITS =
+        ((BranchingFactor & (BranchingFactor - 1)) != 0) ? 0 :
+        internal::Log2(BranchingFactor);
+
+    static constexpr bool IS_TRANSPARENT =
+        internal::SkipListIsTransparent<Comparator>::value;
+
+    template <typename KeyType>
+    using EnableIfTransparent =
+        internal::SkipListEnableIfTransparent<Comparator, KeyType>;
+
+    /* the type of keys compared with: `KeyType` itself if `Comparator` is
+     * transparent, or `Key` converted once otherwise */
+    template <typename KeyType>
+    using LookupKeyType =
+        typename std::conditional<IS_TRANSPARENT,
+                                  typename std::decay<KeyType>::type,
+                                  Key>::type;
 
 private:
     struct DataNode final {
@@ -86,6 +164,13 @@ public:
         memset(&m_head, 0, sizeof(HeadNode));
     }
 
+    /** levels of nodes are generated from `seed`, so that lists built by the
+     * same operations have the same structure. */
+    explicit SkipList(uint64_t seed) {
+        xoshiro256ss_init(&m_rand, seed);
+        memset(&m_head, 0, sizeof(HeadNode));
+    }
+
     ~SkipList() {
         DoDestroy();
     }
@@ -94,52 +179,390 @@ public:
     std::pair<Iterator, bool> Insert(ValueType&& value) {
         const Key& key = m_get_key(value);
 
+        DataNode* update[MAX_LEVEL];
+        if (AllowDuplicates) {
+            DoLookupLessEqual(key, update);
+        } else {
+            uint32_t ge_diff = UINT32_MAX;
+            auto node = DoLookupGreaterEqual(key, &ge_diff, update);
+            if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+                return std::pair<Iterator, bool>(Iterator(node), false);
+            }
+        }
+
+        auto node = DoInsert(update, std::forward<ValueType>(value));
+        return std::pair<Iterator, bool>(Iterator(node), (node != nullptr));
+    }
+
+    /**
+       @brief constructs a value from `args` in a new node, which is released
+       if the key already exists.
+    */
+    template <typename... Args>
+    std::pair<Iterator, bool> Emplace(Args&&... args) {
+        const uint32_t level = GenRandomLevel();
+        auto node = AllocNode(level);
+        if (!node) {
+            return std::pair<Iterator, bool>(Iterator(), false);
+        }
+
+        auto pvalue = GetValueFromNode(node);
+        new (pvalue) Value(std::forward<Args>(args)...);
+
+        DataNode* update[MAX_LEVEL];
+        if (AllowDuplicates) {
+            DoLookupLessEqual(m_get_key(*pvalue), update);
+        } else {
+            uint32_t ge_diff = UINT32_MAX;
+            auto found =
+                DoLookupGreaterEqual(m_get_key(*pvalue), &ge_diff, update);
+            if (found && (ge_diff == SKIPLIST_DIFF_EQ)) {
+                pvalue->~Value();
+                this->DoFree(pvalue, GetNodeSize(level));
+                return std::pair<Iterator, bool>(Iterator(found), false);
+            }
+        }
+
+        LinkNode(node, update);
+        return std::pair<Iterator, bool>(Iterator(node), true);
+    }
+
+    /**
+       @brief for maps only. constructs the value as `{key, mapped(args...)}`
+       only if `key` does not exist.
+    */
+    template <typename KeyType, typename... Args>
+    std::pair<Iterator, bool> TryEmplace(KeyType&& key, Args&&... args) {
+        const LookupKeyType<KeyType>& lookup_key = key;
         uint32_t ge_diff = UINT32_MAX;
         DataNode* update[MAX_LEVEL];
-        auto node = DoLookupGreaterEqual(key, &ge_diff, update);
+        auto node = DoLookupGreaterEqual(lookup_key, &ge_diff, update);
+        if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+            return std::pair<Iterator, bool>(Iterator(node), false);
+        }
+
+        node = DoInsert(update, std::piecewise_construct,
+                        std::forward_as_tuple(std::forward<KeyType>(key)),
+                        std::forward_as_tuple(std::forward<Args>(args)...));
+        return std::pair<Iterator, bool>(Iterator(node), (node != nullptr));
+    }
+
+    /**
+       @brief for maps only. assigns `mapped` to the existing value of `key`,
+       or inserts `{key, mapped}`. the second of the returned value is true if
+       inserted.
+    */
+    template <typename KeyType, typename MappedType>
+    std::pair<Iterator, bool> InsertOrAssign(KeyType&& key,
+                                             MappedType&& mapped) {
+        const LookupKeyType<KeyType>& lookup_key = key;
+        uint32_t ge_diff = UINT32_MAX;
+        DataNode* update[MAX_LEVEL];
+        auto node = DoLookupGreaterEqual(lookup_key, &ge_diff, update);
         if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+            GetValueFromNode(node)->second = std::forward<MappedType>(mapped);
             return std::pair<Iterator, bool>(Iterator(node), false);
         }
 
-        node = DoInsert(std::forward<ValueType>(value), update);
+        node = DoInsert(update, std::forward<KeyType>(key),
+                        std::forward<MappedType>(mapped));
         return std::pair<Iterator, bool>(Iterator(node), (node != nullptr));
     }
 
+    /** removes the first value in O(levels) without comparisons. */
+    template <typename ValueType = Value>
+    bool PopFront(ValueType* value = nullptr) {
+        auto node = m_head.forward[0];
+        if (!node) {
+            return false;
+        }
+
+        auto pvalue = GetValueFromNode(node);
+        if (value) {
+            *value = std::move(*pvalue);
+        }
+        DoPopFront(node);
+        return true;
+    }
+
+    /**
+       @brief removes values from the front while `pred(const Value&)` returns
+       true, and passes each of them to `sink(Value&&)`.
+       @return the number of values removed.
+    */
+    template <typename Predicate, typename Sink>
+    uint64_t PopWhile(Predicate&& pred, Sink&& sink) {
+        uint64_t count = 0;
+        auto node = m_head.forward[0];
+        while (node) {
+            auto pvalue = GetValueFromNode(node);
+            if (!pred((const Value&)(*pvalue))) {
+                break;
+            }
+
+            sink(std::move(*pvalue));
+            DoPopFront(node);
+            ++count;
+            node = m_head.forward[0];
+        }
+        return count;
+    }
+
     template <typename ValueType = Value>
     bool Remove(const Key& key, ValueType* value = nullptr) {
         return DoRemove(key, value, SKIPLIST_DIFF_EQ);
     }
 
+    template <typename KeyType, typename ValueType = Value,
+              typename = EnableIfTransparent<KeyType>>
+    bool Remove(const KeyType& key, ValueType* value = nullptr) {
+        return DoRemove(key, value, SKIPLIST_DIFF_EQ);
+    }
+
     template <typename ValueType = Value>
     bool RemoveGreaterEqual(const Key& key, ValueType* value = nullptr) {
         return DoRemove(key, value, SKIPLIST_DIFF_GE);
     }
 
+    template <typename KeyType, typename ValueType = Value,
+              typename = EnableIfTransparent<KeyType>>
+    bool RemoveGreaterEqual(const KeyType& key, ValueType* value = nullptr) {
+        return DoRemove(key, value, SKIPLIST_DIFF_GE);
+    }
+
     void Clear() {
         DoDestroy();
         memset(&m_head, 0, sizeof(HeadNode));
     }
 
-    Iterator Lookup(const Key& key) const {
-        uint32_t ge_diff = UINT32_MAX;
-        auto node = DoLookupGreaterEqual(key, &ge_diff);
-        if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
-            return Iterator(node);
+    /**
+       @brief moves nodes of `other` into this list in O(n + m) without
+       reallocating them. if duplicates are not allowed, values whose keys
+       exist in this list are left in `other`. allocators of both lists MUST
+       be able to free memory allocated by each other, e.g. stateless ones
+       like `GenericCpuAllocator`.
+    */
+    void Merge(SkipList* other) {
+        if (other == this) {
+            return;
         }
-        return Iterator();
+
+        auto a = m_head.forward[0];
+        auto b = other->m_head.forward[0];
+
+        DataNode* tail[MAX_LEVEL];
+        DataNode* other_tail[MAX_LEVEL];
+        BeginRebuild(tail);
+        other->BeginRebuild(other_tail);
+
+        while (a && b) {
+            auto next_a = a->forward[0];
+            auto next_b = b->forward[0];
+            uint32_t diff = m_cmp(m_get_key(*GetValueFromNode(a)),
+                                  m_get_key(*GetValueFromNode(b)));
+            if (diff == SKIPLIST_DIFF_LT ||
+                (AllowDuplicates && diff == SKIPLIST_DIFF_EQ)) {
+                AppendNode(a, tail);
+                a = next_a;
+            } else if (diff == SKIPLIST_DIFF_GT) {
+                AppendNode(b, tail);
+                b = next_b;
+            } else {
+                AppendNode(a, tail);
+                AppendNode(b, other_tail);
+                a = next_a;
+                b = next_b;
+            }
+        }
+        for (; a; a = a->forward[0]) {
+            AppendNode(a, tail);
+        }
+        for (; b; b = b->forward[0]) {
+            AppendNode(b, tail);
+        }
+
+        EndRebuild(tail);
+        other->EndRebuild(other_tail);
+    }
+
+    /**
+       @brief moves values that are greater than or equal to `key` into
+       `tail` in O(log n). `tail` MUST be empty, and its allocator has the same
+       requirement as `Merge()`.
+    */
+    bool SplitAt(const Key& key, SkipList* tail) {
+        return DoSplitAt(key, tail);
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    bool SplitAt(const KeyType& key, SkipList* tail) {
+        return DoSplitAt(key, tail);
+    }
+
+    /** inserts copies of values in `other` whose keys don't exist in O(n + m).
+     * returns false if allocation failed. */
+    bool UnionWith(const SkipList& other) {
+        if (&other == this) {
+            return true;
+        }
+
+        bool ok = true;
+        auto a = m_head.forward[0];
+        auto b = other.m_head.forward[0];
+        DataNode* tail[MAX_LEVEL];
+        BeginRebuild(tail);
+
+        while (a && b) {
+            auto pvalue = GetValueFromNode(b);
+            uint32_t diff = m_cmp(m_get_key(*GetValueFromNode(a)),
+                                  m_get_key(*pvalue));
+            if (diff == SKIPLIST_DIFF_GT) {
+                auto node = AllocNode(GenRandomLevel());
+                if (!node) {
+                    ok = false;
+                    break;
+                }
+                new (GetValueFromNode(node)) Value(*pvalue);
+                AppendNode(node, tail);
+                b = b->forward[0];
+            } else {
+                if (diff == SKIPLIST_DIFF_EQ) {
+                    b = b->forward[0];
+                }
+                auto next = a->forward[0];
+                AppendNode(a, tail);
+                a = next;
+            }
+        }
+        while (a) {
+            auto next = a->forward[0];
+            AppendNode(a, tail);
+            a = next;
+        }
+        for (; ok && b; b = b->forward[0]) {
+            auto node = AllocNode(GenRandomLevel());
+            if (!node) {
+                ok = false;
+                break;
+            }
+            new (GetValueFromNode(node)) Value(*GetValueFromNode(b));
+            AppendNode(node, tail);
+        }
+
+        EndRebuild(tail);
+        return ok;
+    }
+
+    /** removes values whose keys don't exist in `other` in O(n + m). */
+    void IntersectWith(const SkipList& other) {
+        if (&other != this) {
+            DoFilter(other, true);
+        }
+    }
+
+    /** removes values whose keys exist in `other` in O(n + m). */
+    void SubtractWith(const SkipList& other) {
+        if (&other == this) {
+            Clear();
+        } else {
+            DoFilter(other, false);
+        }
+    }
+
+    Iterator Lookup(const Key& key) const {
+        return DoLookup(key);
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator Lookup(const KeyType& key) const {
+        return DoLookup(key);
     }
 
     Iterator LookupGreaterEqual(const Key& key) const {
-        auto node = DoLookupGreaterEqual(key);
-        return Iterator(node);
+        return Iterator(DoLookupGreaterEqual(key));
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator LookupGreaterEqual(const KeyType& key) const {
+        return Iterator(DoLookupGreaterEqual(key));
     }
 
     Iterator LookupLessThan(const Key& key) const {
-        auto node = DoLookupLessThan(key);
-        if (node == (DataNode*)(&m_head)) {
-            return Iterator();
+        return GetLessThanIterator(DoLookupLessThan(key));
+    }
+
+    template <typename KeyType, typename = EnableIfTransparent<KeyType>>
+    Iterator LookupLessThan(const KeyType& key) const {
+        return GetLessThanIterator(DoLookupLessThan(key));
+    }
+
+    /**
+       @brief redraws levels of all nodes in O(n), e.g. after bulk removals
+       or `Merge()` left the list unbalanced. nodes whose levels change are
+       reallocated and their values are moved. nodes that cannot be
+       reallocated keep their levels.
+    */
+    void Rebalance() {
+        auto cur = m_head.forward[0];
+        DataNode* tail[MAX_LEVEL];
+        BeginRebuild(tail);
+
+        while (cur) {
+            auto next = cur->forward[0];
+            const uint32_t level = GenRandomLevel();
+            if (level != cur->level) {
+                auto node = AllocNode(level);
+                if (node) {
+                    auto pvalue = GetValueFromNode(cur);
+                    new (GetValueFromNode(node)) Value(std::move(*pvalue));
+                    const uint64_t node_size = GetNodeSize(cur->level);
+                    pvalue->~Value();
+                    this->DoFree(pvalue, node_size);
+                    cur = node;
+                }
+            }
+            AppendNode(cur, tail);
+            cur = next;
         }
-        return Iterator(node);
+
+        EndRebuild(tail);
+    }
+
+    /** collects statistics of the structure in O(n * levels). */
+    SkipListStats GetStructureStats() const {
+        SkipListStats stats;
+        stats.level_node_num.resize(m_head.level, 0);
+        stats.memory_bytes = sizeof(*this);
+
+        /* a lookup of a node at level l walks over nodes with exactly l + 1
+         * levels after the last one with more levels before it. pending[l]
+         * is the number of such nodes before the current one. */
+        uint64_t pending[MAX_LEVEL] = {0};
+        uint64_t path_sum = 0;
+        for (auto node = m_head.forward[0]; node; node = node->forward[0]) {
+            const uint32_t level = node->level;
+            ++stats.count;
+            stats.memory_bytes += GetNodeSize(level);
+
+            uint64_t path = 1; // the node itself
+            for (uint32_t i = 0; i < m_head.level; ++i) {
+                path += pending[i];
+            }
+            path_sum += path;
+
+            for (uint32_t i = 0; i < level; ++i) {
+                ++stats.level_node_num[i];
+            }
+            for (uint32_t i = 0; i + 1 < level; ++i) {
+                pending[i] = 0;
+            }
+            ++pending[level - 1];
+        }
+
+        if (stats.count > 0) {
+            stats.avg_search_path = (double)path_sum / stats.count;
+        }
+        return stats;
     }
 
     bool IsEmpty() const {
@@ -156,7 +579,8 @@ public:
 
 private:
     // ge_diff: the greater or equal diff value of the lastest comparison
-    DataNode* DoLookupLessThan(const Key& key, uint32_t* ge_diff = nullptr,
+    template <typename KeyType>
+    DataNode* DoLookupLessThan(const KeyType& key, uint32_t* ge_diff = nullptr,
                                DataNode** update = nullptr) const {
         auto prev = (DataNode*)(&m_head);
         for (uint32_t l = prev->level; l > 0; --l) {
@@ -183,14 +607,87 @@ private:
         return prev;
     }
 
-    DataNode* DoLookupGreaterEqual(const Key& key, uint32_t* ge_diff = nullptr,
+    template <typename KeyType>
+    DataNode* DoLookupGreaterEqual(const KeyType& key,
+                                   uint32_t* ge_diff = nullptr,
                                    DataNode** update = nullptr) const {
         auto node = DoLookupLessThan(key, ge_diff, update);
         return node->forward[0];
     }
 
-    template <typename ValueType>
-    bool DoRemove(const Key& key, ValueType* value, uint32_t ge_diff_mask) {
+    template <typename KeyType>
+    Iterator DoLookup(const KeyType& key) const {
+        uint32_t ge_diff = UINT32_MAX;
+        auto node = DoLookupGreaterEqual(key, &ge_diff);
+        if (node && (ge_diff == SKIPLIST_DIFF_EQ)) {
+            return Iterator(node);
+        }
+        return Iterator();
+    }
+
+    /* `node` is returned by `DoLookupLessThan()` */
+    Iterator GetLessThanIterator(DataNode* node) const {
+        if (node == (DataNode*)(&m_head)) {
+            return Iterator();
+        }
+        return Iterator(node);
+    }
+
+    template <typename KeyType>
+    bool DoSplitAt(const KeyType& key, SkipList* tail) {
+        if (tail == this || !tail->IsEmpty()) {
+            return false;
+        }
+
+        DataNode* update[MAX_LEVEL];
+        DoLookupLessThan(key, nullptr, update);
+        for (uint32_t level = 0; level < m_head.level; ++level) {
+            tail->m_head.forward[level] = update[level]->forward[level];
+            update[level]->forward[level] = nullptr;
+        }
+
+        tail->m_head.level = m_head.level;
+        tail->TrimLevel();
+        TrimLevel();
+        return true;
+    }
+
+    /* `update` is filled with the last nodes whose keys <= `key` */
+    template <typename KeyType>
+    void DoLookupLessEqual(const KeyType& key, DataNode** update) const {
+        auto prev = (DataNode*)(&m_head);
+        for (uint32_t l = prev->level; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto node = prev->forward[level];
+            while (node) {
+                auto pvalue = GetValueFromNode(node);
+                if (m_cmp(m_get_key(*pvalue), key) == SKIPLIST_DIFF_GT) {
+                    break;
+                }
+                prev = node;
+                node = node->forward[level];
+            }
+            update[level] = prev;
+        }
+    }
+
+    /* `node` MUST be the first one */
+    void DoPopFront(DataNode* node) {
+        for (uint32_t level = 0; level < node->level; ++level) {
+            m_head.forward[level] = node->forward[level];
+        }
+
+        auto pvalue = GetValueFromNode(node);
+        const uint64_t node_size = GetNodeSize(node->level);
+        pvalue->~Value();
+        this->DoFree(pvalue, node_size);
+
+        TrimLevel();
+    }
+
+    template <typename KeyType, typename ValueType>
+    bool DoRemove(const KeyType& key, ValueType* value,
+                  uint32_t ge_diff_mask) {
         uint32_t ge_diff = UINT32_MAX;
         DataNode* update[MAX_LEVEL];
         auto node = DoLookupGreaterEqual(key, &ge_diff, update);
@@ -213,31 +710,98 @@ private:
             *value = std::move(*pvalue);
         }
 
+        const uint64_t node_size = GetNodeSize(node->level);
         pvalue->~Value();
-        this->Free(pvalue);
+        this->DoFree(pvalue, node_size);
 
-        while (m_head.level > 0 && !m_head.forward[m_head.level - 1]) {
-            --m_head.level;
+        TrimLevel();
+        return true;
+    }
+
+    /* keeps nodes for which whether its key exists in `other` equals to
+     * `keep_if_exists` */
+    void DoFilter(const SkipList& other, bool keep_if_exists) {
+        auto a = m_head.forward[0];
+        auto b = other.m_head.forward[0];
+        DataNode* tail[MAX_LEVEL];
+        BeginRebuild(tail);
+
+        while (a) {
+            auto next = a->forward[0];
+            auto pvalue = GetValueFromNode(a);
+
+            uint32_t diff = SKIPLIST_DIFF_LT;
+            while (b) {
+                diff = m_cmp(m_get_key(*GetValueFromNode(b)),
+                             m_get_key(*pvalue));
+                if (diff & SKIPLIST_DIFF_GE) {
+                    break;
+                }
+                b = b->forward[0];
+            }
+
+            const bool exists = (b && diff == SKIPLIST_DIFF_EQ);
+            if (exists == keep_if_exists) {
+                AppendNode(a, tail);
+            } else {
+                const uint64_t node_size = GetNodeSize(a->level);
+                pvalue->~Value();
+                this->DoFree(pvalue, node_size);
+            }
+            if (exists) {
+                // each value in `other` matches at most one of duplicates
+                b = b->forward[0];
+            }
+            a = next;
         }
 
-        return true;
+        EndRebuild(tail);
     }
 
-    template <typename ValueType>
-    DataNode* DoInsert(ValueType&& value, DataNode* update[]) {
-        const uint32_t level = GenRandomLevel();
+    /* the following functions relink nodes that are appended in order. the
+     * original links MUST be saved before calling `AppendNode()`. */
+    void BeginRebuild(DataNode* tail[]) {
+        for (uint32_t i = 0; i < MAX_LEVEL; ++i) {
+            tail[i] = (DataNode*)(&m_head);
+        }
+    }
 
-        auto base = (char*)this->Alloc(sizeof(Value) + sizeof(DataNode) +
-                                       (sizeof(DataNode*) * level));
+    void AppendNode(DataNode* node, DataNode* tail[]) {
+        for (uint32_t i = 0; i < node->level; ++i) {
+            tail[i]->forward[i] = node;
+            tail[i] = node;
+        }
+    }
+
+    void EndRebuild(DataNode* tail[]) {
+        for (uint32_t i = 0; i < MAX_LEVEL; ++i) {
+            tail[i]->forward[i] = nullptr;
+        }
+        m_head.level = MAX_LEVEL;
+        TrimLevel();
+    }
+
+    void TrimLevel() {
+        while (m_head.level > 0 && !m_head.forward[m_head.level - 1]) {
+            --m_head.level;
+        }
+    }
+
+    /* the value is not constructed */
+    DataNode* AllocNode(uint32_t level) {
+        auto base = (char*)this->Alloc(GetNodeSize(level));
         if (!base) {
             return nullptr;
         }
-        new (base) Value(std::forward<ValueType>(value));
 
         auto node = (DataNode*)(base + sizeof(Value));
         node->level = level;
         memset(node->forward, 0, sizeof(DataNode*) * level);
+        return node;
+    }
 
+    void LinkNode(DataNode* node, DataNode* update[]) {
+        const uint32_t level = node->level;
         if (level > m_head.level) {
             for (uint32_t i = m_head.level; i < level; ++i) {
                 update[i] = (DataNode*)(&m_head);
@@ -249,7 +813,17 @@ private:
             node->forward[i] = update[i]->forward[i];
             update[i]->forward[i] = node;
         }
+    }
 
+    template <typename... Args>
+    DataNode* DoInsert(DataNode* update[], Args&&... args) {
+        auto node = AllocNode(GenRandomLevel());
+        if (!node) {
+            return nullptr;
+        }
+
+        new (GetValueFromNode(node)) Value(std::forward<Args>(args)...);
+        LinkNode(node, update);
         return node;
     }
 
@@ -258,20 +832,35 @@ private:
         while (cur) {
             auto next = cur->forward[0];
             auto pvalue = GetValueFromNode(cur);
+            const uint64_t node_size = GetNodeSize(cur->level);
             pvalue->~Value();
-            this->Free(pvalue);
+            this->DoFree(pvalue, node_size);
             cur = next;
         }
     }
 
     uint32_t GenRandomLevel() const {
+        if (LEVEL_BITS > 0 && LEVEL_BITS * (MAX_LEVEL - 1) < 64) {
+            /* each run of `LEVEL_BITS` zero bits from the lowest one is a
+             * promotion, so one random number is enough. the sentinel bit
+             * limits the level to `MAX_LEVEL`. */
+            const uint64_t r = xoshiro256ss_next(&m_rand) |
+                (1ull << ((LEVEL_BITS * (MAX_LEVEL - 1)) & 63));
+            return 1 + internal::CountTrailingZeros(r) / LEVEL_BITS;
+        }
+
         uint32_t level = 1;
-        while (level < MAX_LEVEL && xoshiro256ss_next(&m_rand) % 4 == 0) {
+        while (level < MAX_LEVEL &&
+               xoshiro256ss_next(&m_rand) % BranchingFactor == 0) {
             ++level;
         }
         return level;
     }
 
+    static uint64_t GetNodeSize(uint32_t level) {
+        return sizeof(Value) + sizeof(DataNode) + (sizeof(DataNode*) * level);
+    }
+
     static Value* GetValueFromNode(const DataNode* node) {
         return (Value*)((char*)node - sizeof(Value));
     }
@@ -326,17 +915,39 @@ struct GenericComparator final {
 
 template <typename Value,
           typename Comparator = internal::GenericComparator<Value>,
-          typename Allocator = GenericCpuAllocator>
+          typename Allocator = GenericCpuAllocator, uint32_t MaxLevel = 12,
+          uint32_t BranchingFactor = 4>
 using SkipListSet =
     SkipList<Value, Value, Comparator,
-             internal::SkipListReturnSelfFromValue<Value>, Allocator>;
+             internal::SkipListReturnSelfFromValue<Value>, Allocator, false,
+             MaxLevel, BranchingFactor>;
 
 template <typename Key, typename Value,
           typename Comparator = internal::GenericComparator<Key>,
-          typename Allocator = GenericCpuAllocator>
+          typename Allocator = GenericCpuAllocator, uint32_t MaxLevel = 12,
+          uint32_t BranchingFactor = 4>
 using SkipListMap =
     SkipList<Key, std::pair<Key, Value>, Comparator,
-             internal::SkipListReturnFirstOfPair<Key, Value>, Allocator>;
+             internal::SkipListReturnFirstOfPair<Key, Value>, Allocator, false,
+             MaxLevel, BranchingFactor>;
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Allocator = GenericCpuAllocator, uint32_t MaxLevel = 12,
+          uint32_t BranchingFactor = 4>
+using SkipListMultiSet =
+    SkipList<Value, Value, Comparator,
+             internal::SkipListReturnSelfFromValue<Value>, Allocator, true,
+             MaxLevel, BranchingFactor>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Allocator = GenericCpuAllocator, uint32_t MaxLevel = 12,
+          uint32_t BranchingFactor = 4>
+using SkipListMultiMap =
+    SkipList<Key, std::pair<Key, Value>, Comparator,
+             internal::SkipListReturnFirstOfPair<Key, Value>, Allocator, true,
+             MaxLevel, BranchingFactor>;
 
 }
 
@@ -0,0 +1,61 @@
+#ifndef __CPPUTILS_STL_ALLOCATOR_H__
+#define __CPPUTILS_STL_ALLOCATOR_H__
+
+#include "cpputils/allocator.h"
+#include <cstddef>
+#include <new> // std::bad_alloc
+
+namespace cpputils {
+
+/**
+   exposes a `cpputils::Allocator` to STL containers, e.g.
+
+   ArenaAllocator ar;
+   std::vector<int, StlAllocator<int>> vec(StlAllocator<int>(&ar));
+
+   `ar` MUST outlive containers using it.
+*/
+template <typename T>
+class StlAllocator {
+public:
+    typedef T value_type;
+
+public:
+    StlAllocator(Allocator* ar) : m_ar(ar) {}
+
+    template <typename U>
+    StlAllocator(const StlAllocator<U>& other) : m_ar(other.GetAllocator()) {}
+
+    T* allocate(std::size_t n) {
+        auto ptr = m_ar->Alloc(n * sizeof(T), alignof(T));
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return (T*)ptr;
+    }
+
+    void deallocate(T* ptr, std::size_t n) {
+        m_ar->Free(ptr, n * sizeof(T));
+    }
+
+    Allocator* GetAllocator() const {
+        return m_ar;
+    }
+
+private:
+    Allocator* m_ar;
+};
+
+template <typename T, typename U>
+bool operator==(const StlAllocator<T>& a, const StlAllocator<U>& b) {
+    return (a.GetAllocator() == b.GetAllocator());
+}
+
+template <typename T, typename U>
+bool operator!=(const StlAllocator<T>& a, const StlAllocator<U>& b) {
+    return (a.GetAllocator() != b.GetAllocator());
+}
+
+}
+
+#endif
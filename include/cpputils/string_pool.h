@@ -0,0 +1,98 @@
+#ifndef __CPPUTILS_STRING_POOL_H__
+#define __CPPUTILS_STRING_POOL_H__
+
+#include "cpputils/arena_allocator.h"
+#include "cpputils/skiplist.h" // SKIPLIST_DIFF_*
+#include <utility>
+#include <vector>
+
+namespace cpputils {
+
+/**
+   interns strings into arena-backed storage. each distinct string gets a
+   4-byte id, starting from 0 in interning order, and its content is copied
+   only once. ids and the returned spans stay valid until `Clear()`.
+
+   strings are NUL-terminated in the pool but may contain '\0' themselves.
+*/
+class StringPool final {
+public:
+    static constexpr uint32_t INVALID_ID = UINT32_MAX;
+
+public:
+    StringPool(uint64_t block_size = ArenaAllocator::DEFAULT_BLOCK_SIZE)
+        : m_arena(block_size) {}
+
+    /** returns the id of `data`, interning it if not found, or `INVALID_ID`
+     * if there is no memory. */
+    uint32_t Intern(const char* data, unsigned int len);
+
+    /** returns `INVALID_ID` if `data` is not interned. */
+    uint32_t Find(const char* data, unsigned int len) const;
+
+    /** `id` MUST be returned by `Intern()`. */
+    std::pair<const char*, unsigned int> Get(uint32_t id) const {
+        auto entry = &m_entries[id];
+        return std::make_pair(entry->data, entry->len);
+    }
+
+    /** returns the number of distinct strings. */
+    uint32_t size() const {
+        return m_entries.size();
+    }
+
+    /** removes all strings and invalidates all ids. memory is kept for reuse.
+     */
+    void Clear();
+
+    /** returns the number of bytes used by the pool itself and its contents.
+     */
+    uint64_t GetMemoryUsage() const {
+        return m_arena.GetAllocatedSize() +
+            m_entries.capacity() * sizeof(Entry) +
+            m_slots.capacity() * sizeof(Slot);
+    }
+
+private:
+    struct Entry final {
+        const char* data;
+        unsigned int len;
+    };
+
+    struct Slot final {
+        uint32_t hash;
+        uint32_t id; // `INVALID_ID` if empty
+    };
+
+    uint32_t DoFind(const char* data, unsigned int len, uint32_t hash,
+                    uint32_t* slot_idx) const;
+    bool Grow();
+
+private:
+    ArenaAllocator m_arena;
+    std::vector<Entry> m_entries; // indexed by id
+    std::vector<Slot> m_slots; // open addressing with linear probing
+
+private:
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+};
+
+/**
+   compares ids returned by the same `StringPool` as a `SkipList` comparator,
+   e.g. `SkipListMap<uint32_t, uint64_t, StringPoolIdComparator>`. equal ids
+   mean equal strings, and the order is the interning order rather than the
+   lexicographical one.
+*/
+struct StringPoolIdComparator final {
+    uint32_t operator()(uint32_t a, uint32_t b) const {
+        if (a == b) {
+            return SKIPLIST_DIFF_EQ;
+        }
+        return (a < b) ? SKIPLIST_DIFF_LT : SKIPLIST_DIFF_GT;
+    }
+};
+
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef __CPPUTILS_STRING_UTILS_H__
 #define __CPPUTILS_STRING_UTILS_H__
 
+#include <stdint.h>
 #include <cstring>
 #include <string>
 #include <vector>
@@ -8,6 +9,7 @@
 
 namespace cpputils {
 
+/** returns `text` unchanged if `search` or `replace` is empty. */
 std::string StringReplace(const char* text, unsigned int tlen,
                           const char* search, unsigned int slen,
                           const char* replace, unsigned int rlen);
@@ -18,6 +20,71 @@ bool StringEndsWith(const char* text, unsigned int tlen, const char* suffix,
 // reutrns the number of chars removed at the end of `text`
 unsigned int StringTrim(const char* text, unsigned int tlen, char c);
 
+/* a set of bytes, stored as a 16x16 bitmap indexed by nibbles */
+class ByteSet final {
+public:
+    ByteSet() {
+        memset(m_table, 0, sizeof(m_table));
+    }
+    ByteSet(const char* chars, unsigned int n) : ByteSet() {
+        for (unsigned int i = 0; i < n; ++i) {
+            Add(chars[i]);
+        }
+    }
+
+    void Add(char c) {
+        const uint8_t b = c;
+        m_table[GetIndex(b)] |= (uint8_t)(1 << ((b >> 4) & 7));
+    }
+
+    bool Contains(char c) const {
+        const uint8_t b = c;
+        return (m_table[GetIndex(b)] >> ((b >> 4) & 7)) & 1;
+    }
+
+    /* bit (h & 7) of byte [(h >> 3) * 16 + l] is set if byte (h << 4 | l) is
+     * in the set */
+    const uint8_t* table() const {
+        return m_table;
+    }
+
+    /* ' ', '\t', '\n', '\v', '\f' and '\r' */
+    static ByteSet Whitespace() {
+        return ByteSet(" \t\n\v\f\r", 6);
+    }
+
+private:
+    static unsigned int GetIndex(uint8_t b) {
+        return (b >> 7) * 16 + (b & 0xf);
+    }
+
+private:
+    uint8_t m_table[32];
+};
+
+// returns the number of chars in `chars` removed at the beginning of `text`
+unsigned int StringTrimLeft(const char* text, unsigned int tlen,
+                            const ByteSet& chars);
+// returns the number of chars in `chars` removed at the end of `text`
+unsigned int StringTrimRight(const char* text, unsigned int tlen,
+                             const ByteSet& chars);
+// removes chars in `chars` at both ends
+std::pair<const char*, unsigned int>
+StringTrimBoth(const char* text, unsigned int tlen, const ByteSet& chars);
+
+// return `tlen` if not found
+unsigned int StringFindFirstOf(const char* text, unsigned int tlen,
+                               const ByteSet& chars);
+unsigned int StringFindFirstNotOf(const char* text, unsigned int tlen,
+                                  const ByteSet& chars);
+
+unsigned int StringCount(const char* text, unsigned int tlen, char c);
+unsigned int StringCount(const char* text, unsigned int tlen,
+                         const ByteSet& chars);
+
+/* a wyhash-style 64-bit hash. not for cryptographic use. */
+uint64_t StringHash(const char* text, unsigned int tlen, uint64_t seed = 0);
+
 class StringSplitter final {
 public:
     StringSplitter() : m_cursor(nullptr), m_end(nullptr) {}
@@ -35,6 +102,53 @@ private:
     const char* m_end;
 };
 
+/**
+   `StringReplace()` over a stream of chunks with constant memory. output is
+   passed to the sink piece by piece as soon as it is determined, and only the
+   last `slen - 1` bytes of input are kept for matches across chunks.
+
+   unlike `StringReplace()`, which returns the text unchanged if `replace` is
+   empty, an empty `replace` deletes every match.
+*/
+class StringReplacer final {
+public:
+    /** returns false to stop. */
+    typedef std::function<bool(const char* data, unsigned int len)> Sink;
+
+public:
+    /** `slen` MUST be > 0. */
+    StringReplacer(const char* search, unsigned int slen, const char* replace,
+                   unsigned int rlen, const Sink& sink)
+        : m_search(search, slen), m_replace(replace, rlen), m_sink(sink) {}
+
+    /** returns false if the sink stops. */
+    bool Feed(const char* data, uint64_t len);
+
+    /**
+       feeds [offset, offset + len) of `filename` mapped by `FileMapping` in
+       windows of `window_size` bytes, so at most one window is mapped at a
+       time.
+    */
+    bool FeedFile(const char* filename, uint64_t offset = 0,
+                  uint64_t len = UINT64_MAX,
+                  uint64_t window_size = 64 * 1024 * 1024,
+                  std::string* errmsg = nullptr);
+
+    /** flushes the kept bytes and resets for another stream. */
+    bool Finish();
+
+private:
+    unsigned int Process(const char* text, unsigned int tlen, bool is_last,
+                         bool* ok);
+    bool DoFeed(const char* data, unsigned int len);
+
+private:
+    const std::string m_search;
+    const std::string m_replace;
+    Sink m_sink;
+    std::string m_carry; // at most `slen - 1` bytes not processed yet
+};
+
 }
 
 #endif
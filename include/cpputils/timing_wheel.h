@@ -0,0 +1,217 @@
+#ifndef __CPPUTILS_TIMING_WHEEL_H__
+#define __CPPUTILS_TIMING_WHEEL_H__
+
+#include "cpputils/bit_utils.h"
+#include <stdint.h>
+#include <utility>
+
+namespace cpputils {
+
+/** embedded in objects scheduled by `TimingWheel`, which never allocates
+ * memory for timers. a pending timer MUST be cancelled before destroyed. */
+class TimerNode {
+public:
+    TimerNode() {}
+
+    bool IsPending() const {
+        return (m_next != nullptr);
+    }
+
+    /** the tick at which the timer expires, valid if pending */
+    uint64_t GetExpireTick() const {
+        return m_expire;
+    }
+
+private:
+    friend class TimingWheel;
+    TimerNode* m_prev = nullptr;
+    TimerNode* m_next = nullptr;
+    uint64_t m_expire = 0;
+
+private:
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+};
+
+/**
+   a hierarchical timing wheel with `LEVEL_NUM` levels of `SLOT_NUM` slots.
+   like `RingBuffer`, each level is a ring indexed by ticks modulo its size;
+   level l covers timers expiring within `SLOT_NUM`^(l + 1) ticks, and its
+   slots are cascaded into lower levels as time goes on. each slot is an
+   intrusive list, so that adding and cancelling a timer are O(1) and
+   advancing is amortized O(1) per tick and timer.
+
+   timers expiring later than the range of the wheel are kept in the last
+   level and cascaded again. not thread safe.
+*/
+class TimingWheel final {
+private:
+    static constexpr uint32_t SLOT_BITS = 6;
+    static constexpr uint32_t SLOT_NUM = (1u << SLOT_BITS);
+    static constexpr uint64_t SLOT_MASK = SLOT_NUM - 1;
+    static constexpr uint32_t LEVEL_NUM = 6;
+    static constexpr uint64_t MAX_DELTA =
+        (1ull << (SLOT_BITS * LEVEL_NUM)) - 1;
+
+public:
+    /**
+       @param tick_ns length of a tick in nanoseconds.
+       @param now_ns start time, which is the current time of the monotonic
+       clock by default.
+    */
+    TimingWheel(uint64_t tick_ns = 1000000, uint64_t now_ns = UINT64_MAX);
+
+    /** nanoseconds of `std::chrono::steady_clock` */
+    static uint64_t GetMonotonicTime();
+
+    /**
+       @brief schedules `node` to expire `delay_ns` later than the current
+       time of the wheel, rounded up to ticks. a pending `node` is
+       rescheduled.
+    */
+    void Add(TimerNode* node, uint64_t delay_ns) {
+        AddAtTick(node, m_now + (delay_ns + m_tick_ns - 1) / m_tick_ns);
+    }
+
+    /** schedules `node` to expire at `tick`, or at the next tick if `tick`
+     * has passed. */
+    void AddAtTick(TimerNode* node, uint64_t tick) {
+        if (node->IsPending()) {
+            Unlink(node);
+        } else {
+            ++m_size;
+        }
+        node->m_expire = tick;
+        Link(node);
+    }
+
+    /** returns false if `node` is not pending. */
+    bool Cancel(TimerNode* node) {
+        if (!node->IsPending()) {
+            return false;
+        }
+        Unlink(node);
+        node->m_prev = node->m_next = nullptr;
+        --m_size;
+        return true;
+    }
+
+    /**
+       @brief expires timers up to `now_ns`. timers of a slot are detached
+       together and passed to `callback(TimerNode*)` one by one. the callback
+       can add or cancel any timer, including the expired one.
+       @return the number of timers expired.
+    */
+    template <typename Callback>
+    uint64_t Advance(uint64_t now_ns, Callback&& callback) {
+        if (now_ns < m_base_ns) {
+            return 0;
+        }
+
+        const uint64_t target = (now_ns - m_base_ns) / m_tick_ns;
+        uint64_t count = 0;
+        while (m_now <= target) {
+            if (m_size == 0) {
+                m_now = target + 1;
+                break;
+            }
+
+            const uint64_t idx = m_now & SLOT_MASK;
+            if (idx == 0) {
+                Cascade();
+            }
+
+            // skips empty slots until the next cascade or `target`
+            const uint64_t bits = m_bitmap[0] >> idx;
+            if (!(bits & 1)) {
+                uint64_t next;
+                if (m_bitmap[0] == 0) {
+                    next = GetNextCascadeTick();
+                } else {
+                    next = m_now +
+                        (bits ? internal::CountTrailingZeros(bits) :
+                                SLOT_NUM - idx);
+                }
+                m_now = (next > target) ? target + 1 : next;
+                continue;
+            }
+
+            TimerNode batch;
+            Detach(0, idx, &batch);
+            ++m_now;
+            while (batch.m_next != &batch) {
+                auto node = batch.m_next;
+                Unlink(node);
+                node->m_prev = node->m_next = nullptr;
+                --m_size;
+                ++count;
+                callback(node);
+            }
+        }
+        return count;
+    }
+
+    /** advances to the current time of the monotonic clock. */
+    template <typename Callback>
+    uint64_t Advance(Callback&& callback) {
+        return Advance(GetMonotonicTime(), std::forward<Callback>(callback));
+    }
+
+    /** the next tick to be processed */
+    uint64_t GetCurrentTick() const {
+        return m_now;
+    }
+
+    uint64_t GetTickLength() const {
+        return m_tick_ns;
+    }
+
+    /** the number of pending timers */
+    uint64_t size() const {
+        return m_size;
+    }
+
+    bool IsEmpty() const {
+        return (m_size == 0);
+    }
+
+private:
+    static void Unlink(TimerNode* node) {
+        node->m_prev->m_next = node->m_next;
+        node->m_next->m_prev = node->m_prev;
+    }
+
+    static void PushBack(TimerNode* head, TimerNode* node) {
+        node->m_prev = head->m_prev;
+        node->m_next = head;
+        head->m_prev->m_next = node;
+        head->m_prev = node;
+    }
+
+    void Link(TimerNode* node);
+    /* moves all timers of a slot into the empty list `batch` */
+    void Detach(uint32_t level, uint64_t idx, TimerNode* batch);
+    /* moves timers of higher levels that expire within the range of lower
+     * levels down, at ticks where `m_now` is a multiple of `SLOT_NUM` */
+    void Cascade();
+    /* the first tick after `m_now` at which a slot of higher levels may be
+     * cascaded */
+    uint64_t GetNextCascadeTick() const;
+
+private:
+    const uint64_t m_tick_ns;
+    uint64_t m_base_ns; // time of tick 0
+    uint64_t m_now = 0;
+    uint64_t m_size = 0;
+    /* bits of slots that may be non-empty */
+    uint64_t m_bitmap[LEVEL_NUM] = {0};
+    TimerNode m_slots[LEVEL_NUM][SLOT_NUM]; // heads of circular lists
+
+private:
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+};
+
+}
+
+#endif
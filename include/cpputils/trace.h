@@ -0,0 +1,213 @@
+#ifndef __CPPUTILS_TRACE_H__
+#define __CPPUTILS_TRACE_H__
+
+#include "cpputils/guard.h"
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#else
+#include <time.h>
+#endif
+
+namespace cpputils {
+
+/*
+  scoped tracing spans. each thread appends events to its own
+  `SeqlockRingBuffer` without locking or allocating, except for creating the
+  buffer on its first event, and a `TraceCollector` drains buffers of all
+  threads. events that are overwritten before being collected are dropped.
+
+  spans are recorded only if `CPPUTILS_ENABLE_TRACING` is defined; otherwise
+  `TraceSpan` is an empty object and costs nothing.
+*/
+
+struct TraceEvent final {
+    /** MUST live until collected, e.g. a string literal. collectors keep
+     * copies of names. */
+    const char* name;
+    uint64_t begin; // ticks returned by `TraceNow()`
+    uint64_t end;
+};
+
+/** ticks of the TSC on x86, which is assumed to be invariant and synchronized
+ * among cores, or nanoseconds of the monotonic clock otherwise. */
+inline uint64_t TraceNow() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/** appends an event to the buffer of the calling thread. */
+void TraceRecord(const char* name, uint64_t begin, uint64_t end);
+
+/** capacity of buffers created by threads after this call. default: 4096. */
+void SetTraceBufferCapacity(uint32_t capacity);
+
+namespace internal {
+
+struct TraceSpanEnd final {
+    void operator()() const {
+        TraceRecord(name, begin, TraceNow());
+    }
+    const char* name;
+    uint64_t begin;
+};
+
+}
+
+/** records the lifetime of this object as an event named `name`. */
+class TraceSpan final {
+public:
+#ifdef CPPUTILS_ENABLE_TRACING
+    explicit TraceSpan(const char* name)
+        : m_guard(internal::TraceSpanEnd{name, TraceNow()}) {}
+
+private:
+    Guard<internal::TraceSpanEnd> m_guard;
+#else
+    explicit TraceSpan(const char*) {}
+#endif
+
+private:
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+/**
+   a log-linear histogram like HdrHistogram. values are grouped by powers of 2,
+   each of which is split into 2^`SUB_BITS` buckets, so that the relative error
+   of percentiles is less than 1 / 2^`SUB_BITS`.
+*/
+class TraceHistogram final {
+private:
+    static constexpr uint32_t SUB_BITS = 4;
+    static constexpr uint32_t BUCKET_NUM = (64 - SUB_BITS + 1) << SUB_BITS;
+
+public:
+    TraceHistogram() : m_counts(BUCKET_NUM, 0) {}
+
+    void Record(uint64_t value);
+
+    /** @param percentile in [0, 100] */
+    uint64_t GetPercentile(double percentile) const;
+
+    uint64_t GetCount() const {
+        return m_count;
+    }
+    uint64_t GetMin() const {
+        return m_min;
+    }
+    uint64_t GetMax() const {
+        return m_max;
+    }
+    double GetMean() const {
+        return m_count ? (double)m_sum / m_count : 0;
+    }
+
+private:
+    static uint32_t GetBucket(uint64_t value);
+    static uint64_t GetBucketLowerBound(uint32_t bucket);
+
+private:
+    std::vector<uint64_t> m_counts;
+    uint64_t m_count = 0;
+    uint64_t m_sum = 0;
+    uint64_t m_min = UINT64_MAX;
+    uint64_t m_max = 0;
+};
+
+/**
+   drains events of all threads, keeps them for `ExportChromeTrace()` and adds
+   their durations in nanoseconds to histograms by name. collectors drain
+   buffers one at a time, and each event is collected by one of them.
+
+   the buffer of an exited thread is released only after being drained by
+   `Collect()`, so that a collector created later still gets its events.
+   programs that trace in many short-lived threads SHOULD keep a collector
+   running, e.g. by `Start()`; otherwise every exited thread keeps its buffer.
+*/
+class TraceCollector final {
+public:
+    /** @param max_events events kept for `ExportChromeTrace()`. later events
+     * are added to histograms only. */
+    TraceCollector(uint64_t max_events = 1000000) : m_max_events(max_events) {}
+
+    ~TraceCollector() {
+        Stop();
+    }
+
+    /** collects events in the calling thread. returns the number of events
+     * collected. */
+    uint64_t Collect();
+
+    /** collects events every `interval_ms` milliseconds in a background
+     * thread until `Stop()` is called. */
+    bool Start(uint32_t interval_ms, std::string* errmsg = nullptr);
+
+    /** stops the background thread, if any, after a final collection. */
+    void Stop();
+
+    /** appends collected events in the chrome trace event format, which can
+     * be opened by `chrome://tracing` or perfetto. */
+    void ExportChromeTrace(std::string* output) const;
+
+    /** histograms of durations in nanoseconds by name */
+    std::map<std::string, TraceHistogram> GetHistograms() const;
+
+    /** the number of events overwritten before being collected */
+    uint64_t GetDroppedCount() const;
+
+    void Clear();
+
+private:
+    struct Event final {
+        const std::string* name; // key of `m_histograms`
+        uint32_t tid;
+        uint64_t ts; // nanoseconds since the first trace call
+        uint64_t dur;
+    };
+
+    void AddEvent(const TraceEvent& e, uint32_t tid, double ns_per_tick);
+
+private:
+    const uint64_t m_max_events;
+    mutable std::mutex m_lock; // protects the following members
+    std::vector<Event> m_events;
+    std::map<std::string, TraceHistogram> m_histograms;
+    /* names are usually literals, so that looking up by pointers first
+     * avoids building strings. entries are checked by contents because
+     * addresses may be reused by other names. */
+    std::unordered_map<const char*,
+                       std::pair<const std::string, TraceHistogram>*>
+        m_name_cache;
+    uint64_t m_dropped = 0;
+
+    std::thread m_thread;
+    std::mutex m_thread_lock;
+    std::condition_variable m_thread_cond;
+    bool m_stop = false;
+
+private:
+    TraceCollector(const TraceCollector&) = delete;
+    TraceCollector& operator=(const TraceCollector&) = delete;
+};
+
+}
+
+#endif
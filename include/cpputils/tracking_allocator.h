@@ -0,0 +1,217 @@
+#ifndef __CPPUTILS_TRACKING_ALLOCATOR_H__
+#define __CPPUTILS_TRACKING_ALLOCATOR_H__
+
+#include "cpputils/generic_cpu_allocator.h"
+#include <atomic>
+#include <string>
+#include <utility>
+
+namespace cpputils {
+
+static constexpr uint32_t ALLOC_STATS_SIZE_CLASS_NUM = 20;
+
+struct AllocStats final {
+    uint64_t live_bytes = 0;
+    uint64_t peak_bytes = 0;
+    uint64_t alloc_count = 0;
+    uint64_t free_count = 0;
+    /** `Free(ptr)` without size. `live_bytes` is not decreased by them. */
+    uint64_t unsized_free_count = 0;
+    /** size_histogram[i] is the number of allocations of [2^i, 2^(i+1))
+     * bytes, except that the first class includes 0 and the last one
+     * includes all sizes larger than its lower bound. */
+    uint64_t size_histogram[ALLOC_STATS_SIZE_CLASS_NUM] = {0};
+};
+
+/** appends `stats` to `output` in the prometheus text format, with label
+ * `allocator=name`. */
+void ExportAllocStats(const AllocStats& stats, const char* name,
+                      std::string* output);
+
+/**
+   counts allocations made through `Base`, which can be any
+   `cpputils::Allocator`, e.g. `SkipListSet<int, Cmp,
+   TrackingAllocator<ArenaAllocator>>`.
+
+   counters are updated only if `CPPUTILS_ENABLE_ALLOC_TRACKING` is defined;
+   otherwise every function forwards to `Base` directly and `GetStats()`
+   returns zeros. counters of different threads are kept in different cache
+   lines, including live bytes, so that no cache line is shared by all
+   threads. `peak_bytes` is the sum of high-water marks of shards, which is
+   exact if memory is freed by threads sharing a shard with the one that
+   allocated it. otherwise it is only an upper bound, and it grows without
+   limit if some threads keep allocating memory freed by others, e.g.
+   producers and consumers, even if `live_bytes` stays flat. `ResetStats()`
+   does not help then, because live bytes of the producers' shards grow as
+   well. `peak_bytes` SHOULD NOT be used for such workloads.
+
+   sized and aligned requests go through `Base::DoAlloc()`/`Base::DoFree()`,
+   so `Base` SHOULD override them without calling `Alloc()`/`Free()` of its
+   own, as all allocators of this library do; otherwise they are counted
+   twice.
+*/
+template <typename Base = GenericCpuAllocator>
+class TrackingAllocator : public Base {
+private:
+    static constexpr uint32_t SHARD_NUM = 8;
+
+    struct alignas(64) Shard final {
+        std::atomic<uint64_t> alloc_count;
+        std::atomic<uint64_t> free_count;
+        std::atomic<uint64_t> unsized_free_count;
+        /* negative if memory allocated in other shards is freed here */
+        std::atomic<int64_t> live_bytes{0};
+        std::atomic<int64_t> peak_bytes{0};
+        std::atomic<uint64_t> size_histogram[ALLOC_STATS_SIZE_CLASS_NUM];
+    };
+
+public:
+    template <typename... Args>
+    TrackingAllocator(Args&&... args) : Base(std::forward<Args>(args)...) {
+        ResetStats();
+    }
+
+    void* Alloc(uint64_t bytes) override {
+        auto ptr = Base::Alloc(bytes);
+        OnAlloc(ptr, bytes);
+        return ptr;
+    }
+
+    void Free(void* ptr) override {
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+        if (ptr) {
+            auto shard = GetShard();
+            Increase(&shard->free_count, 1);
+            Increase(&shard->unsized_free_count, 1);
+        }
+#endif
+        Base::Free(ptr);
+    }
+
+    using Allocator::Alloc;
+    using Allocator::Free;
+
+    AllocStats GetStats() const {
+        AllocStats stats;
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+        int64_t live = 0, peak = 0;
+        for (uint32_t i = 0; i < SHARD_NUM; ++i) {
+            auto shard = &m_shards[i];
+            live += shard->live_bytes.load(std::memory_order_relaxed);
+            peak += shard->peak_bytes.load(std::memory_order_relaxed);
+            stats.alloc_count +=
+                shard->alloc_count.load(std::memory_order_relaxed);
+            stats.free_count +=
+                shard->free_count.load(std::memory_order_relaxed);
+            stats.unsized_free_count +=
+                shard->unsized_free_count.load(std::memory_order_relaxed);
+            for (uint32_t j = 0; j < ALLOC_STATS_SIZE_CLASS_NUM; ++j) {
+                stats.size_histogram[j] +=
+                    shard->size_histogram[j].load(std::memory_order_relaxed);
+            }
+        }
+        // shards are read one by one, so that the sums may be inconsistent
+        if (peak < live) {
+            peak = live;
+        }
+        stats.live_bytes = (live > 0) ? live : 0;
+        stats.peak_bytes = (peak > 0) ? peak : 0;
+#endif
+        return stats;
+    }
+
+    /** resets all counters except `live_bytes`. `peak_bytes` is set to
+     * `live_bytes`. */
+    void ResetStats() {
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+        for (uint32_t i = 0; i < SHARD_NUM; ++i) {
+            auto shard = &m_shards[i];
+            shard->alloc_count.store(0, std::memory_order_relaxed);
+            shard->free_count.store(0, std::memory_order_relaxed);
+            shard->unsized_free_count.store(0, std::memory_order_relaxed);
+            shard->peak_bytes.store(
+                shard->live_bytes.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            for (uint32_t j = 0; j < ALLOC_STATS_SIZE_CLASS_NUM; ++j) {
+                shard->size_histogram[j].store(0, std::memory_order_relaxed);
+            }
+        }
+#endif
+    }
+
+protected:
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override {
+        auto ptr = Base::DoAlloc(bytes, alignment);
+        OnAlloc(ptr, bytes);
+        return ptr;
+    }
+
+    void DoFree(void* ptr, uint64_t bytes) override {
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+        if (ptr) {
+            auto shard = GetShard();
+            Increase(&shard->free_count, 1);
+            shard->live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+#endif
+        Base::DoFree(ptr, bytes);
+    }
+
+private:
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+    static void Increase(std::atomic<uint64_t>* counter, uint64_t n) {
+        counter->fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static uint32_t GetSizeClass(uint64_t bytes) {
+        uint32_t c = 0;
+        while (bytes > 1 && c < ALLOC_STATS_SIZE_CLASS_NUM - 1) {
+            bytes >>= 1;
+            ++c;
+        }
+        return c;
+    }
+
+    Shard* GetShard() {
+        static std::atomic<uint32_t> s_thread_counter(0);
+        static thread_local uint32_t s_shard_idx =
+            s_thread_counter.fetch_add(1, std::memory_order_relaxed) %
+            SHARD_NUM;
+        return &m_shards[s_shard_idx];
+    }
+#endif
+
+    void OnAlloc(void* ptr, uint64_t bytes) {
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+        if (!ptr) {
+            return;
+        }
+
+        auto shard = GetShard();
+        Increase(&shard->alloc_count, 1);
+        Increase(&shard->size_histogram[GetSizeClass(bytes)], 1);
+
+        // only threads of the same shard race on the high-water mark
+        const int64_t live =
+            shard->live_bytes.fetch_add(bytes, std::memory_order_relaxed) +
+            bytes;
+        auto peak = shard->peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak &&
+               !shard->peak_bytes.compare_exchange_weak(
+                   peak, live, std::memory_order_relaxed)) {
+        }
+#else
+        (void)ptr;
+        (void)bytes;
+#endif
+    }
+
+#ifdef CPPUTILS_ENABLE_ALLOC_TRACKING
+private:
+    Shard m_shards[SHARD_NUM];
+#endif
+};
+
+}
+
+#endif
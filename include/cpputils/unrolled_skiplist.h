@@ -0,0 +1,433 @@
+#ifndef __CPPUTILS_UNROLLED_SKIPLIST_H__
+#define __CPPUTILS_UNROLLED_SKIPLIST_H__
+
+#include "skiplist.h"
+
+namespace cpputils {
+
+/*
+  a skiplist whose data nodes hold up to `NodeCapacity` sorted values each.
+  towers are built over nodes and indexed by the first value of each node, so
+  scans touch one node per `NodeCapacity` values. nodes are split when
+  inserting into a full one and merged with their successors when they become
+  less than a quarter full.
+
+  `Comparator` is the same as `SkipList`. inserting or removing a value
+  invalidates iterators pointing to the same node.
+*/
+template <typename Key, typename Value, typename Comparator,
+          typename GetKeyFromValue, typename Allocator,
+          uint32_t NodeCapacity = 32>
+class UnrolledSkipList final : public Allocator {
+private:
+    static constexpr uint32_t MAX_LEVEL = 12;
+
+    static_assert(NodeCapacity >= 4, "`NodeCapacity` MUST be at least 4.");
+
+private:
+    struct DataNode final {
+        uint32_t level;
+        uint32_t size;
+        DataNode* forward[0];
+    };
+
+    struct HeadNode final {
+        uint32_t level;
+        uint32_t size;
+        DataNode* forward[MAX_LEVEL];
+    };
+
+    /* values are placed before `DataNode` like `SkipList` does. */
+    static constexpr uint64_t VALUES_SIZE =
+        (sizeof(Value) * NodeCapacity + alignof(DataNode) - 1) &
+        ~(alignof(DataNode) - 1);
+
+public:
+    class Iterator final {
+    public:
+        Value* operator->() {
+            return &GetValues(m_node)[m_idx];
+        }
+        const Value* operator->() const {
+            return &GetValues(m_node)[m_idx];
+        }
+        Value& operator*() {
+            return GetValues(m_node)[m_idx];
+        }
+        const Value& operator*() const {
+            return GetValues(m_node)[m_idx];
+        }
+        bool operator==(const Iterator& it) const {
+            return (m_node == it.m_node && m_idx == it.m_idx);
+        }
+        bool operator!=(const Iterator& it) const {
+            return !(*this == it);
+        }
+        void operator++() {
+            ++m_idx;
+            if (m_idx == m_node->size) {
+                m_node = m_node->forward[0];
+                m_idx = 0;
+            }
+        }
+
+    private:
+        friend class UnrolledSkipList;
+        Iterator(DataNode* node = nullptr, uint32_t idx = 0)
+            : m_node(node), m_idx(idx) {}
+
+    private:
+        DataNode* m_node;
+        uint32_t m_idx;
+    };
+
+public:
+    UnrolledSkipList() {
+        xoshiro256ss_init(&m_rand, (uintptr_t)this);
+        memset(&m_head, 0, sizeof(HeadNode));
+    }
+
+    ~UnrolledSkipList() {
+        DoDestroy();
+    }
+
+    template <typename ValueType>
+    std::pair<Iterator, bool> Insert(ValueType&& value) {
+        const Key& key = m_get_key(value);
+
+        DataNode* update[MAX_LEVEL];
+        auto node = DoLookupLessEqual(key, update);
+        if (node == GetHead()) {
+            node = m_head.forward[0];
+            if (!node) {
+                node = DoInsertNode(update);
+                if (!node) {
+                    return std::pair<Iterator, bool>(Iterator(), false);
+                }
+            }
+            // `node` becomes the predecessor of the new node if it is split
+            for (uint32_t i = 0; i < node->level; ++i) {
+                update[i] = node;
+            }
+        }
+
+        uint32_t ge_diff = UINT32_MAX;
+        uint32_t idx = LowerBound(node, key, &ge_diff);
+        if (idx < node->size && ge_diff == SKIPLIST_DIFF_EQ) {
+            return std::pair<Iterator, bool>(Iterator(node, idx), false);
+        }
+
+        if (node->size == NodeCapacity) {
+            auto new_node = DoInsertNode(update);
+            if (!new_node) {
+                return std::pair<Iterator, bool>(Iterator(), false);
+            }
+
+            // moves the upper half to the new node
+            const uint32_t half = NodeCapacity / 2;
+            MoveValues(GetValues(node) + half, NodeCapacity - half,
+                       GetValues(new_node));
+            node->size = half;
+            new_node->size = NodeCapacity - half;
+
+            if (idx > half) {
+                node = new_node;
+                idx -= half;
+            }
+        }
+
+        auto values = GetValues(node);
+        for (uint32_t i = node->size; i > idx; --i) {
+            new (&values[i]) Value(std::move(values[i - 1]));
+            values[i - 1].~Value();
+        }
+        new (&values[idx]) Value(std::forward<ValueType>(value));
+        ++node->size;
+
+        return std::pair<Iterator, bool>(Iterator(node, idx), true);
+    }
+
+    template <typename ValueType = Value>
+    bool Remove(const Key& key, ValueType* value = nullptr) {
+        DataNode* update[MAX_LEVEL];
+        auto node = DoLookupLessThan(key, update);
+
+        uint32_t ge_diff = UINT32_MAX;
+        uint32_t idx;
+        auto next = node->forward[0];
+        if (next && m_cmp(m_get_key(GetValues(next)[0]), key) ==
+                SKIPLIST_DIFF_EQ) {
+            node = next;
+            idx = 0;
+        } else {
+            if (node == GetHead()) {
+                return false;
+            }
+            idx = LowerBound(node, key, &ge_diff);
+            if (idx == node->size || ge_diff != SKIPLIST_DIFF_EQ) {
+                return false;
+            }
+        }
+
+        auto values = GetValues(node);
+        if (value) {
+            *value = std::move(values[idx]);
+        }
+        values[idx].~Value();
+        for (uint32_t i = idx + 1; i < node->size; ++i) {
+            new (&values[i - 1]) Value(std::move(values[i]));
+            values[i].~Value();
+        }
+        --node->size;
+
+        if (node->size == 0) {
+            // only happens if `node` is the successor of `update[0]`
+            DoRemoveNode(node, update);
+            return true;
+        }
+
+        next = node->forward[0];
+        if (next && node->size < NodeCapacity / 4 &&
+            node->size + next->size <= NodeCapacity * 3 / 4) {
+            MoveValues(GetValues(next), next->size, values + node->size);
+            node->size += next->size;
+            next->size = 0;
+
+            for (uint32_t i = 0; i < node->level; ++i) {
+                update[i] = node;
+            }
+            DoRemoveNode(next, update);
+        }
+
+        return true;
+    }
+
+    void Clear() {
+        DoDestroy();
+        memset(&m_head, 0, sizeof(HeadNode));
+    }
+
+    Iterator Lookup(const Key& key) const {
+        auto node = DoLookupLessEqual(key);
+        if (node == GetHead()) {
+            return Iterator();
+        }
+
+        uint32_t ge_diff = UINT32_MAX;
+        uint32_t idx = LowerBound(node, key, &ge_diff);
+        if (idx < node->size && ge_diff == SKIPLIST_DIFF_EQ) {
+            return Iterator(node, idx);
+        }
+        return Iterator();
+    }
+
+    Iterator LookupGreaterEqual(const Key& key) const {
+        auto node = DoLookupLessEqual(key);
+        if (node == GetHead()) {
+            return Iterator(m_head.forward[0]);
+        }
+
+        uint32_t idx = LowerBound(node, key);
+        if (idx < node->size) {
+            return Iterator(node, idx);
+        }
+        return Iterator(node->forward[0]);
+    }
+
+    Iterator LookupLessThan(const Key& key) const {
+        auto node = DoLookupLessThan(key);
+        if (node == GetHead()) {
+            return Iterator();
+        }
+        // the first value of `node` is less than `key`
+        return Iterator(node, LowerBound(node, key) - 1);
+    }
+
+    bool IsEmpty() const {
+        return (m_head.level == 0);
+    }
+
+    Iterator GetBeginIterator() const {
+        return Iterator(m_head.forward[0]);
+    }
+
+    Iterator GetEndIterator() const {
+        return Iterator();
+    }
+
+private:
+    DataNode* GetHead() const {
+        return (DataNode*)(&m_head);
+    }
+
+    /* returns the last node whose first value is less than (or equal to, if
+     * `or_equal` is true) `key` */
+    DataNode* DoLookup(const Key& key, bool or_equal,
+                       DataNode** update) const {
+        const uint32_t stop_mask =
+            or_equal ? SKIPLIST_DIFF_GT : SKIPLIST_DIFF_GE;
+
+        auto prev = GetHead();
+        for (uint32_t l = prev->level; l > 0; --l) {
+            const uint32_t level = l - 1;
+            auto node = prev->forward[level];
+            while (node) {
+                uint32_t diff = m_cmp(m_get_key(GetValues(node)[0]), key);
+                if (diff & stop_mask) {
+                    break;
+                }
+                prev = node;
+                node = node->forward[level];
+            }
+
+            if (update) {
+                update[level] = prev;
+            }
+        }
+
+        return prev;
+    }
+
+    DataNode* DoLookupLessThan(const Key& key,
+                               DataNode** update = nullptr) const {
+        return DoLookup(key, false, update);
+    }
+
+    DataNode* DoLookupLessEqual(const Key& key,
+                                DataNode** update = nullptr) const {
+        return DoLookup(key, true, update);
+    }
+
+    /* returns the index of the first value in `node` which is not less than
+     * `key`. `ge_diff` is the diff of that value. */
+    uint32_t LowerBound(const DataNode* node, const Key& key,
+                        uint32_t* ge_diff = nullptr) const {
+        auto values = GetValues(node);
+        uint32_t begin = 0, end = node->size;
+        while (begin < end) {
+            uint32_t mid = begin + (end - begin) / 2;
+            uint32_t diff = m_cmp(m_get_key(values[mid]), key);
+            if (diff & SKIPLIST_DIFF_GE) {
+                end = mid;
+                if (ge_diff) {
+                    *ge_diff = diff;
+                }
+            } else {
+                begin = mid + 1;
+            }
+        }
+        return begin;
+    }
+
+    static void MoveValues(Value* src, uint32_t n, Value* dst) {
+        for (uint32_t i = 0; i < n; ++i) {
+            new (&dst[i]) Value(std::move(src[i]));
+            src[i].~Value();
+        }
+    }
+
+    /* inserts an empty node after `update[]` */
+    DataNode* DoInsertNode(DataNode* update[]) {
+        const uint32_t level = GenRandomLevel();
+
+        auto base = (char*)this->Alloc(GetNodeSize(level));
+        if (!base) {
+            return nullptr;
+        }
+
+        auto node = (DataNode*)(base + VALUES_SIZE);
+        node->level = level;
+        node->size = 0;
+        memset(node->forward, 0, sizeof(DataNode*) * level);
+
+        if (level > m_head.level) {
+            for (uint32_t i = m_head.level; i < level; ++i) {
+                update[i] = GetHead();
+            }
+            m_head.level = level;
+        }
+
+        for (uint32_t i = 0; i < level; ++i) {
+            node->forward[i] = update[i]->forward[i];
+            update[i]->forward[i] = node;
+        }
+
+        return node;
+    }
+
+    /* `node` MUST be empty and `update[]` are its predecessors */
+    void DoRemoveNode(DataNode* node, DataNode* update[]) {
+        for (uint32_t level = 0; level < node->level; ++level) {
+            update[level]->forward[level] = node->forward[level];
+        }
+
+        this->DoFree((char*)node - VALUES_SIZE, GetNodeSize(node->level));
+
+        while (m_head.level > 0 && !m_head.forward[m_head.level - 1]) {
+            --m_head.level;
+        }
+    }
+
+    void DoDestroy() {
+        DataNode* cur = m_head.forward[0];
+        while (cur) {
+            auto next = cur->forward[0];
+            auto values = GetValues(cur);
+            for (uint32_t i = 0; i < cur->size; ++i) {
+                values[i].~Value();
+            }
+            this->DoFree((char*)cur - VALUES_SIZE, GetNodeSize(cur->level));
+            cur = next;
+        }
+    }
+
+    uint32_t GenRandomLevel() const {
+        uint32_t level = 1;
+        while (level < MAX_LEVEL && xoshiro256ss_next(&m_rand) % 4 == 0) {
+            ++level;
+        }
+        return level;
+    }
+
+    static uint64_t GetNodeSize(uint32_t level) {
+        return VALUES_SIZE + sizeof(DataNode) + (sizeof(DataNode*) * level);
+    }
+
+    static Value* GetValues(const DataNode* node) {
+        return (Value*)((char*)node - VALUES_SIZE);
+    }
+
+private:
+    HeadNode m_head;
+    Comparator m_cmp;
+    GetKeyFromValue m_get_key;
+    mutable Xoshiro256ss m_rand;
+
+private:
+    UnrolledSkipList(const UnrolledSkipList&) = delete;
+    UnrolledSkipList& operator=(const UnrolledSkipList&) = delete;
+};
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Value,
+          typename Comparator = internal::GenericComparator<Value>,
+          typename Allocator = GenericCpuAllocator,
+          uint32_t NodeCapacity = 32>
+using UnrolledSkipListSet =
+    UnrolledSkipList<Value, Value, Comparator,
+                     internal::SkipListReturnSelfFromValue<Value>, Allocator,
+                     NodeCapacity>;
+
+template <typename Key, typename Value,
+          typename Comparator = internal::GenericComparator<Key>,
+          typename Allocator = GenericCpuAllocator,
+          uint32_t NodeCapacity = 32>
+using UnrolledSkipListMap =
+    UnrolledSkipList<Key, std::pair<Key, Value>, Comparator,
+                     internal::SkipListReturnFirstOfPair<Key, Value>,
+                     Allocator, NodeCapacity>;
+
+}
+
+#endif
@@ -0,0 +1,91 @@
+#include "cpputils/arena_allocator.h"
+#include <cstddef> // max_align_t
+#include <cstdlib>
+using namespace std;
+
+namespace cpputils {
+
+static constexpr uint64_t ARENA_ALIGNMENT = alignof(max_align_t);
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/* returns the offset of the first `alignment`-aligned address since
+ * `base + offset` */
+static inline uint64_t GetAlignedOffset(const char* base, uint64_t offset,
+                                        uint64_t alignment) {
+    return AlignUp((uintptr_t)base + offset, alignment) - (uintptr_t)base;
+}
+
+void* ArenaAllocator::AllocFromBlocks(uint64_t bytes, uint64_t alignment) {
+    if (m_cur < m_blocks.size()) {
+        auto block = &m_blocks[m_cur];
+        auto offset = GetAlignedOffset(block->base, m_offset, alignment);
+        if (offset <= block->size && block->size - offset >= bytes) {
+            m_offset = offset + bytes;
+            return block->base + offset;
+        }
+
+        // blocks left by `Reset()` are reused in order
+        ++m_cur;
+        m_offset = 0;
+        if (m_cur < m_blocks.size()) {
+            block = &m_blocks[m_cur];
+            offset = GetAlignedOffset(block->base, 0, alignment);
+            if (offset <= block->size && block->size - offset >= bytes) {
+                m_offset = offset + bytes;
+                return block->base + offset;
+            }
+        }
+    }
+
+    // a new block is inserted before the (too small) unused ones so that the
+    // same allocation pattern after `Reset()` doesn't allocate again
+    uint64_t size = bytes;
+    if (alignment > ARENA_ALIGNMENT) {
+        size += alignment - ARENA_ALIGNMENT;
+    }
+    if (size < m_block_size) {
+        size = m_block_size;
+    }
+
+    auto base = (char*)::malloc(size);
+    if (!base) {
+        return nullptr;
+    }
+
+    Block block;
+    block.base = base;
+    block.size = size;
+    m_blocks.insert(m_blocks.begin() + m_cur, block);
+    m_allocated_size += size;
+
+    auto offset = GetAlignedOffset(base, 0, alignment);
+    m_offset = offset + bytes;
+    return base + offset;
+}
+
+void* ArenaAllocator::DoAlloc(uint64_t bytes, uint64_t alignment) {
+    if (alignment < ARENA_ALIGNMENT) {
+        alignment = ARENA_ALIGNMENT;
+    }
+    bytes = (bytes == 0) ? ARENA_ALIGNMENT : AlignUp(bytes, ARENA_ALIGNMENT);
+    return AllocFromBlocks(bytes, alignment);
+}
+
+void* ArenaAllocator::Alloc(uint64_t bytes) {
+    return ArenaAllocator::DoAlloc(bytes, ARENA_ALIGNMENT);
+}
+
+void ArenaAllocator::Release() {
+    for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+        ::free(it->base);
+    }
+    m_blocks.clear();
+    m_allocated_size = 0;
+    m_offset = 0;
+    m_cur = 0;
+}
+
+}
@@ -0,0 +1,115 @@
+#include "cpputils/bloom_filter.h"
+#include "cpputils/generic_cpu_allocator.h"
+#include <cstring>
+using namespace std;
+
+namespace cpputils {
+
+/* odd multipliers from the parquet split block bloom filter */
+static const uint32_t BLOOM_SALT[8] = {
+    0x47b6137b, 0x44974d91, 0x8824ad5b, 0xa2b7289d,
+    0x705495c7, 0x2df1424b, 0x9efc4947, 0x5c6bfb31,
+};
+
+/* blocks are cache line aligned so that a block never spans two lines */
+static constexpr uint64_t BLOOM_BLOCK_ALIGNMENT = 64;
+
+/* the block index is computed from 32 bits of the hash */
+static constexpr uint64_t BLOOM_MAX_BLOCK_NUM = UINT32_MAX;
+
+BloomFilter::BloomFilter(BloomFilter&& f) {
+    m_blocks = f.m_blocks;
+    m_block_num = f.m_block_num;
+    m_capacity = f.m_capacity;
+    f.m_blocks = nullptr;
+    f.m_block_num = 0;
+    f.m_capacity = 0;
+}
+
+BloomFilter& BloomFilter::operator=(BloomFilter&& f) {
+    if (&f != this) {
+        Destroy();
+        m_blocks = f.m_blocks;
+        m_block_num = f.m_block_num;
+        m_capacity = f.m_capacity;
+        f.m_blocks = nullptr;
+        f.m_block_num = 0;
+        f.m_capacity = 0;
+    }
+    return *this;
+}
+
+bool BloomFilter::Init(uint64_t key_num, uint32_t bits_per_key) {
+    if (bits_per_key == 0) {
+        bits_per_key = DEFAULT_BITS_PER_KEY;
+    }
+
+    const uint64_t bits_per_block = sizeof(Block) * 8;
+    uint64_t block_num =
+        (key_num * bits_per_key + bits_per_block - 1) / bits_per_block;
+    if (block_num == 0) {
+        block_num = 1;
+    } else if (block_num > BLOOM_MAX_BLOCK_NUM) {
+        block_num = BLOOM_MAX_BLOCK_NUM;
+    }
+
+    GenericCpuAllocator allocator;
+    if (block_num != m_block_num) {
+        auto blocks = (Block*)allocator.Alloc(block_num * sizeof(Block),
+                                              BLOOM_BLOCK_ALIGNMENT);
+        if (!blocks) {
+            return false;
+        }
+        Destroy();
+        m_blocks = blocks;
+        m_block_num = block_num;
+    }
+
+    m_capacity = block_num * bits_per_block / bits_per_key;
+    Clear();
+    return true;
+}
+
+void BloomFilter::Destroy() {
+    if (m_blocks) {
+        GenericCpuAllocator().Free(m_blocks, m_block_num * sizeof(Block));
+        m_blocks = nullptr;
+        m_block_num = 0;
+        m_capacity = 0;
+    }
+}
+
+void BloomFilter::Add(uint64_t hash) {
+    if (!m_blocks) {
+        return;
+    }
+
+    auto block = GetBlock(hash);
+    const uint32_t key = (uint32_t)hash;
+    for (uint32_t i = 0; i < 8; ++i) {
+        block->words[i] |= (uint32_t)1 << ((key * BLOOM_SALT[i]) >> 27);
+    }
+}
+
+bool BloomFilter::MayContain(uint64_t hash) const {
+    if (!m_blocks) {
+        return true;
+    }
+
+    auto block = GetBlock(hash);
+    const uint32_t key = (uint32_t)hash;
+    uint32_t missing = 0;
+    for (uint32_t i = 0; i < 8; ++i) {
+        const uint32_t bit = (uint32_t)1 << ((key * BLOOM_SALT[i]) >> 27);
+        missing |= (~block->words[i] & bit);
+    }
+    return (missing == 0);
+}
+
+void BloomFilter::Clear() {
+    if (m_blocks) {
+        memset(m_blocks, 0, m_block_num * sizeof(Block));
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+#include "cpu_features.h"
+
+#ifdef CPPUTILS_X86_DISPATCH
+#include <cpuid.h>
+#endif
+
+namespace cpputils { namespace internal {
+
+#ifdef CPPUTILS_X86_DISPATCH
+static uint64_t GetXcr0() {
+    uint32_t eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static uint32_t DetectCpuFeatures() {
+    uint32_t eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return 0;
+    }
+
+    uint32_t features = 0;
+    if (ecx & bit_SSE4_2) {
+        features |= CPU_FEATURE_SSE42;
+    }
+
+    // the os MUST save ymm/zmm registers
+    if (!(ecx & bit_OSXSAVE)) {
+        return features;
+    }
+    const uint64_t xcr0 = GetXcr0();
+    const bool ymm_enabled = ((xcr0 & 0x6) == 0x6);
+    const bool zmm_enabled = ((xcr0 & 0xe6) == 0xe6);
+
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return features;
+    }
+    if (ymm_enabled && (ebx & bit_AVX2)) {
+        features |= CPU_FEATURE_AVX2;
+    }
+    if (zmm_enabled && (ebx & bit_AVX512F) && (ebx & bit_AVX512BW)) {
+        features |= CPU_FEATURE_AVX512BW;
+    }
+
+    return features;
+}
+#else
+static uint32_t DetectCpuFeatures() {
+    return 0;
+}
+#endif
+
+uint32_t GetCpuFeatures() {
+    static const uint32_t s_features = DetectCpuFeatures();
+    return s_features;
+}
+
+}}
@@ -0,0 +1,25 @@
+#ifndef __CPPUTILS_CPU_FEATURES_H__
+#define __CPPUTILS_CPU_FEATURES_H__
+
+#include <stdint.h>
+
+/* runtime dispatch is supported for x86 with gcc or clang only */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CPPUTILS_X86_DISPATCH
+#endif
+
+namespace cpputils { namespace internal {
+
+static constexpr uint32_t CPU_FEATURE_SSE42 = 1;
+static constexpr uint32_t CPU_FEATURE_AVX2 = 2;
+/* avx512f and avx512bw */
+static constexpr uint32_t CPU_FEATURE_AVX512BW = 4;
+
+/** detected on the first call. features not supported by the os are
+ * excluded. */
+uint32_t GetCpuFeatures();
+
+}}
+
+#endif
@@ -0,0 +1,206 @@
+#include "cpputils/csv_tokenizer.h"
+#include <cstring>
+using namespace std;
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __PCLMUL__
+#include <wmmintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace cpputils {
+
+static constexpr unsigned int BLOCK_SIZE = 64;
+
+/* bit i is set if block[i] == c */
+static inline uint64_t GetCharMask(const char* block, char c) {
+#ifdef __SSE2__
+    const __m128i v = _mm_set1_epi8(c);
+    uint64_t mask = 0;
+    for (unsigned int i = 0; i < BLOCK_SIZE; i += 16) {
+        auto data = _mm_loadu_si128((const __m128i*)(block + i));
+        uint64_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(data, v));
+        mask |= (m << i);
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    for (unsigned int i = 0; i < BLOCK_SIZE; ++i) {
+        mask |= ((uint64_t)(block[i] == c) << i);
+    }
+    return mask;
+#endif
+}
+
+/* bit i of the result is the xor of bits [0, i] of `x` */
+static inline uint64_t PrefixXor(uint64_t x) {
+#ifdef __PCLMUL__
+    auto r = _mm_clmulepi64_si128(_mm_set_epi64x(0, x), _mm_set1_epi8(-1), 0);
+    return _mm_cvtsi128_si64(r);
+#else
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+#endif
+}
+
+static inline unsigned int CountTrailingZeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, x);
+    return idx;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+static inline unsigned int CountOnes(uint64_t x) {
+#ifdef _MSC_VER
+    return (unsigned int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+void CsvTokenizer::Reset(const char* s, unsigned int l) {
+    m_text = s;
+    m_len = l;
+    m_field_begin = 0;
+    m_after_delim = false;
+    m_block_begin = 0;
+    m_block_end = 0;
+    m_sep_mask = 0;
+    m_quote_mask = 0;
+    m_in_quote = 0;
+}
+
+void CsvTokenizer::LoadBlock() {
+    m_block_begin = m_block_end;
+    m_block_end += BLOCK_SIZE;
+
+    const char* block = m_text + m_block_begin;
+    const uint64_t left = m_len - m_block_begin;
+
+    char buf[BLOCK_SIZE];
+    uint64_t valid_mask = UINT64_MAX;
+    if (left < BLOCK_SIZE) {
+        memcpy(buf, block, left);
+        memset(buf + left, 0, BLOCK_SIZE - left);
+        block = buf;
+        valid_mask = (1ull << left) - 1;
+    }
+
+    const uint64_t quote_mask = GetCharMask(block, m_quote) & valid_mask;
+    m_quote_mask = quote_mask;
+    const uint64_t in_quote = PrefixXor(quote_mask) ^ m_in_quote;
+    m_in_quote = (uint64_t)((int64_t)in_quote >> 63);
+
+    const uint64_t sep_mask =
+        GetCharMask(block, m_delim) | GetCharMask(block, '\n');
+    m_sep_mask = sep_mask & valid_mask & ~in_quote;
+}
+
+void CsvTokenizer::SetField(unsigned int begin, unsigned int end, bool is_last,
+                            CsvField* field) const {
+    if (is_last && end > begin && m_text[end - 1] == '\r') {
+        --end;
+    }
+
+    const char* data = m_text + begin;
+    unsigned int size = end - begin;
+    bool need_unescape = false;
+
+    unsigned int quote_num;
+    if (begin >= m_block_begin) {
+        // the field is in the current block
+        const unsigned int shift = begin - m_block_begin;
+        const uint64_t mask = (size >= BLOCK_SIZE) ? UINT64_MAX
+                                                   : ((1ull << size) - 1);
+        // `begin` is `m_block_end` for an empty field at the end of a block,
+        // and shifting by 64 bits is undefined
+        quote_num = (shift >= BLOCK_SIZE)
+            ? 0
+            : CountOnes((m_quote_mask >> shift) & mask);
+    } else if (data[0] == m_quote || memchr(data, m_quote, size)) {
+        quote_num = (size >= 2 && data[0] == m_quote &&
+                     data[size - 1] == m_quote &&
+                     !memchr(data + 1, m_quote, size - 2))
+            ? 2
+            : UINT32_MAX;
+    } else {
+        quote_num = 0;
+    }
+
+    if (quote_num > 0) {
+        if (quote_num == 2 && data[0] == m_quote &&
+            data[size - 1] == m_quote) {
+            ++data;
+            size -= 2;
+        } else {
+            need_unescape = true;
+        }
+    }
+
+    field->data = data;
+    field->size = size;
+    field->need_unescape = need_unescape;
+    field->is_last = is_last;
+}
+
+bool CsvTokenizer::Next(CsvField* field) {
+    if (m_field_begin > m_len) {
+        return false;
+    }
+
+    while (!m_sep_mask) {
+        if (m_block_end >= m_len) {
+            // no separators after the last field
+            if (m_field_begin == m_len && !m_after_delim) {
+                m_field_begin = m_len + 1;
+                return false;
+            }
+            SetField(m_field_begin, m_len, true, field);
+            m_field_begin = m_len + 1;
+            return true;
+        }
+        LoadBlock();
+    }
+
+    const unsigned int pos = m_block_begin + CountTrailingZeros(m_sep_mask);
+    m_sep_mask &= (m_sep_mask - 1);
+
+    const bool is_last = (m_text[pos] == '\n');
+    SetField(m_field_begin, pos, is_last, field);
+    m_field_begin = pos + 1;
+    m_after_delim = !is_last;
+    return true;
+}
+
+void CsvUnescape(const char* data, unsigned int size, string* out,
+                 char quote) {
+    out->clear();
+    out->reserve(size);
+
+    bool in_quote = false;
+    for (unsigned int i = 0; i < size; ++i) {
+        const char c = data[i];
+        if (c != quote) {
+            out->push_back(c);
+        } else if (in_quote && i + 1 < size && data[i + 1] == quote) {
+            out->push_back(quote);
+            ++i;
+        } else {
+            in_quote = !in_quote;
+        }
+    }
+}
+
+}
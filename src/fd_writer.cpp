@@ -0,0 +1,75 @@
+#ifndef _MSC_VER
+
+#include "cpputils/fd_writer.h"
+#include <cstring>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+using namespace std;
+
+namespace cpputils {
+
+FdWriter::FdWriter(int fd, uint32_t buffer_size)
+    : m_fd(fd), m_capacity(buffer_size), m_buf(new char[buffer_size]) {}
+
+FdWriter::~FdWriter() {
+    Flush();
+    delete[] m_buf;
+}
+
+/* writes the buffer and `data` in order, retrying short writes */
+bool FdWriter::WriteAll(const char* data, uint64_t len) {
+    struct iovec iov[2];
+    iov[0].iov_base = m_buf;
+    iov[0].iov_len = m_size;
+    iov[1].iov_base = (void*)data;
+    iov[1].iov_len = len;
+
+    struct iovec* cur = (m_size > 0) ? iov : iov + 1;
+    int iov_num = (m_size > 0) ? 2 : 1;
+    if (len == 0) {
+        --iov_num;
+    }
+
+    while (iov_num > 0) {
+        const ssize_t ret = writev(m_fd, cur, iov_num);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+
+        m_written += ret;
+        size_t n = ret;
+        while (iov_num > 0 && n >= cur->iov_len) {
+            n -= cur->iov_len;
+            ++cur;
+            --iov_num;
+        }
+        if (iov_num > 0) {
+            cur->iov_base = (char*)cur->iov_base + n;
+            cur->iov_len -= n;
+        }
+    }
+
+    m_size = 0;
+    return true;
+}
+
+bool FdWriter::Write(const char* data, uint64_t len) {
+    if (len <= m_capacity - m_size) {
+        memcpy(m_buf + m_size, data, len);
+        m_size += len;
+        return true;
+    }
+    return WriteAll(data, len);
+}
+
+bool FdWriter::Flush() {
+    return WriteAll(nullptr, 0);
+}
+
+}
+
+#endif
@@ -49,10 +49,10 @@ void FileMapping::DoMove(FileMapping&& fm) {
     fm.m_base = nullptr;
 
 #ifdef _MSC_VER
-    m_file_handle = nullptr;
-    m_file_map_handle = nullptr;
+    fm.m_file_handle = nullptr;
+    fm.m_file_map_handle = nullptr;
 #else
-    m_fd = -1;
+    fm.m_fd = -1;
 #endif
 }
 
@@ -263,8 +263,9 @@ bool FileMapping::Init(const char* filename, uint32_t permission,
     }
 
     mapped_len = len + (offset - mapping_start_offset);
-    m_base =
-        mmap(NULL, mapped_len, flags, MAP_PRIVATE, fd, mapping_start_offset);
+    m_base = mmap(NULL, mapped_len, flags,
+                  (permission & FileMapping::SHARED) ? MAP_SHARED : MAP_PRIVATE,
+                  fd, mapping_start_offset);
     if (m_base != MAP_FAILED) {
         m_fd = fd;
         m_start = (char*)m_base + (offset - mapping_start_offset);
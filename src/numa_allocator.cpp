@@ -0,0 +1,286 @@
+#ifdef __linux__
+
+#include "cpputils/numa_allocator.h"
+#include <cstring>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+using namespace std;
+
+namespace cpputils {
+
+// from <numaif.h>, which is provided by libnuma
+static constexpr int NUMA_MPOL_BIND = 2;
+
+/*
+  every region starts at a `REGION_ALIGNMENT`-aligned address with a
+  `RegionHeader`, so the header of any block can be found by masking its
+  address.
+*/
+static constexpr uint64_t REGION_ALIGNMENT = 64 * 1024;
+static constexpr uint64_t REGION_HEADER_SIZE = 64;
+static constexpr uint64_t SIZE_CLASS_GRANULARITY = 16;
+static constexpr uint64_t MAX_SMALL_SIZE = 2048;
+static constexpr uint32_t SIZE_CLASS_NUM =
+    MAX_SMALL_SIZE / SIZE_CLASS_GRANULARITY;
+
+struct RegionHeader final {
+    uint32_t node;
+    uint32_t block_size; // 0 for regions containing one large block
+    uint64_t size;
+};
+
+struct FreeBlock final {
+    FreeBlock* next;
+};
+
+struct SizeClass final {
+    FreeBlock* free_list;
+    char* cursor; // unused area of the latest slab
+    char* end;
+};
+
+struct NumaAllocator::NodeState final {
+    SizeClass classes[SIZE_CLASS_NUM];
+    vector<void*> slabs;
+};
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+static void BindToNode(void* addr, uint64_t len, uint32_t node) {
+    unsigned long mask = (1UL << node);
+    syscall(SYS_mbind, addr, len, NUMA_MPOL_BIND, &mask,
+            NumaAllocator::MAX_NODE_NUM + 1, 0);
+}
+
+/* `size` MUST be a multiple of the page size. */
+static RegionHeader* MapRegion(uint64_t size, uint32_t node,
+                               uint32_t block_size) {
+    const uint64_t mapped_size = size + REGION_ALIGNMENT;
+    auto base = (char*)mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return nullptr;
+    }
+
+    auto start = (char*)AlignUp((uintptr_t)base, REGION_ALIGNMENT);
+    if (start > base) {
+        munmap(base, start - base);
+    }
+    auto end = start + size;
+    if (end < base + mapped_size) {
+        munmap(end, base + mapped_size - end);
+    }
+
+    // pages are not touched until the policy is set
+    BindToNode(start, size, node);
+
+    auto header = (RegionHeader*)start;
+    header->node = node;
+    header->block_size = block_size;
+    header->size = size;
+    return header;
+}
+
+static inline RegionHeader* GetRegionHeader(void* ptr) {
+    return (RegionHeader*)((uintptr_t)ptr & ~(REGION_ALIGNMENT - 1));
+}
+
+uint32_t NumaAllocator::GetCurrentNode() {
+    unsigned int cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+        return 0;
+    }
+    return node;
+}
+
+NumaAllocator::NumaAllocator(int node) : m_node(node) {
+    for (uint32_t i = 0; i < MAX_NODE_NUM; ++i) {
+        m_nodes[i] = nullptr;
+        m_usage[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+NumaAllocator::~NumaAllocator() {
+    for (uint32_t i = 0; i < MAX_NODE_NUM; ++i) {
+        auto state = m_nodes[i];
+        if (state) {
+            for (auto it = state->slabs.begin(); it != state->slabs.end();
+                 ++it) {
+                munmap(*it, REGION_ALIGNMENT);
+            }
+            delete state;
+        }
+    }
+}
+
+NumaAllocator::NodeState* NumaAllocator::GetNodeState(uint32_t node) {
+    auto state = m_nodes[node];
+    if (!state) {
+        state = new NodeState();
+        memset(state->classes, 0, sizeof(state->classes));
+        m_nodes[node] = state;
+    }
+    return state;
+}
+
+void* NumaAllocator::DoAlloc(uint64_t bytes, uint64_t alignment) {
+    uint32_t node = (m_node == LOCAL_NODE) ? GetCurrentNode() : m_node;
+    if (node >= MAX_NODE_NUM) {
+        node = 0;
+    }
+
+    if (alignment < SIZE_CLASS_GRANULARITY) {
+        alignment = SIZE_CLASS_GRANULARITY;
+    }
+
+    // blocks of a slab are aligned to their size, up to the header size
+    if (alignment <= REGION_HEADER_SIZE && bytes <= MAX_SMALL_SIZE) {
+        const uint64_t block_size =
+            AlignUp((bytes == 0) ? 1 : bytes, alignment);
+        if (block_size <= MAX_SMALL_SIZE) {
+            void* ptr;
+            {
+                lock_guard<mutex> lck(m_lock);
+                auto state = GetNodeState(node);
+                auto sc =
+                    &state->classes[block_size / SIZE_CLASS_GRANULARITY - 1];
+                if (sc->free_list) {
+                    ptr = sc->free_list;
+                    sc->free_list = sc->free_list->next;
+                } else {
+                    if (sc->cursor + block_size > sc->end) {
+                        auto header =
+                            MapRegion(REGION_ALIGNMENT, node, block_size);
+                        if (!header) {
+                            return nullptr;
+                        }
+                        state->slabs.push_back(header);
+                        sc->cursor = (char*)header + REGION_HEADER_SIZE;
+                        sc->end = (char*)header + REGION_ALIGNMENT;
+                    }
+                    ptr = sc->cursor;
+                    sc->cursor += block_size;
+                }
+            }
+
+            m_usage[node].fetch_add(block_size, std::memory_order_relaxed);
+            return ptr;
+        }
+    }
+
+    if (alignment >= REGION_ALIGNMENT) {
+        return nullptr;
+    }
+
+    const uint64_t offset = AlignUp(REGION_HEADER_SIZE, alignment);
+    const uint64_t size = AlignUp(offset + bytes, sysconf(_SC_PAGE_SIZE));
+    auto header = MapRegion(size, node, 0);
+    if (!header) {
+        return nullptr;
+    }
+
+    m_usage[node].fetch_add(size, std::memory_order_relaxed);
+    return (char*)header + offset;
+}
+
+void* NumaAllocator::Alloc(uint64_t bytes) {
+    return NumaAllocator::DoAlloc(bytes, SIZE_CLASS_GRANULARITY);
+}
+
+void NumaAllocator::Free(void* ptr) {
+    if (!ptr) {
+        return;
+    }
+
+    auto header = GetRegionHeader(ptr);
+    const uint32_t node = header->node;
+    if (header->block_size == 0) {
+        m_usage[node].fetch_sub(header->size, std::memory_order_relaxed);
+        munmap(header, header->size);
+        return;
+    }
+
+    const uint32_t block_size = header->block_size;
+    {
+        lock_guard<mutex> lck(m_lock);
+        auto sc = &m_nodes[node]->classes[block_size / SIZE_CLASS_GRANULARITY -
+                                          1];
+        auto block = (FreeBlock*)ptr;
+        block->next = sc->free_list;
+        sc->free_list = block;
+    }
+    m_usage[node].fetch_sub(block_size, std::memory_order_relaxed);
+}
+
+void NumaAllocator::DoFree(void* ptr, uint64_t) {
+    NumaAllocator::Free(ptr);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool NumaVMAllocator::Init(uint64_t max_size, string* errmsg) {
+    if (m_base) {
+        if (errmsg) {
+            *errmsg = "duplicated init";
+        }
+        return false;
+    }
+
+    max_size = AlignUp(max_size, sysconf(_SC_PAGE_SIZE));
+    auto base = mmap(nullptr, max_size, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        if (errmsg) {
+            *errmsg = strerror(errno);
+        }
+        return false;
+    }
+
+    m_base = base;
+    m_reserved_size = max_size;
+    m_allocated_size = 0;
+    return true;
+}
+
+void NumaVMAllocator::Destroy() {
+    if (m_base) {
+        munmap(m_base, m_reserved_size);
+        m_base = nullptr;
+        m_reserved_size = 0;
+        m_allocated_size = 0;
+        memset(m_usage, 0, sizeof(m_usage));
+    }
+}
+
+uint64_t NumaVMAllocator::Extend(uint64_t needed) {
+    needed = AlignUp(needed, sysconf(_SC_PAGE_SIZE));
+    if (needed > m_reserved_size - m_allocated_size) {
+        return 0;
+    }
+
+    auto addr = (char*)m_base + m_allocated_size;
+    if (mprotect(addr, needed, PROT_READ | PROT_WRITE) != 0) {
+        return 0;
+    }
+
+    uint32_t node = (m_node == NumaAllocator::LOCAL_NODE)
+        ? NumaAllocator::GetCurrentNode()
+        : m_node;
+    if (node >= NumaAllocator::MAX_NODE_NUM) {
+        node = 0;
+    }
+    BindToNode(addr, needed, node);
+
+    m_allocated_size += needed;
+    m_usage[node] += needed;
+    return needed;
+}
+
+}
+
+#endif // __linux__
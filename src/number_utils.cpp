@@ -0,0 +1,475 @@
+#include "cpputils/number_utils.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#ifdef __GLIBC__
+#include <locale.h>
+#endif
+using namespace std;
+
+namespace cpputils {
+
+#if defined(_MSC_VER) ||                                                      \
+    (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define CPPUTILS_SWAR_DIGITS
+#endif
+
+#ifdef CPPUTILS_SWAR_DIGITS
+/* checks 8 chars at once. see https://lemire.me/blog/2018/09/30/ */
+static inline bool IsEightDigits(uint64_t v) {
+    return (((v & 0xf0f0f0f0f0f0f0f0) |
+             (((v + 0x0606060606060606) & 0xf0f0f0f0f0f0f0f0) >> 4)) ==
+            0x3333333333333333);
+}
+
+/* the first char is in the lowest byte */
+static inline uint32_t ParseEightDigits(uint64_t v) {
+    const uint64_t mask = 0x000000ff000000ff;
+    const uint64_t mul1 = 100 + (1000000ull << 32);
+    const uint64_t mul2 = 1 + (10000ull << 32);
+    v -= 0x3030303030303030;
+    v = (v * 10) + (v >> 8);
+    v = (((v & mask) * mul1) + (((v >> 16) & mask) * mul2)) >> 32;
+    return (uint32_t)v;
+}
+#endif
+
+/* parses at most 19 digits, which never overflow */
+static inline bool ParseDigits(const char* p, const char* end,
+                               uint64_t* value) {
+    uint64_t v = *value;
+#ifdef CPPUTILS_SWAR_DIGITS
+    while (end - p >= 8) {
+        uint64_t chunk;
+        memcpy(&chunk, p, 8);
+        if (!IsEightDigits(chunk)) {
+            return false;
+        }
+        v = v * 100000000 + ParseEightDigits(chunk);
+        p += 8;
+    }
+#endif
+    for (; p < end; ++p) {
+        const uint32_t d = (uint8_t)(*p - '0');
+        if (d > 9) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+    *value = v;
+    return true;
+}
+
+bool ParseUInt(const char* s, unsigned int len, uint64_t* value) {
+    if (len == 0) {
+        return false;
+    }
+
+    const char* end = s + len;
+    while (s < end && *s == '0') {
+        ++s;
+    }
+
+    const unsigned int digit_num = end - s;
+    if (digit_num > 20) {
+        return false;
+    }
+
+    uint64_t v = 0;
+    if (digit_num < 20) {
+        if (!ParseDigits(s, end, &v)) {
+            return false;
+        }
+    } else {
+        if (!ParseDigits(s, end - 1, &v)) {
+            return false;
+        }
+        const uint32_t d = (uint8_t)(end[-1] - '0');
+        if (d > 9 || v > (UINT64_MAX - d) / 10) {
+            return false;
+        }
+        v = v * 10 + d;
+    }
+
+    *value = v;
+    return true;
+}
+
+bool ParseInt(const char* s, unsigned int len, int64_t* value) {
+    if (len == 0) {
+        return false;
+    }
+
+    bool negative = false;
+    if (*s == '-' || *s == '+') {
+        negative = (*s == '-');
+        ++s;
+        --len;
+    }
+
+    uint64_t v;
+    if (!ParseUInt(s, len, &v)) {
+        return false;
+    }
+
+    if (negative) {
+        if (v > (uint64_t)INT64_MAX + 1) {
+            return false;
+        }
+        *value = (int64_t)(0 - v);
+    } else {
+        if (v > (uint64_t)INT64_MAX) {
+            return false;
+        }
+        *value = (int64_t)v;
+    }
+    return true;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static bool StrToDouble(const char* s, unsigned int len, double* value) {
+    if (len == 0 || *s == ' ' || (*s >= '\t' && *s <= '\r')) {
+        return false;
+    }
+
+    char buf[128];
+    string str;
+    const char* cstr;
+    if (len < sizeof(buf)) {
+        memcpy(buf, s, len);
+        buf[len] = '\0';
+        cstr = buf;
+    } else {
+        str.assign(s, len);
+        cstr = str.c_str();
+    }
+
+    char* endptr = nullptr;
+#ifdef __GLIBC__
+    static locale_t s_c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    *value = strtod_l(cstr, &endptr, s_c_locale);
+#else
+    *value = strtod(cstr, &endptr);
+#endif
+    return (endptr == cstr + len);
+}
+
+static const double g_exact_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+static constexpr uint64_t MAX_EXACT_INTEGER = (1ull << 53);
+
+/*
+  handles the common cases with Clinger's fast path: if the decimal mantissa
+  and the power of 10 are both exactly representable as doubles, a single
+  multiplication or division is correctly rounded. other cases fall back to
+  strtod() in the "C" locale.
+*/
+bool ParseDouble(const char* s, unsigned int len, double* value) {
+    const char* p = s;
+    const char* end = s + len;
+
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int64_t exp10 = 0;
+    uint32_t digit_num = 0; // significant digits in `mantissa`
+    bool has_digit = false, truncated = false;
+
+    for (; p < end; ++p) {
+        const uint32_t d = (uint8_t)(*p - '0');
+        if (d > 9) {
+            break;
+        }
+        has_digit = true;
+        if (digit_num < 19) {
+            mantissa = mantissa * 10 + d;
+            digit_num += (mantissa > 0);
+        } else {
+            ++exp10;
+            truncated |= (d > 0);
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end; ++p) {
+            const uint32_t d = (uint8_t)(*p - '0');
+            if (d > 9) {
+                break;
+            }
+            has_digit = true;
+            if (digit_num < 19) {
+                mantissa = mantissa * 10 + d;
+                digit_num += (mantissa > 0);
+                --exp10;
+            } else {
+                truncated |= (d > 0);
+            }
+        }
+    }
+
+    if (!has_digit) {
+        return StrToDouble(s, len, value); // inf, nan, etc.
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        bool exp_negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            exp_negative = (*p == '-');
+            ++p;
+        }
+        if (p == end) {
+            return false;
+        }
+        int64_t e = 0;
+        for (; p < end; ++p) {
+            const uint32_t d = (uint8_t)(*p - '0');
+            if (d > 9) {
+                return false;
+            }
+            if (e < 100000) {
+                e = e * 10 + d;
+            }
+        }
+        exp10 += (exp_negative ? -e : e);
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    if (mantissa == 0 && !truncated) {
+        *value = (negative ? -0.0 : 0.0);
+        return true;
+    }
+
+#if FLT_EVAL_METHOD == 0
+    if (!truncated && mantissa <= MAX_EXACT_INTEGER) {
+        double v = (double)mantissa;
+        bool done = true;
+        if (exp10 < 0) {
+            if (exp10 >= -22) {
+                v /= g_exact_pow10[-exp10];
+            } else {
+                done = false;
+            }
+        } else if (exp10 <= 22) {
+            v *= g_exact_pow10[exp10];
+        } else if (exp10 <= 22 + 15) {
+            // moves some zeros into the mantissa if it stays exact
+            const uint64_t m = mantissa * (uint64_t)g_exact_pow10[exp10 - 22];
+            if (m <= MAX_EXACT_INTEGER &&
+                m / (uint64_t)g_exact_pow10[exp10 - 22] == mantissa) {
+                v = (double)m * 1e22;
+            } else {
+                done = false;
+            }
+        } else {
+            done = false;
+        }
+
+        if (done) {
+            *value = (negative ? -v : v);
+            return true;
+        }
+    }
+#endif
+
+    return StrToDouble(s, len, value);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const char g_digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static inline unsigned int CountDigits(uint64_t v) {
+    unsigned int n = 1;
+    while (true) {
+        if (v < 10) {
+            return n;
+        }
+        if (v < 100) {
+            return n + 1;
+        }
+        if (v < 1000) {
+            return n + 2;
+        }
+        if (v < 10000) {
+            return n + 3;
+        }
+        v /= 10000;
+        n += 4;
+    }
+}
+
+unsigned int FormatUInt(uint64_t value, char* buf) {
+    const unsigned int len = CountDigits(value);
+    char* p = buf + len;
+    while (value >= 100) {
+        const uint32_t idx = (value % 100) * 2;
+        value /= 100;
+        *--p = g_digit_pairs[idx + 1];
+        *--p = g_digit_pairs[idx];
+    }
+    if (value >= 10) {
+        *--p = g_digit_pairs[value * 2 + 1];
+        *--p = g_digit_pairs[value * 2];
+    } else {
+        *--p = (char)('0' + value);
+    }
+    return len;
+}
+
+unsigned int FormatInt(int64_t value, char* buf) {
+    if (value < 0) {
+        *buf = '-';
+        return FormatUInt(0 - (uint64_t)value, buf + 1) + 1;
+    }
+    return FormatUInt(value, buf);
+}
+
+static constexpr uint32_t MAX_FIXED_FRACTION_DIGITS = 9;
+
+/* writes `mantissa` / 10^`fraction_digits` */
+static unsigned int FormatFixed(uint64_t mantissa, uint32_t fraction_digits,
+                                bool negative, char* buf) {
+    char* p = buf;
+    if (negative) {
+        *p++ = '-';
+    }
+
+    char digits[NUMBER_FORMAT_BUF_SIZE];
+    const uint32_t len = FormatUInt(mantissa, digits);
+    if (len <= fraction_digits) {
+        *p++ = '0';
+        *p++ = '.';
+        memset(p, '0', fraction_digits - len);
+        p += fraction_digits - len;
+        memcpy(p, digits, len);
+        p += len;
+    } else {
+        memcpy(p, digits, len - fraction_digits);
+        p += len - fraction_digits;
+        *p++ = '.';
+        memcpy(p, digits + len - fraction_digits, fraction_digits);
+        p += fraction_digits;
+    }
+
+    return p - buf;
+}
+
+/* writes `value` with `precision` significant digits in `%g` style */
+static int FormatPrecision(double value, int precision, char* buf) {
+    const int len =
+        snprintf(buf, NUMBER_FORMAT_BUF_SIZE, "%.*g", precision, value);
+    // the decimal point may be localized
+    for (int i = 0; i < len; ++i) {
+        const char c = buf[i];
+        if ((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e') {
+            buf[i] = '.';
+        }
+    }
+    return len;
+}
+
+static bool RoundTrips(const char* s, int len, double value) {
+    double parsed;
+    return (ParseDouble(s, len, &parsed) && parsed == value);
+}
+
+unsigned int FormatDouble(double value, char* buf) {
+    if (std::isnan(value)) {
+        memcpy(buf, "nan", 3);
+        return 3;
+    }
+    if (std::isinf(value)) {
+        if (value < 0) {
+            memcpy(buf, "-inf", 4);
+            return 4;
+        }
+        memcpy(buf, "inf", 3);
+        return 3;
+    }
+
+    if (value == std::trunc(value) && std::fabs(value) < MAX_EXACT_INTEGER) {
+        if (value == 0 && std::signbit(value)) {
+            memcpy(buf, "-0", 2);
+            return 2;
+        }
+        return FormatInt((int64_t)value, buf);
+    }
+
+    /* values with a few fractional digits, e.g. prices, are written as
+     * integers with a decimal point. parsing the output is exact because it
+     * goes through the fast path of `ParseDouble()`. */
+    for (uint32_t k = 1; k <= MAX_FIXED_FRACTION_DIGITS; ++k) {
+        const double scaled = value * g_exact_pow10[k];
+        if (std::fabs(scaled) >= MAX_EXACT_INTEGER) {
+            break;
+        }
+        if (scaled == std::trunc(scaled) &&
+            scaled / g_exact_pow10[k] == value) {
+            // rounding may make `k` larger than needed, e.g. 1.15 * 100 is
+            // not an integer but 1.15 * 1000 is
+            uint64_t digits = (uint64_t)std::fabs(scaled);
+            while (digits % 10 == 0) {
+                digits /= 10;
+                --k;
+            }
+            return FormatFixed(digits, k, (value < 0), buf);
+        }
+    }
+
+    /* the nearest string of p significant digits round-trips if any string
+     * of p digits does, except at powers of 2 where the lower gap is half
+     * the upper one, and longer ones are closer. so the shortest precision
+     * is searched between 1 and 17, which always round-trips. most values
+     * reaching here need 15 to 17 digits, which are tried first. */
+    char tmp[NUMBER_FORMAT_BUF_SIZE];
+    int len = FormatPrecision(value, 15, tmp);
+    if (!RoundTrips(tmp, len, value)) {
+        len = FormatPrecision(value, 16, tmp);
+        if (!RoundTrips(tmp, len, value)) {
+            len = FormatPrecision(value, 17, tmp);
+        }
+        memcpy(buf, tmp, len);
+        return len;
+    }
+
+    memcpy(buf, tmp, len);
+    int lo = 0, hi = 15; // `lo` digits fail and `hi` digits round-trip
+    while (hi - lo > 1) {
+        const int mid = (lo + hi) / 2;
+        const int mid_len = FormatPrecision(value, mid, tmp);
+        if (RoundTrips(tmp, mid_len, value)) {
+            hi = mid;
+            len = mid_len;
+            memcpy(buf, tmp, len);
+        } else {
+            lo = mid;
+        }
+    }
+    return len;
+}
+
+}
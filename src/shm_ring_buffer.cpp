@@ -0,0 +1,379 @@
+#ifdef __linux__
+
+#include "cpputils/shm_ring_buffer.h"
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h> // pthread_atfork
+#include <sched.h>
+#include <signal.h> // kill
+#include <time.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+using namespace std;
+
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error "lock-free atomics are required for shared memory."
+#endif
+
+namespace cpputils {
+
+static constexpr uint32_t MAGIC = 0x42524853; // "SHRB"
+static constexpr uint64_t CACHELINE_SIZE = 64;
+/* spins before checking whether the writer of a slot is alive */
+static constexpr uint32_t SPIN_NUM = 1024;
+/* a writer is stale if it holds a slot without a pid for this long */
+static constexpr uint64_t STALE_WRITER_TIMEOUT_NS = 1000000000;
+
+/* everything in the mapping is addressed by offsets or sequence numbers, so
+ * processes may map it at different addresses. */
+struct ShmRingBuffer::Header final {
+    std::atomic<uint32_t> magic;
+    uint32_t slot_size;
+    uint32_t capacity;
+    alignas(CACHELINE_SIZE) std::atomic<uint64_t> head; // next seq to write
+    alignas(CACHELINE_SIZE) std::atomic<uint32_t> futex_word;
+    std::atomic<uint32_t> waiter_num;
+};
+
+/* `seq` is 2 * record seq + 1 while the record is being written, and 2 *
+ * record seq + 2 after that. `writer` is the pid of the process writing the
+ * record, which is 0 before it is recorded and after the record is written.
+ */
+struct ShmRingBuffer::Slot final {
+    std::atomic<uint64_t> seq;
+    uint32_t size;
+    std::atomic<uint32_t> writer;
+    char data[0];
+};
+
+uint64_t ShmRingBuffer::GetHeaderSize() {
+    return (sizeof(Header) + CACHELINE_SIZE - 1) & ~(CACHELINE_SIZE - 1);
+}
+
+uint64_t ShmRingBuffer::GetSlotStride(uint32_t slot_size) {
+    return (sizeof(Slot) + slot_size + CACHELINE_SIZE - 1) &
+        ~(CACHELINE_SIZE - 1);
+}
+
+static inline void CpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+/* cached pid, which is reset in child processes */
+static std::atomic<uint32_t> g_pid(0);
+
+static void ResetPid() {
+    g_pid.store(0, std::memory_order_relaxed);
+}
+
+static uint32_t GetPid() {
+    uint32_t pid = g_pid.load(std::memory_order_relaxed);
+    if (pid == 0) {
+        static int s_registered = pthread_atfork(nullptr, nullptr, ResetPid);
+        (void)s_registered;
+        pid = getpid();
+        g_pid.store(pid, std::memory_order_relaxed);
+    }
+    return pid;
+}
+
+static uint64_t GetMonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+bool ShmRingBuffer::IsStaleWriter(const Slot* slot, uint64_t* wait_begin) {
+    // the acquire load of an odd `seq` by the caller guarantees that `writer`
+    // is not left by writers before
+    const uint32_t pid = slot->writer.load(std::memory_order_relaxed);
+    if (pid != 0) {
+        return (kill((pid_t)pid, 0) != 0 && errno == ESRCH);
+    }
+    if (!wait_begin) {
+        return false;
+    }
+
+    const uint64_t now = GetMonotonicNs();
+    if (*wait_begin == 0) {
+        *wait_begin = now;
+        return false;
+    }
+    return (now - *wait_begin >= STALE_WRITER_TIMEOUT_NS);
+}
+
+static bool IsPowerOf2(uint32_t n) {
+    return (n != 0 && (n & (n - 1)) == 0);
+}
+
+bool ShmRingBuffer::Create(const char* filename, uint32_t slot_size,
+                           uint32_t capacity, string* errmsg) {
+    if (!IsPowerOf2(capacity)) {
+        if (errmsg) {
+            *errmsg = "capacity [" + to_string(capacity) +
+                "] is not a power of 2";
+        }
+        return false;
+    }
+
+    int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        if (errmsg) {
+            *errmsg = strerror(errno);
+        }
+        return false;
+    }
+
+    const uint64_t file_size =
+        GetHeaderSize() + GetSlotStride(slot_size) * capacity;
+    int ret = ftruncate(fd, file_size);
+    close(fd);
+    if (ret != 0) {
+        if (errmsg) {
+            *errmsg = strerror(errno);
+        }
+        return false;
+    }
+
+    if (!m_fm.Init(filename,
+                   FileMapping::READ | FileMapping::WRITE | FileMapping::SHARED,
+                   0, UINT64_MAX, errmsg)) {
+        return false;
+    }
+
+    // the file is filled with zeros by ftruncate()
+    auto header = (Header*)m_fm.data();
+    header->slot_size = slot_size;
+    header->capacity = capacity;
+    header->magic.store(MAGIC, std::memory_order_release);
+
+    return DoInit(errmsg);
+}
+
+bool ShmRingBuffer::Init(const char* filename, string* errmsg) {
+    if (!m_fm.Init(filename,
+                   FileMapping::READ | FileMapping::WRITE | FileMapping::SHARED,
+                   0, UINT64_MAX, errmsg)) {
+        return false;
+    }
+    return DoInit(errmsg);
+}
+
+bool ShmRingBuffer::DoInit(string* errmsg) {
+    auto header = (Header*)m_fm.data();
+    if (m_fm.size() < GetHeaderSize() ||
+        header->magic.load(std::memory_order_acquire) != MAGIC) {
+        if (errmsg) {
+            *errmsg = "invalid shm ring buffer";
+        }
+        goto errout;
+    }
+
+    // slots are indexed by masking sequence numbers
+    if (!IsPowerOf2(header->capacity)) {
+        if (errmsg) {
+            *errmsg = "capacity [" + to_string(header->capacity) +
+                "] of shm ring buffer is not a power of 2";
+        }
+        goto errout;
+    }
+
+    m_slot_stride = GetSlotStride(header->slot_size);
+    if (m_fm.size() < GetHeaderSize() + m_slot_stride * header->capacity) {
+        if (errmsg) {
+            *errmsg = "shm ring buffer is truncated";
+        }
+        goto errout;
+    }
+
+    m_header = header;
+    m_slots = (char*)header + GetHeaderSize();
+    {
+        // starts from the oldest record available
+        const uint64_t head = header->head.load(std::memory_order_acquire);
+        m_cursor = (head > header->capacity) ? head - header->capacity : 0;
+    }
+    return true;
+
+errout:
+    m_fm.Destroy();
+    return false;
+}
+
+void ShmRingBuffer::Destroy() {
+    m_header = nullptr;
+    m_slots = nullptr;
+    m_fm.Destroy();
+}
+
+uint32_t ShmRingBuffer::GetSlotSize() const {
+    return m_header->slot_size;
+}
+
+uint32_t ShmRingBuffer::GetCapacity() const {
+    return m_header->capacity;
+}
+
+ShmRingBuffer::Slot* ShmRingBuffer::GetSlot(uint64_t seq) const {
+    return (Slot*)(m_slots + (seq & (m_header->capacity - 1)) * m_slot_stride);
+}
+
+static long Futex(std::atomic<uint32_t>* addr, int op, uint32_t val,
+                  const struct timespec* timeout) {
+    // not FUTEX_PRIVATE_FLAG: the word is shared between processes
+    return syscall(SYS_futex, (uint32_t*)addr, op, val, timeout, nullptr, 0);
+}
+
+bool ShmRingBuffer::Push(const void* data, uint32_t size) {
+    if (size > m_header->slot_size) {
+        return false;
+    }
+
+    const uint64_t seq = m_header->head.fetch_add(1, std::memory_order_relaxed);
+    const uint64_t writing = seq * 2 + 1;
+    auto slot = GetSlot(seq);
+
+    uint64_t cur = slot->seq.load(std::memory_order_acquire);
+    uint64_t waiting = UINT64_MAX; // `seq` of the writer waited for
+    uint64_t wait_begin = 0;
+    uint32_t spin = 0;
+    while (true) {
+        if (cur >= writing) {
+            // overwritten by a newer record already
+            return true;
+        }
+        if (cur & 1) {
+            // the previous writer of this slot has not finished
+            if (cur != waiting) {
+                waiting = cur;
+                wait_begin = 0;
+            }
+            if (++spin % SPIN_NUM != 0) {
+                CpuRelax();
+                cur = slot->seq.load(std::memory_order_acquire);
+                continue;
+            }
+            if (!IsStaleWriter(slot, &wait_begin)) {
+                sched_yield();
+                cur = slot->seq.load(std::memory_order_acquire);
+                continue;
+            }
+            // takes over the slot of a crashed writer
+        }
+        if (slot->seq.compare_exchange_weak(cur, writing,
+                                            std::memory_order_acquire,
+                                            std::memory_order_acquire)) {
+            break;
+        }
+    }
+
+    slot->writer.store(GetPid(), std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(slot->data, data, size);
+    slot->size = size;
+    slot->writer.store(0, std::memory_order_relaxed);
+    slot->seq.store(writing + 1, std::memory_order_release);
+
+    // pairs with the fence in `Wait()`
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_header->waiter_num.load(std::memory_order_relaxed) > 0) {
+        m_header->futex_word.fetch_add(1, std::memory_order_relaxed);
+        Futex(&m_header->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+
+    return true;
+}
+
+bool ShmRingBuffer::Pop(void* data, uint32_t* size, uint64_t* dropped) {
+    if (dropped) {
+        *dropped = 0;
+    }
+
+    while (true) {
+        const uint64_t expected = m_cursor * 2 + 2;
+        auto slot = GetSlot(m_cursor);
+
+        uint64_t cur = slot->seq.load(std::memory_order_acquire);
+        if (cur == expected - 1 && IsStaleWriter(slot, nullptr)) {
+            // the writer crashed
+            if (dropped) {
+                ++*dropped;
+            }
+            ++m_cursor;
+            continue;
+        }
+        if (cur < expected) {
+            return false;
+        }
+
+        if (cur == expected) {
+            uint32_t len = slot->size;
+            if (len > m_header->slot_size) {
+                len = m_header->slot_size;
+            }
+            memcpy(data, slot->data, len);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->seq.load(std::memory_order_relaxed) == expected) {
+                *size = len;
+                ++m_cursor;
+                return true;
+            }
+        }
+
+        // overwritten. skips to the oldest record available.
+        const uint64_t head = m_header->head.load(std::memory_order_acquire);
+        uint64_t oldest =
+            (head > m_header->capacity) ? head - m_header->capacity : 0;
+        if (oldest <= m_cursor) {
+            oldest = m_cursor + 1;
+        }
+        if (dropped) {
+            *dropped += oldest - m_cursor;
+        }
+        m_cursor = oldest;
+    }
+}
+
+bool ShmRingBuffer::HasRecord() const {
+    auto slot = GetSlot(m_cursor);
+    return (slot->seq.load(std::memory_order_acquire) >= m_cursor * 2 + 2);
+}
+
+bool ShmRingBuffer::Wait(uint32_t timeout_ms) {
+    if (HasRecord()) {
+        return true;
+    }
+
+    struct timespec ts;
+    struct timespec* timeout = nullptr;
+    if (timeout_ms != UINT32_MAX) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000;
+        timeout = &ts;
+    }
+
+    m_header->waiter_num.fetch_add(1, std::memory_order_relaxed);
+    const uint32_t word = m_header->futex_word.load(std::memory_order_relaxed);
+    // pairs with the fence in `Push()`
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    bool ok = true;
+    if (!HasRecord()) {
+        if (Futex(&m_header->futex_word, FUTEX_WAIT, word, timeout) != 0 &&
+            errno == ETIMEDOUT) {
+            ok = HasRecord();
+        }
+    }
+
+    m_header->waiter_num.fetch_sub(1, std::memory_order_relaxed);
+    return ok;
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,182 @@
+#include "string_kernels.h"
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace cpputils { namespace internal {
+
+#if defined(__SSE2__)
+const char* MemMemGeneric(const char* text, unsigned int tlen,
+                          const char* pattern, unsigned int plen) {
+    if (plen == 0) {
+        return text;
+    }
+    if (plen > tlen) {
+        return nullptr;
+    }
+    if (plen == 1) {
+        return (const char*)memchr(text, *pattern, tlen);
+    }
+
+    /* compares the first and the last chars of the pattern at 16 positions
+     * at once, and checks the rest only for candidates. */
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[plen - 1]);
+
+    unsigned int i = 0;
+    for (; i + plen - 1 + 16 <= tlen; i += 16) {
+        auto a = _mm_loadu_si128((const __m128i*)(text + i));
+        auto b = _mm_loadu_si128((const __m128i*)(text + i + plen - 1));
+        uint32_t mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask) {
+            const unsigned int pos = i + __builtin_ctz(mask);
+            if (memcmp(text + pos + 1, pattern + 1, plen - 2) == 0) {
+                return text + pos;
+            }
+            mask &= (mask - 1);
+        }
+    }
+
+    for (; i + plen <= tlen; ++i) {
+        if (text[i] == pattern[0] && memcmp(text + i, pattern, plen) == 0) {
+            return text + i;
+        }
+    }
+    return nullptr;
+}
+
+unsigned int CountTrailingGeneric(const char* text, unsigned int len, char c) {
+    const __m128i v = _mm_set1_epi8(c);
+    unsigned int pos = len;
+    while (pos >= 16) {
+        auto data = _mm_loadu_si128((const __m128i*)(text + pos - 16));
+        const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(data, v));
+        if (mask != 0xffff) {
+            // bit 15 is the last char
+            return (len - pos) + __builtin_clz((~mask) << 16);
+        }
+        pos -= 16;
+    }
+
+    while (pos > 0 && text[pos - 1] == c) {
+        --pos;
+    }
+    return (len - pos);
+}
+#else
+const char* MemMemGeneric(const char* text, unsigned int tlen,
+                          const char* pattern, unsigned int plen) {
+    if (plen == 0) {
+        return text;
+    }
+
+    const char* end = text + tlen;
+    while ((unsigned int)(end - text) >= plen) {
+        auto cursor =
+            (const char*)memchr(text, *pattern, (end - text) - plen + 1);
+        if (!cursor) {
+            return nullptr;
+        }
+        if (memcmp(cursor, pattern, plen) == 0) {
+            return cursor;
+        }
+        text = cursor + 1;
+    }
+    return nullptr;
+}
+
+unsigned int CountTrailingGeneric(const char* text, unsigned int len, char c) {
+    unsigned int pos = len;
+    while (pos > 0 && text[pos - 1] == c) {
+        --pos;
+    }
+    return (len - pos);
+}
+#endif
+
+/* without pshufb, a table lookup per byte is the fastest */
+unsigned int FindFirstGeneric(const char* text, unsigned int len,
+                              const uint8_t* set, bool in_set) {
+    for (unsigned int i = 0; i < len; ++i) {
+        if (ByteSetContains(set, text[i]) == in_set) {
+            return i;
+        }
+    }
+    return len;
+}
+
+unsigned int FindLastGeneric(const char* text, unsigned int len,
+                             const uint8_t* set, bool in_set) {
+    for (unsigned int i = len; i > 0; --i) {
+        if (ByteSetContains(set, text[i - 1]) == in_set) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+unsigned int CountSetGeneric(const char* text, unsigned int len,
+                             const uint8_t* set) {
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < len; ++i) {
+        n += ByteSetContains(set, text[i]);
+    }
+    return n;
+}
+
+unsigned int CountCharGeneric(const char* text, unsigned int len, char c) {
+    unsigned int n = 0;
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    const __m128i v = _mm_set1_epi8(c);
+    for (; i + 16 <= len; i += 16) {
+        auto data = _mm_loadu_si128((const __m128i*)(text + i));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(data, v)));
+    }
+#endif
+    for (; i < len; ++i) {
+        n += (text[i] == c);
+    }
+    return n;
+}
+
+static StringKernels SelectStringKernels() {
+    StringKernels kernels;
+    kernels.mem_mem = MemMemGeneric;
+    kernels.count_trailing = CountTrailingGeneric;
+    kernels.find_first = FindFirstGeneric;
+    kernels.find_last = FindLastGeneric;
+    kernels.count_set = CountSetGeneric;
+    kernels.count_char = CountCharGeneric;
+
+#ifdef CPPUTILS_X86_DISPATCH
+    const uint32_t features = GetCpuFeatures();
+    if (features & CPU_FEATURE_AVX512BW) {
+        kernels.mem_mem = MemMemAvx512;
+        kernels.count_trailing = CountTrailingAvx512;
+        kernels.find_first = FindFirstAvx512;
+        kernels.find_last = FindLastAvx512;
+        kernels.count_set = CountSetAvx512;
+        kernels.count_char = CountCharAvx512;
+    } else if (features & CPU_FEATURE_AVX2) {
+        kernels.mem_mem = MemMemAvx2;
+        kernels.count_trailing = CountTrailingAvx2;
+        kernels.find_first = FindFirstAvx2;
+        kernels.find_last = FindLastAvx2;
+        kernels.count_set = CountSetAvx2;
+        kernels.count_char = CountCharAvx2;
+    }
+#endif
+
+    return kernels;
+}
+
+const StringKernels* GetStringKernels() {
+    static const StringKernels s_kernels = SelectStringKernels();
+    return &s_kernels;
+}
+
+}}
@@ -0,0 +1,78 @@
+#ifndef __CPPUTILS_STRING_KERNELS_H__
+#define __CPPUTILS_STRING_KERNELS_H__
+
+#include "cpu_features.h"
+
+namespace cpputils { namespace internal {
+
+/*
+  string kernels are implemented for each instruction set in separate
+  translation units with target attributes, so that the library can be built
+  with portable flags. the best ones supported by the running cpu are selected
+  on the first call of `GetStringKernels()`.
+*/
+struct StringKernels final {
+    const char* (*mem_mem)(const char* text, unsigned int tlen,
+                           const char* pattern, unsigned int plen);
+    /* number of consecutive `c` at the end of `text` */
+    unsigned int (*count_trailing)(const char* text, unsigned int len, char c);
+
+    /*
+      `set` is `ByteSet::table()`. `find_first` returns the index of the first
+      char whose membership of `set` equals to `in_set`, or `len` if not found.
+      `find_last` returns 1 + the index of the last one, or 0 if not found.
+    */
+    unsigned int (*find_first)(const char* text, unsigned int len,
+                               const uint8_t* set, bool in_set);
+    unsigned int (*find_last)(const char* text, unsigned int len,
+                              const uint8_t* set, bool in_set);
+    unsigned int (*count_set)(const char* text, unsigned int len,
+                              const uint8_t* set);
+    unsigned int (*count_char)(const char* text, unsigned int len, char c);
+};
+
+const StringKernels* GetStringKernels();
+
+static inline bool ByteSetContains(const uint8_t* set, uint8_t b) {
+    return (set[(b >> 7) * 16 + (b & 0xf)] >> ((b >> 4) & 7)) & 1;
+}
+
+/* scalar on non-x86 platforms, sse2 otherwise */
+const char* MemMemGeneric(const char* text, unsigned int tlen,
+                          const char* pattern, unsigned int plen);
+unsigned int CountTrailingGeneric(const char* text, unsigned int len, char c);
+unsigned int FindFirstGeneric(const char* text, unsigned int len,
+                              const uint8_t* set, bool in_set);
+unsigned int FindLastGeneric(const char* text, unsigned int len,
+                             const uint8_t* set, bool in_set);
+unsigned int CountSetGeneric(const char* text, unsigned int len,
+                             const uint8_t* set);
+unsigned int CountCharGeneric(const char* text, unsigned int len, char c);
+
+#ifdef CPPUTILS_X86_DISPATCH
+const char* MemMemAvx2(const char* text, unsigned int tlen,
+                       const char* pattern, unsigned int plen);
+unsigned int CountTrailingAvx2(const char* text, unsigned int len, char c);
+unsigned int FindFirstAvx2(const char* text, unsigned int len,
+                           const uint8_t* set, bool in_set);
+unsigned int FindLastAvx2(const char* text, unsigned int len,
+                          const uint8_t* set, bool in_set);
+unsigned int CountSetAvx2(const char* text, unsigned int len,
+                          const uint8_t* set);
+unsigned int CountCharAvx2(const char* text, unsigned int len, char c);
+
+const char* MemMemAvx512(const char* text, unsigned int tlen,
+                         const char* pattern, unsigned int plen);
+unsigned int CountTrailingAvx512(const char* text, unsigned int len, char c);
+unsigned int FindFirstAvx512(const char* text, unsigned int len,
+                             const uint8_t* set, bool in_set);
+unsigned int FindLastAvx512(const char* text, unsigned int len,
+                            const uint8_t* set, bool in_set);
+unsigned int CountSetAvx512(const char* text, unsigned int len,
+                            const uint8_t* set);
+unsigned int CountCharAvx512(const char* text, unsigned int len, char c);
+#endif
+
+}}
+
+#endif
@@ -0,0 +1,142 @@
+#include "string_kernels.h"
+
+#ifdef CPPUTILS_X86_DISPATCH
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace cpputils { namespace internal {
+
+__attribute__((target("avx2"))) const char*
+MemMemAvx2(const char* text, unsigned int tlen, const char* pattern,
+           unsigned int plen) {
+    if (plen < 2 || plen > tlen) {
+        return MemMemGeneric(text, tlen, pattern, plen);
+    }
+
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[plen - 1]);
+
+    unsigned int i = 0;
+    for (; i + plen - 1 + 32 <= tlen; i += 32) {
+        auto a = _mm256_loadu_si256((const __m256i*)(text + i));
+        auto b = _mm256_loadu_si256((const __m256i*)(text + i + plen - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask) {
+            const unsigned int pos = i + __builtin_ctz(mask);
+            if (memcmp(text + pos + 1, pattern + 1, plen - 2) == 0) {
+                return text + pos;
+            }
+            mask &= (mask - 1);
+        }
+    }
+
+    return MemMemGeneric(text + i, tlen - i, pattern, plen);
+}
+
+__attribute__((target("avx2"))) unsigned int
+CountTrailingAvx2(const char* text, unsigned int len, char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    unsigned int pos = len;
+    while (pos >= 32) {
+        auto data = _mm256_loadu_si256((const __m256i*)(text + pos - 32));
+        const uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, v));
+        if (mask != UINT32_MAX) {
+            return (len - pos) + __builtin_clz(~mask);
+        }
+        pos -= 32;
+    }
+    return (len - pos) + CountTrailingGeneric(text, pos, c);
+}
+
+/* bit i of the result is set if text[i] is in `set`. see
+ * http://0x80.pl/articles/simd-byte-lookup.html */
+struct ByteSetAvx2 final {
+    __attribute__((target("avx2"))) ByteSetAvx2(const uint8_t* set) {
+        auto lo = _mm_loadu_si128((const __m128i*)set);
+        auto hi = _mm_loadu_si128((const __m128i*)(set + 16));
+        table_0_7 = _mm256_broadcastsi128_si256(lo);
+        table_8_15 = _mm256_broadcastsi128_si256(hi);
+        bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16,
+                                32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128, 1,
+                                2, 4, 8, 16, 32, 64, -128);
+    }
+
+    __attribute__((target("avx2"))) uint32_t Match(const char* p) const {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0f);
+        const __m256i lo = _mm256_and_si256(v, nibble_mask);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4),
+                                            nibble_mask);
+        // the sign bit of `v` selects the table of high nibbles >= 8
+        const __m256i row = _mm256_blendv_epi8(
+            _mm256_shuffle_epi8(table_0_7, lo),
+            _mm256_shuffle_epi8(table_8_15, lo), v);
+        const __m256i bit = _mm256_shuffle_epi8(bits, hi);
+        return _mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit));
+    }
+
+    __m256i table_0_7;
+    __m256i table_8_15;
+    __m256i bits;
+};
+
+__attribute__((target("avx2"))) unsigned int
+FindFirstAvx2(const char* text, unsigned int len, const uint8_t* set,
+              bool in_set) {
+    const ByteSetAvx2 bs(set);
+    const uint32_t flip = in_set ? 0 : UINT32_MAX;
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32) {
+        const uint32_t mask = bs.Match(text + i) ^ flip;
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return i + FindFirstGeneric(text + i, len - i, set, in_set);
+}
+
+__attribute__((target("avx2"))) unsigned int
+FindLastAvx2(const char* text, unsigned int len, const uint8_t* set,
+             bool in_set) {
+    const ByteSetAvx2 bs(set);
+    const uint32_t flip = in_set ? 0 : UINT32_MAX;
+    unsigned int pos = len;
+    for (; pos >= 32; pos -= 32) {
+        const uint32_t mask = bs.Match(text + pos - 32) ^ flip;
+        if (mask) {
+            return pos - __builtin_clz(mask);
+        }
+    }
+    return FindLastGeneric(text, pos, set, in_set);
+}
+
+__attribute__((target("avx2"))) unsigned int
+CountSetAvx2(const char* text, unsigned int len, const uint8_t* set) {
+    const ByteSetAvx2 bs(set);
+    unsigned int n = 0;
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32) {
+        n += __builtin_popcount(bs.Match(text + i));
+    }
+    return n + CountSetGeneric(text + i, len - i, set);
+}
+
+__attribute__((target("avx2"))) unsigned int
+CountCharAvx2(const char* text, unsigned int len, char c) {
+    const __m256i v = _mm256_set1_epi8(c);
+    unsigned int n = 0;
+    unsigned int i = 0;
+    for (; i + 32 <= len; i += 32) {
+        auto data = _mm256_loadu_si256((const __m256i*)(text + i));
+        n += __builtin_popcount(
+            _mm256_movemask_epi8(_mm256_cmpeq_epi8(data, v)));
+    }
+    return n + CountCharGeneric(text + i, len - i, c);
+}
+
+}}
+
+#endif
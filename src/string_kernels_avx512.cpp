@@ -0,0 +1,141 @@
+#include "string_kernels.h"
+
+#ifdef CPPUTILS_X86_DISPATCH
+
+#include <cstring>
+#include <immintrin.h>
+
+namespace cpputils { namespace internal {
+
+__attribute__((target("avx512f,avx512bw"))) const char*
+MemMemAvx512(const char* text, unsigned int tlen, const char* pattern,
+             unsigned int plen) {
+    if (plen < 2 || plen > tlen) {
+        return MemMemGeneric(text, tlen, pattern, plen);
+    }
+
+    const __m512i first = _mm512_set1_epi8(pattern[0]);
+    const __m512i last = _mm512_set1_epi8(pattern[plen - 1]);
+
+    unsigned int i = 0;
+    for (; i + plen - 1 + 64 <= tlen; i += 64) {
+        auto a = _mm512_loadu_si512((const void*)(text + i));
+        auto b = _mm512_loadu_si512((const void*)(text + i + plen - 1));
+        uint64_t mask = _mm512_cmpeq_epi8_mask(a, first) &
+            _mm512_cmpeq_epi8_mask(b, last);
+        while (mask) {
+            const unsigned int pos = i + __builtin_ctzll(mask);
+            if (memcmp(text + pos + 1, pattern + 1, plen - 2) == 0) {
+                return text + pos;
+            }
+            mask &= (mask - 1);
+        }
+    }
+
+    return MemMemGeneric(text + i, tlen - i, pattern, plen);
+}
+
+__attribute__((target("avx512f,avx512bw"))) unsigned int
+CountTrailingAvx512(const char* text, unsigned int len, char c) {
+    const __m512i v = _mm512_set1_epi8(c);
+    unsigned int pos = len;
+    while (pos >= 64) {
+        auto data = _mm512_loadu_si512((const void*)(text + pos - 64));
+        const uint64_t mask = _mm512_cmpeq_epi8_mask(data, v);
+        if (mask != UINT64_MAX) {
+            return (len - pos) + __builtin_clzll(~mask);
+        }
+        pos -= 64;
+    }
+    return (len - pos) + CountTrailingGeneric(text, pos, c);
+}
+
+/* the same as `ByteSetAvx2` with 64 bytes */
+struct ByteSetAvx512 final {
+    __attribute__((target("avx512f,avx512bw"))) ByteSetAvx512(
+        const uint8_t* set) {
+        auto lo = _mm_loadu_si128((const __m128i*)set);
+        auto hi = _mm_loadu_si128((const __m128i*)(set + 16));
+        // the unmasked version trips -Wuninitialized with gcc 12
+        table_0_7 = _mm512_maskz_broadcast_i32x4(0xffff, lo);
+        table_8_15 = _mm512_maskz_broadcast_i32x4(0xffff, hi);
+        bits = _mm512_maskz_broadcast_i32x4(
+            0xffff, _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8,
+                                  16, 32, 64, -128));
+    }
+
+    __attribute__((target("avx512f,avx512bw"))) uint64_t
+    Match(const char* p) const {
+        const __m512i v = _mm512_loadu_si512((const void*)p);
+        const __m512i nibble_mask = _mm512_set1_epi8(0x0f);
+        const __m512i lo = _mm512_and_si512(v, nibble_mask);
+        const __m512i hi = _mm512_and_si512(_mm512_srli_epi16(v, 4),
+                                            nibble_mask);
+        const __m512i row = _mm512_mask_blend_epi8(
+            _mm512_movepi8_mask(v), _mm512_shuffle_epi8(table_0_7, lo),
+            _mm512_shuffle_epi8(table_8_15, lo));
+        const __m512i bit = _mm512_shuffle_epi8(bits, hi);
+        return _mm512_test_epi8_mask(row, bit);
+    }
+
+    __m512i table_0_7;
+    __m512i table_8_15;
+    __m512i bits;
+};
+
+__attribute__((target("avx512f,avx512bw"))) unsigned int
+FindFirstAvx512(const char* text, unsigned int len, const uint8_t* set,
+                bool in_set) {
+    const ByteSetAvx512 bs(set);
+    const uint64_t flip = in_set ? 0 : UINT64_MAX;
+    unsigned int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        const uint64_t mask = bs.Match(text + i) ^ flip;
+        if (mask) {
+            return i + __builtin_ctzll(mask);
+        }
+    }
+    return i + FindFirstGeneric(text + i, len - i, set, in_set);
+}
+
+__attribute__((target("avx512f,avx512bw"))) unsigned int
+FindLastAvx512(const char* text, unsigned int len, const uint8_t* set,
+               bool in_set) {
+    const ByteSetAvx512 bs(set);
+    const uint64_t flip = in_set ? 0 : UINT64_MAX;
+    unsigned int pos = len;
+    for (; pos >= 64; pos -= 64) {
+        const uint64_t mask = bs.Match(text + pos - 64) ^ flip;
+        if (mask) {
+            return pos - __builtin_clzll(mask);
+        }
+    }
+    return FindLastGeneric(text, pos, set, in_set);
+}
+
+__attribute__((target("avx512f,avx512bw"))) unsigned int
+CountSetAvx512(const char* text, unsigned int len, const uint8_t* set) {
+    const ByteSetAvx512 bs(set);
+    unsigned int n = 0;
+    unsigned int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        n += __builtin_popcountll(bs.Match(text + i));
+    }
+    return n + CountSetGeneric(text + i, len - i, set);
+}
+
+__attribute__((target("avx512f,avx512bw"))) unsigned int
+CountCharAvx512(const char* text, unsigned int len, char c) {
+    const __m512i v = _mm512_set1_epi8(c);
+    unsigned int n = 0;
+    unsigned int i = 0;
+    for (; i + 64 <= len; i += 64) {
+        auto data = _mm512_loadu_si512((const void*)(text + i));
+        n += __builtin_popcountll(_mm512_cmpeq_epi8_mask(data, v));
+    }
+    return n + CountCharGeneric(text + i, len - i, c);
+}
+
+}}
+
+#endif
@@ -0,0 +1,99 @@
+#include "cpputils/string_pool.h"
+#include "cpputils/string_utils.h" // StringHash
+#include <cstring>
+using namespace std;
+
+namespace cpputils {
+
+static constexpr uint32_t INITIAL_SLOT_NUM = 64;
+
+uint32_t StringPool::DoFind(const char* data, unsigned int len, uint32_t hash,
+                            uint32_t* slot_idx) const {
+    const uint32_t mask = m_slots.size() - 1;
+    uint32_t idx = hash & mask;
+    while (true) {
+        auto slot = &m_slots[idx];
+        if (slot->id == INVALID_ID) {
+            *slot_idx = idx;
+            return INVALID_ID;
+        }
+        if (slot->hash == hash) {
+            auto entry = &m_entries[slot->id];
+            if (entry->len == len && memcmp(entry->data, data, len) == 0) {
+                *slot_idx = idx;
+                return slot->id;
+            }
+        }
+        idx = (idx + 1) & mask;
+    }
+}
+
+bool StringPool::Grow() {
+    const uint32_t slot_num =
+        m_slots.empty() ? INITIAL_SLOT_NUM : m_slots.size() * 2;
+    if (slot_num == 0) { // overflow
+        return false;
+    }
+
+    vector<Slot> slots(slot_num, Slot{0, INVALID_ID});
+    const uint32_t mask = slot_num - 1;
+    for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+        if (it->id != INVALID_ID) {
+            uint32_t idx = it->hash & mask;
+            while (slots[idx].id != INVALID_ID) {
+                idx = (idx + 1) & mask;
+            }
+            slots[idx] = *it;
+        }
+    }
+
+    m_slots.swap(slots);
+    return true;
+}
+
+uint32_t StringPool::Find(const char* data, unsigned int len) const {
+    if (m_entries.empty()) {
+        return INVALID_ID;
+    }
+
+    uint32_t slot_idx;
+    return DoFind(data, len, StringHash(data, len), &slot_idx);
+}
+
+uint32_t StringPool::Intern(const char* data, unsigned int len) {
+    // keeps the load factor <= 1/2 so that probes are short
+    if ((m_entries.size() + 1) * 2 > m_slots.size()) {
+        if (m_entries.size() == INVALID_ID || !Grow()) {
+            return INVALID_ID;
+        }
+    }
+
+    const uint32_t hash = StringHash(data, len);
+    uint32_t slot_idx;
+    uint32_t id = DoFind(data, len, hash, &slot_idx);
+    if (id != INVALID_ID) {
+        return id;
+    }
+
+    auto buf = (char*)m_arena.Alloc(len + 1, 1);
+    if (!buf) {
+        return INVALID_ID;
+    }
+    memcpy(buf, data, len);
+    buf[len] = '\0';
+
+    id = m_entries.size();
+    m_entries.push_back(Entry{buf, len});
+    m_slots[slot_idx] = Slot{hash, id};
+    return id;
+}
+
+void StringPool::Clear() {
+    m_arena.Reset();
+    m_entries.clear();
+    for (auto it = m_slots.begin(); it != m_slots.end(); ++it) {
+        it->id = INVALID_ID;
+    }
+}
+
+}
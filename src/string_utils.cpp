@@ -1,4 +1,12 @@
 #include "cpputils/string_utils.h"
+#include "cpputils/file_mapping.h"
+#include "string_kernels.h"
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#ifdef _MSC_VER
+#include <intrin.h> // _umul128, __umulh
+#endif
 using namespace std;
 
 namespace cpputils {
@@ -13,26 +21,122 @@ bool StringEndsWith(const char* text, unsigned int tlen, const char* suffix,
 }
 
 unsigned int StringTrim(const char* text, unsigned int tlen, char c) {
-    unsigned int pos = tlen;
-    while (pos > 0) {
-        --pos;
-        if (text[pos] != c) {
-            ++pos;
-            break;
-        }
+    return internal::GetStringKernels()->count_trailing(text, tlen, c);
+}
+
+unsigned int StringTrimLeft(const char* text, unsigned int tlen,
+                            const ByteSet& chars) {
+    return internal::GetStringKernels()->find_first(text, tlen, chars.table(),
+                                                    false);
+}
+
+unsigned int StringTrimRight(const char* text, unsigned int tlen,
+                             const ByteSet& chars) {
+    return tlen -
+        internal::GetStringKernels()->find_last(text, tlen, chars.table(),
+                                                false);
+}
+
+pair<const char*, unsigned int> StringTrimBoth(const char* text,
+                                               unsigned int tlen,
+                                               const ByteSet& chars) {
+    auto kernels = internal::GetStringKernels();
+    const unsigned int begin =
+        kernels->find_first(text, tlen, chars.table(), false);
+    if (begin == tlen) {
+        return make_pair(text + tlen, 0);
     }
+    const unsigned int end = begin +
+        kernels->find_last(text + begin, tlen - begin, chars.table(), false);
+    return make_pair(text + begin, end - begin);
+}
 
-    return (tlen - pos);
+unsigned int StringFindFirstOf(const char* text, unsigned int tlen,
+                               const ByteSet& chars) {
+    return internal::GetStringKernels()->find_first(text, tlen, chars.table(),
+                                                    true);
 }
 
-static const char* MemMem(const char* text, unsigned int tlen,
-                          const char* pattern, unsigned int plen) {
-    for (auto s = text; tlen >= plen; ++s, --tlen) {
-        if (memcmp(s, pattern, plen) == 0) {
-            return s;
+unsigned int StringFindFirstNotOf(const char* text, unsigned int tlen,
+                                  const ByteSet& chars) {
+    return internal::GetStringKernels()->find_first(text, tlen, chars.table(),
+                                                    false);
+}
+
+unsigned int StringCount(const char* text, unsigned int tlen, char c) {
+    return internal::GetStringKernels()->count_char(text, tlen, c);
+}
+
+unsigned int StringCount(const char* text, unsigned int tlen,
+                         const ByteSet& chars) {
+    return internal::GetStringKernels()->count_set(text, tlen, chars.table());
+}
+
+static constexpr uint64_t HASH_P0 = 0xa0761d6478bd642full;
+static constexpr uint64_t HASH_P1 = 0xe7037ed1a0b428dbull;
+
+/* folds the 128-bit product */
+static inline uint64_t HashMix(uint64_t a, uint64_t b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    uint64_t hi;
+    const uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#elif defined(_MSC_VER)
+    return (a * b) ^ __umulh(a, b);
+#else
+    const __uint128_t r = (__uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+#endif
+}
+
+static inline uint64_t Read8(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t Read4(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t StringHash(const char* text, unsigned int tlen, uint64_t seed) {
+    seed ^= HashMix(seed ^ HASH_P0, HASH_P1);
+
+    uint64_t a, b;
+    if (tlen <= 16) {
+        if (tlen >= 4) {
+            // two overlapping reads cover 4 ~ 16 bytes
+            const unsigned int mid = (tlen >> 3) << 2;
+            a = (Read4(text) << 32) | Read4(text + mid);
+            b = (Read4(text + tlen - 4) << 32) | Read4(text + tlen - 4 - mid);
+        } else if (tlen > 0) {
+            a = ((uint64_t)(uint8_t)text[0] << 16) |
+                ((uint64_t)(uint8_t)text[tlen >> 1] << 8) |
+                (uint8_t)text[tlen - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        const char* p = text;
+        unsigned int left = tlen;
+        while (left > 16) {
+            seed = HashMix(Read8(p) ^ HASH_P1, Read8(p + 8) ^ seed);
+            p += 16;
+            left -= 16;
         }
+        a = Read8(p + left - 16);
+        b = Read8(p + left - 8);
     }
-    return nullptr;
+
+    return HashMix(HASH_P1 ^ tlen, HashMix(a ^ HASH_P1, b ^ seed));
+}
+
+static inline const char* MemMem(const char* text, unsigned int tlen,
+                                 const char* pattern, unsigned int plen) {
+    return internal::GetStringKernels()->mem_mem(text, tlen, pattern, plen);
 }
 
 string StringReplace(const char* text, unsigned int tlen, const char* search,
@@ -97,4 +201,139 @@ pair<const char*, unsigned int> StringSplitter::Next(const char* delim,
     return make_pair(begin, m_end - begin);
 }
 
+/* -------------------------------------------------------------------------- */
+
+/*
+  emits `text` with matches replaced, except the last `slen - 1` bytes after
+  the last match unless `is_last` is true, because a match may start there.
+  returns the number of bytes processed.
+*/
+unsigned int StringReplacer::Process(const char* text, unsigned int tlen,
+                                     bool is_last, bool* ok) {
+    const unsigned int slen = m_search.size();
+    unsigned int pos = 0;
+    while (true) {
+        auto cursor = MemMem(text + pos, tlen - pos, m_search.data(), slen);
+        if (!cursor) {
+            break;
+        }
+        const unsigned int offset = cursor - text;
+        if (offset > pos && !m_sink(text + pos, offset - pos)) {
+            *ok = false;
+            return pos;
+        }
+        if (!m_replace.empty() &&
+            !m_sink(m_replace.data(), m_replace.size())) {
+            *ok = false;
+            return offset;
+        }
+        pos = offset + slen;
+    }
+
+    unsigned int end = tlen;
+    if (!is_last && tlen - pos >= slen) {
+        end = tlen - (slen - 1);
+    } else if (!is_last) {
+        end = pos;
+    }
+    if (end > pos && !m_sink(text + pos, end - pos)) {
+        *ok = false;
+    }
+    return end;
+}
+
+bool StringReplacer::DoFeed(const char* data, unsigned int len) {
+    bool ok = true;
+    const unsigned int keep = m_search.size() - 1;
+
+    if (!m_carry.empty()) {
+        // processes the carry with enough bytes to complete any match in it
+        const unsigned int old_size = m_carry.size();
+        const unsigned int n = (len < keep) ? len : keep;
+        m_carry.append(data, n);
+        const unsigned int done =
+            Process(m_carry.data(), m_carry.size(), false, &ok);
+        if (!ok) {
+            return false;
+        }
+        if (n < keep) {
+            m_carry.erase(0, done);
+            return true;
+        }
+        // the rest of the carry is in `data` and will be processed again
+        m_carry.clear();
+        data += (done - old_size);
+        len -= (done - old_size);
+    }
+
+    const unsigned int done = Process(data, len, false, &ok);
+    if (!ok) {
+        return false;
+    }
+    m_carry.assign(data + done, len - done);
+    return true;
+}
+
+/* `MemMem()` takes 32-bit lengths */
+static constexpr uint64_t MAX_FEED_SIZE = 1u << 30;
+
+bool StringReplacer::Feed(const char* data, uint64_t len) {
+    while (len > MAX_FEED_SIZE) {
+        if (!DoFeed(data, MAX_FEED_SIZE)) {
+            return false;
+        }
+        data += MAX_FEED_SIZE;
+        len -= MAX_FEED_SIZE;
+    }
+    return DoFeed(data, len);
+}
+
+bool StringReplacer::FeedFile(const char* filename, uint64_t offset,
+                              uint64_t len, uint64_t window_size,
+                              string* errmsg) {
+#ifdef _MSC_VER
+    struct _stat64 info;
+    const int ret = _stat64(filename, &info);
+#else
+    struct stat info;
+    const int ret = stat(filename, &info);
+#endif
+    if (ret != 0) {
+        if (errmsg) {
+            *errmsg = "stat [" + string(filename) + "] failed: " +
+                strerror(errno);
+        }
+        return false;
+    }
+
+    const uint64_t file_size = info.st_size;
+    const uint64_t end =
+        (offset >= file_size || len >= file_size - offset) ? file_size
+                                                           : offset + len;
+    while (offset < end) {
+        const uint64_t n =
+            (end - offset < window_size) ? end - offset : window_size;
+        FileMapping fm;
+        if (!fm.Init(filename, FileMapping::READ, offset, n, errmsg)) {
+            return false;
+        }
+        if (!Feed((const char*)fm.data(), fm.size())) {
+            if (errmsg) {
+                *errmsg = "stopped by sink";
+            }
+            return false;
+        }
+        offset += n;
+    }
+
+    return true;
+}
+
+bool StringReplacer::Finish() {
+    bool ok = true;
+    Process(m_carry.data(), m_carry.size(), true, &ok);
+    m_carry.clear();
+    return ok;
+}
+
 }
@@ -0,0 +1,94 @@
+#include "cpputils/timing_wheel.h"
+#include <chrono>
+using namespace std;
+
+namespace cpputils {
+
+TimingWheel::TimingWheel(uint64_t tick_ns, uint64_t now_ns)
+    : m_tick_ns(tick_ns ? tick_ns : 1) {
+    m_base_ns = (now_ns == UINT64_MAX) ? GetMonotonicTime() : now_ns;
+    for (uint32_t l = 0; l < LEVEL_NUM; ++l) {
+        for (uint32_t i = 0; i < SLOT_NUM; ++i) {
+            auto head = &m_slots[l][i];
+            head->m_prev = head->m_next = head;
+        }
+    }
+}
+
+uint64_t TimingWheel::GetMonotonicTime() {
+    return chrono::duration_cast<chrono::nanoseconds>(
+               chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+void TimingWheel::Link(TimerNode* node) {
+    uint64_t delta = (node->m_expire > m_now) ? node->m_expire - m_now : 0;
+    if (delta > MAX_DELTA) {
+        delta = MAX_DELTA; // cascaded again in the last level
+    }
+
+    // the lowest level whose range covers `delta`
+    const uint32_t level = (delta == 0) ?
+        0 : (63 - internal::CountLeadingZeros(delta)) / SLOT_BITS;
+    const uint64_t idx = ((m_now + delta) >> (SLOT_BITS * level)) & SLOT_MASK;
+    PushBack(&m_slots[level][idx], node);
+    m_bitmap[level] |= (1ull << idx);
+}
+
+void TimingWheel::Detach(uint32_t level, uint64_t idx, TimerNode* batch) {
+    auto head = &m_slots[level][idx];
+    if (head->m_next == head) {
+        batch->m_prev = batch->m_next = batch;
+    } else {
+        batch->m_next = head->m_next;
+        batch->m_prev = head->m_prev;
+        batch->m_next->m_prev = batch;
+        batch->m_prev->m_next = batch;
+        head->m_prev = head->m_next = head;
+    }
+    m_bitmap[level] &= ~(1ull << idx);
+}
+
+void TimingWheel::Cascade() {
+    for (uint32_t l = 1; l < LEVEL_NUM; ++l) {
+        const uint64_t idx = (m_now >> (SLOT_BITS * l)) & SLOT_MASK;
+        if (m_bitmap[l] & (1ull << idx)) {
+            TimerNode batch;
+            Detach(l, idx, &batch);
+            while (batch.m_next != &batch) {
+                auto node = batch.m_next;
+                Unlink(node);
+                Link(node);
+            }
+        }
+        if (idx != 0) {
+            break;
+        }
+    }
+}
+
+uint64_t TimingWheel::GetNextCascadeTick() const {
+    uint64_t next = UINT64_MAX;
+    for (uint32_t l = 1; l < LEVEL_NUM; ++l) {
+        const uint64_t bitmap = m_bitmap[l];
+        if (bitmap == 0) {
+            continue;
+        }
+
+        // slot j of level l is cascaded at ticks b * SLOT_NUM^l where
+        // b % SLOT_NUM == j. finds the first b after the current one.
+        const uint32_t shift = SLOT_BITS * l;
+        const uint64_t cur = m_now >> shift;
+        const uint32_t start = (cur + 1) & SLOT_MASK;
+        const uint64_t rotated = start ?
+            ((bitmap >> start) | (bitmap << (SLOT_NUM - start))) : bitmap;
+        const uint64_t tick =
+            (cur + 1 + internal::CountTrailingZeros(rotated)) << shift;
+        if (tick < next) {
+            next = tick;
+        }
+    }
+    return next;
+}
+
+}
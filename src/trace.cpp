@@ -0,0 +1,355 @@
+#include "cpputils/trace.h"
+#include "cpputils/seqlock_ring_buffer.h"
+#include "cpputils/bit_utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#ifdef _MSC_VER
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h> // getpid
+#endif
+using namespace std;
+
+namespace cpputils {
+
+static constexpr uint32_t DEFAULT_BUFFER_CAPACITY = 4096;
+static constexpr uint32_t COLLECT_BATCH_SIZE = 256;
+
+/* ------------------------------------------------------------------------- */
+
+namespace {
+
+struct ThreadBuffer final {
+    ThreadBuffer(uint32_t capacity, uint32_t tid)
+        : events(capacity), tid(tid) {}
+    SeqlockRingBuffer<TraceEvent> events;
+    const uint32_t tid;
+    uint64_t next = 0; // index of the next event to collect
+    atomic<bool> exited{false};
+};
+
+struct Registry final {
+    mutex lock;
+    vector<shared_ptr<ThreadBuffer>> buffers;
+    uint32_t next_tid = 1;
+    atomic<uint32_t> capacity{DEFAULT_BUFFER_CAPACITY};
+    mutex collect_lock; // collectors drain buffers one at a time
+};
+
+/* marks the buffer as exited, which is released after being drained */
+struct ThreadBufferHolder final {
+    ~ThreadBufferHolder() {
+        if (buffer) {
+            buffer->exited.store(true, memory_order_release);
+        }
+    }
+    shared_ptr<ThreadBuffer> buffer;
+};
+
+/* timestamps are converted to nanoseconds since the base */
+struct ClockBase final {
+    ClockBase()
+        : tick(TraceNow()), time(chrono::steady_clock::now()) {}
+    const uint64_t tick;
+    const chrono::steady_clock::time_point time;
+};
+
+}
+
+/* never destroyed, so that it outlives exiting threads */
+static Registry* GetRegistry() {
+    static Registry* registry = new Registry();
+    return registry;
+}
+
+static const ClockBase& GetClockBase() {
+    static const ClockBase base;
+    return base;
+}
+
+static double GetNsPerTick() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || \
+    defined(_M_IX86)
+    // calibrates the TSC frequency, which is more accurate as time goes on
+    auto& base = GetClockBase();
+    const uint64_t ticks = TraceNow() - base.tick;
+    const auto ns = chrono::duration_cast<chrono::nanoseconds>(
+                        chrono::steady_clock::now() - base.time)
+                        .count();
+    return (ticks > 0 && ns > 0) ? (double)ns / ticks : 1.0;
+#else
+    return 1.0;
+#endif
+}
+
+static thread_local ThreadBuffer* t_buffer = nullptr;
+
+static ThreadBuffer* RegisterThread() {
+    static thread_local ThreadBufferHolder holder;
+
+    GetClockBase();
+    auto registry = GetRegistry();
+    lock_guard<mutex> guard(registry->lock);
+    holder.buffer = make_shared<ThreadBuffer>(
+        registry->capacity.load(memory_order_relaxed), registry->next_tid++);
+    registry->buffers.push_back(holder.buffer);
+    t_buffer = holder.buffer.get();
+    return t_buffer;
+}
+
+void TraceRecord(const char* name, uint64_t begin, uint64_t end) {
+    auto buffer = t_buffer;
+    if (!buffer) {
+        buffer = RegisterThread();
+    }
+    buffer->events.PushBack(TraceEvent{name, begin, end});
+}
+
+void SetTraceBufferCapacity(uint32_t capacity) {
+    GetRegistry()->capacity.store(capacity, memory_order_relaxed);
+}
+
+/* ------------------------------------------------------------------------- */
+
+uint32_t TraceHistogram::GetBucket(uint64_t value) {
+    if (value < (1ull << SUB_BITS)) {
+        return value;
+    }
+    const uint32_t exp = 63 - internal::CountLeadingZeros(value);
+    const uint32_t sub = (value >> (exp - SUB_BITS)) & ((1u << SUB_BITS) - 1);
+    return ((exp - SUB_BITS + 1) << SUB_BITS) + sub;
+}
+
+uint64_t TraceHistogram::GetBucketLowerBound(uint32_t bucket) {
+    if (bucket < (1u << SUB_BITS)) {
+        return bucket;
+    }
+    const uint32_t exp = (bucket >> SUB_BITS) + SUB_BITS - 1;
+    const uint64_t sub = bucket & ((1u << SUB_BITS) - 1);
+    return ((1ull << SUB_BITS) + sub) << (exp - SUB_BITS);
+}
+
+void TraceHistogram::Record(uint64_t value) {
+    ++m_counts[GetBucket(value)];
+    ++m_count;
+    m_sum += value;
+    if (value < m_min) {
+        m_min = value;
+    }
+    if (value > m_max) {
+        m_max = value;
+    }
+}
+
+uint64_t TraceHistogram::GetPercentile(double percentile) const {
+    if (m_count == 0) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile / 100 * m_count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    } else if (rank > m_count) {
+        rank = m_count;
+    }
+
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+        count += m_counts[i];
+        if (count >= rank) {
+            const uint64_t value = GetBucketLowerBound(i);
+            if (value < m_min) {
+                return m_min;
+            }
+            return (value > m_max) ? m_max : value;
+        }
+    }
+    return m_max;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void TraceCollector::AddEvent(const TraceEvent& e, uint32_t tid,
+                              double ns_per_tick) {
+    const uint64_t base = GetClockBase().tick;
+    const uint64_t begin = (e.begin > base) ? e.begin - base : 0;
+    const uint64_t ticks = (e.end > e.begin) ? e.end - e.begin : 0;
+    const uint64_t dur = (uint64_t)(ticks * ns_per_tick);
+
+    pair<const string, TraceHistogram>* entry;
+    auto ref = m_name_cache.find(e.name);
+    if (ref != m_name_cache.end() &&
+        strcmp(ref->second->first.c_str(), e.name) == 0) {
+        entry = ref->second;
+    } else {
+        string name(e.name);
+        auto it = m_histograms.find(name);
+        if (it == m_histograms.end()) {
+            it = m_histograms
+                     .insert(make_pair(std::move(name), TraceHistogram()))
+                     .first;
+        }
+        entry = &*it;
+        m_name_cache[e.name] = entry;
+    }
+    entry->second.Record(dur);
+
+    if (m_events.size() < m_max_events) {
+        m_events.push_back(
+            Event{&entry->first, tid, (uint64_t)(begin * ns_per_tick), dur});
+    }
+}
+
+uint64_t TraceCollector::Collect() {
+    auto registry = GetRegistry();
+    lock_guard<mutex> collect_guard(registry->collect_lock);
+
+    vector<shared_ptr<ThreadBuffer>> buffers;
+    {
+        lock_guard<mutex> guard(registry->lock);
+        buffers = registry->buffers;
+    }
+
+    const double ns_per_tick = GetNsPerTick();
+    TraceEvent events[COLLECT_BATCH_SIZE];
+    uint64_t collected = 0;
+    vector<ThreadBuffer*> drained;
+
+    lock_guard<mutex> guard(m_lock);
+    for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+        auto buffer = it->get();
+        // checked before draining, so that no event is left after release
+        const bool exited = buffer->exited.load(memory_order_acquire);
+        while (true) {
+            const uint64_t prev = buffer->next;
+            const uint32_t n = buffer->events.ReadFrom(&buffer->next, events,
+                                                       COLLECT_BATCH_SIZE);
+            m_dropped += (buffer->next - prev) - n;
+            for (uint32_t i = 0; i < n; ++i) {
+                AddEvent(events[i], buffer->tid, ns_per_tick);
+            }
+            collected += n;
+            if (n < COLLECT_BATCH_SIZE) {
+                break;
+            }
+        }
+        if (exited) {
+            drained.push_back(buffer);
+        }
+    }
+
+    if (!drained.empty()) {
+        lock_guard<mutex> registry_guard(registry->lock);
+        auto& all = registry->buffers;
+        for (auto it = all.begin(); it != all.end();) {
+            bool found = false;
+            for (auto d = drained.begin(); d != drained.end(); ++d) {
+                if (it->get() == *d) {
+                    found = true;
+                    break;
+                }
+            }
+            it = found ? all.erase(it) : it + 1;
+        }
+    }
+
+    return collected;
+}
+
+bool TraceCollector::Start(uint32_t interval_ms, string* errmsg) {
+    if (m_thread.joinable()) {
+        if (errmsg) {
+            *errmsg = "collector is already started";
+        }
+        return false;
+    }
+
+    m_stop = false;
+    m_thread = thread([this, interval_ms]() -> void {
+        unique_lock<mutex> lck(m_thread_lock);
+        while (!m_stop) {
+            m_thread_cond.wait_for(lck, chrono::milliseconds(interval_ms));
+            if (!m_stop) {
+                Collect();
+            }
+        }
+    });
+    return true;
+}
+
+void TraceCollector::Stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(m_thread_lock);
+        m_stop = true;
+    }
+    m_thread_cond.notify_one();
+    m_thread.join();
+    Collect();
+}
+
+static void AppendJsonString(const string& s, string* output) {
+    output->push_back('"');
+    for (auto it = s.begin(); it != s.end(); ++it) {
+        const char c = *it;
+        if (c == '"' || c == '\\') {
+            output->push_back('\\');
+            output->push_back(c);
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)c);
+            output->append(buf);
+        } else {
+            output->push_back(c);
+        }
+    }
+    output->push_back('"');
+}
+
+void TraceCollector::ExportChromeTrace(string* output) const {
+    const int pid = getpid();
+    char buf[128];
+
+    lock_guard<mutex> guard(m_lock);
+    output->append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (auto it = m_events.begin(); it != m_events.end(); ++it) {
+        if (it != m_events.begin()) {
+            output->push_back(',');
+        }
+        output->append("{\"name\":");
+        AppendJsonString(*it->name, output);
+        // timestamps are in microseconds
+        snprintf(buf, sizeof(buf),
+                 ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,"
+                 "\"tid\":%u}",
+                 it->ts / 1000.0, it->dur / 1000.0, pid, it->tid);
+        output->append(buf);
+    }
+    output->append("]}");
+}
+
+map<string, TraceHistogram> TraceCollector::GetHistograms() const {
+    lock_guard<mutex> guard(m_lock);
+    return m_histograms;
+}
+
+uint64_t TraceCollector::GetDroppedCount() const {
+    lock_guard<mutex> guard(m_lock);
+    return m_dropped;
+}
+
+void TraceCollector::Clear() {
+    lock_guard<mutex> guard(m_lock);
+    m_events.clear();
+    m_histograms.clear();
+    m_name_cache.clear();
+    m_dropped = 0;
+}
+
+}
@@ -0,0 +1,46 @@
+#include "cpputils/tracking_allocator.h"
+using namespace std;
+
+namespace cpputils {
+
+static void AppendMetric(const char* metric, const char* name,
+                         const char* extra_label, uint64_t value,
+                         string* output) {
+    output->append("cpputils_alloc_");
+    output->append(metric);
+    output->append("{allocator=\"");
+    output->append(name);
+    output->append("\"");
+    if (extra_label) {
+        output->append(",");
+        output->append(extra_label);
+    }
+    output->append("} ");
+    output->append(to_string(value));
+    output->append("\n");
+}
+
+void ExportAllocStats(const AllocStats& stats, const char* name,
+                      string* output) {
+    AppendMetric("live_bytes", name, nullptr, stats.live_bytes, output);
+    AppendMetric("peak_bytes", name, nullptr, stats.peak_bytes, output);
+    AppendMetric("alloc_count", name, nullptr, stats.alloc_count, output);
+    AppendMetric("free_count", name, nullptr, stats.free_count, output);
+    AppendMetric("unsized_free_count", name, nullptr, stats.unsized_free_count,
+                 output);
+
+    // buckets of prometheus histograms are cumulative
+    uint64_t count = 0;
+    for (uint32_t i = 0; i < ALLOC_STATS_SIZE_CLASS_NUM; ++i) {
+        count += stats.size_histogram[i];
+        string label;
+        if (i == ALLOC_STATS_SIZE_CLASS_NUM - 1) {
+            label = "le=\"+Inf\"";
+        } else {
+            label = "le=\"" + to_string((2ULL << i) - 1) + "\"";
+        }
+        AppendMetric("size_bucket", name, label.c_str(), count, output);
+    }
+}
+
+}
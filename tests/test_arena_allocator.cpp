@@ -0,0 +1,72 @@
+#include "cpputils/arena_allocator.h"
+#include "cpputils/skiplist.h"
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestAllocAndReset() {
+    ArenaAllocator ar(1024);
+
+    auto p1 = (char*)ar.Alloc(100);
+    auto p2 = (char*)ar.Alloc(100);
+    assert(p1 && p2);
+    assert(p2 >= p1 + 100);
+    assert(((uintptr_t)p2 % sizeof(void*)) == 0);
+    assert(ar.GetAllocatedSize() == 1024);
+
+    // larger than a block
+    auto p3 = ar.Alloc(4096);
+    assert(p3);
+    assert(ar.GetAllocatedSize() == 1024 + 4096);
+
+    ar.Reset();
+    auto p4 = (char*)ar.Alloc(100);
+    assert(p4 == p1);
+
+    // the same pattern after `Reset()` doesn't allocate from the system
+    ar.Alloc(100);
+    ar.Alloc(4096);
+    assert(ar.GetAllocatedSize() == 1024 + 4096);
+
+    ar.Release();
+    assert(ar.GetAllocatedSize() == 0);
+}
+
+static void TestAlignedAlloc() {
+    ArenaAllocator ar(1024);
+    ar.Alloc(8);
+    auto p1 = ar.Alloc(100, 64);
+    assert(p1);
+    assert(((uintptr_t)p1 % 64) == 0);
+
+    // larger than a block
+    auto p2 = ar.Alloc(1024, 4096);
+    assert(p2);
+    assert(((uintptr_t)p2 % 4096) == 0);
+}
+
+static void TestSkipListPolicy() {
+    SkipListSet<int, internal::GenericComparator<int>, ArenaAllocator> sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    assert(sl.Remove(500));
+
+    int expected = 0;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        if (expected == 500) {
+            ++expected;
+        }
+        assert(*it == expected);
+        ++expected;
+    }
+    assert(expected == 1000);
+}
+
+int main(void) {
+    TestAllocAndReset();
+    TestAlignedAlloc();
+    TestSkipListPolicy();
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "cpputils/bloom_filter.h"
+#include "cpputils/flat_hash_map.h" // FlatHash
+using namespace cpputils;
+
+#include <iostream>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestFalseRates() {
+    cout << "----- test false rates -----" << endl;
+
+    const uint64_t n = 100000;
+    internal::FlatHash<uint64_t> hash;
+    BloomFilter filter;
+    assert(filter.MayContain(hash(0))); // not initialized
+    assert(filter.Init(n));
+    assert(filter.GetCapacity() >= n);
+    assert(filter.GetMemoryUsage() >= n * 10 / 8);
+
+    for (uint64_t i = 0; i < n; ++i) {
+        filter.Add(hash(i));
+    }
+    for (uint64_t i = 0; i < n; ++i) {
+        assert(filter.MayContain(hash(i)));
+    }
+
+    uint64_t false_positives = 0;
+    for (uint64_t i = n; i < 2 * n; ++i) {
+        false_positives += filter.MayContain(hash(i));
+    }
+    cout << "false positive rate: " << (double)false_positives / n << endl;
+    assert(false_positives < n / 50);
+}
+
+static void TestClearAndResize() {
+    cout << "----- test clear and resize -----" << endl;
+
+    internal::FlatHash<uint64_t> hash;
+    BloomFilter filter;
+    assert(filter.Init(10));
+    filter.Add(hash(1));
+    filter.Clear();
+    assert(!filter.MayContain(hash(1)));
+
+    filter.Add(hash(2));
+    assert(filter.Init(10000, 16));
+    assert(filter.GetCapacity() >= 10000);
+    assert(!filter.MayContain(hash(2)));
+
+    BloomFilter moved(std::move(filter));
+    moved.Add(hash(3));
+    assert(moved.MayContain(hash(3)));
+    assert(filter.GetMemoryUsage() == 0);
+}
+
+int main(void) {
+    TestFalseRates();
+    TestClearAndResize();
+    return 0;
+}
@@ -0,0 +1,214 @@
+#include "cpputils/compact_skiplist.h"
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestBasic() {
+    CompactSkipListSet<int> sl;
+    assert(sl.IsEmpty());
+    assert(sl.GetBuffer() == nullptr);
+    assert(sl.Lookup(1) == sl.GetEndIterator());
+    assert(!sl.Remove(1));
+
+    for (int i = 100; i > 0; i -= 10) {
+        assert(sl.Insert(i).second);
+    }
+    assert(!sl.Insert(50).second);
+    assert(sl.size() == 10);
+
+    int expected = 10;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(*it == expected);
+        expected += 10;
+    }
+
+    assert(*sl.LookupGreaterEqual(21) == 30);
+    assert(*sl.LookupGreaterEqual(50) == 50);
+    assert(sl.LookupGreaterEqual(101) == sl.GetEndIterator());
+    assert(*sl.LookupLessThan(20) == 10);
+    assert(sl.LookupLessThan(10) == sl.GetEndIterator());
+
+    int removed = 0;
+    assert(sl.Remove(50, &removed));
+    assert(removed == 50);
+    assert(sl.Lookup(50) == sl.GetEndIterator());
+    assert(sl.size() == 9);
+
+    sl.Clear();
+    assert(sl.IsEmpty());
+    assert(sl.GetBeginIterator() == sl.GetEndIterator());
+}
+
+static void TestGrowAndReuse() {
+    CompactSkipListMap<uint32_t, uint64_t> sl;
+    constexpr uint32_t N = 100000;
+    for (uint32_t i = 0; i < N; ++i) {
+        assert(sl.Insert(make_pair(i, (uint64_t)i * 3)).second);
+    }
+    for (uint32_t i = 0; i < N; ++i) {
+        auto it = sl.Lookup(i);
+        assert(it != sl.GetEndIterator());
+        assert(it->second == (uint64_t)i * 3);
+    }
+
+    // freed nodes are reused by later insertions
+    const uint64_t size = sl.GetBufferSize();
+    for (uint32_t i = 0; i < N; i += 2) {
+        assert(sl.Remove(i));
+    }
+    for (uint32_t i = 0; i < N; i += 2) {
+        assert(sl.Insert(make_pair(i + N, (uint64_t)i)).second);
+    }
+    assert(sl.GetBufferSize() < size + size / 10);
+    assert(sl.size() == N);
+}
+
+static void TestLoad() {
+    CompactSkipListSet<int> sl;
+    for (int i = 0; i < 1000; ++i) {
+        sl.Insert(i * 2);
+    }
+
+    // copies the buffer to somewhere else, as if it was read from a file
+    vector<char> data((const char*)sl.GetBuffer(),
+                      (const char*)sl.GetBuffer() + sl.GetBufferSize());
+    sl.Clear();
+
+    CompactSkipListSet<int> loaded;
+    assert(loaded.Load(data.data(), data.size()));
+    assert(loaded.size() == 1000);
+    int expected = 0;
+    for (auto it = loaded.GetBeginIterator(); it != loaded.GetEndIterator();
+         ++it) {
+        assert(*it == expected);
+        expected += 2;
+    }
+    assert(loaded.Insert(1).second);
+    assert(*loaded.LookupGreaterEqual(1) == 1);
+
+    string errmsg;
+    CompactSkipListSet<uint64_t> other;
+    assert(!other.Load(data.data(), data.size(), &errmsg));
+    assert(!errmsg.empty());
+    assert(!loaded.Load(data.data(), 8));
+
+    // the first node follows the 128-byte header, with its level at offset
+    // 4 and links after it
+    const uint32_t first_level = 128 + 4, first_forward = 128 + 8;
+    uint32_t corrupted[] = {0, 13, 0x7fffffff, 128 / 8};
+    for (uint32_t i = 0; i < 4; ++i) {
+        vector<char> bad(data);
+        const uint32_t offset = (i < 2) ? first_level : first_forward;
+        memcpy(&bad[offset], &corrupted[i], sizeof(uint32_t));
+        errmsg.clear();
+        assert(!loaded.Load(bad.data(), bad.size(), &errmsg));
+        assert(!errmsg.empty());
+        // the contents are unchanged
+        assert(loaded.size() == 1001);
+    }
+
+    // nodes are laid out in the order of keys. each one is a 4-byte value,
+    // its level and its links, padded to 8 bytes. `count` is at offset 16 of
+    // the header, followed by `level`, the free lists and the head links.
+    auto get_u32 = [](const vector<char>& d, uint64_t offset) -> uint32_t {
+        uint32_t v;
+        memcpy(&v, &d[offset], sizeof(v));
+        return v;
+    };
+    auto set_u32 = [](vector<char>* d, uint64_t offset, uint32_t v) -> void {
+        memcpy(&(*d)[offset], &v, sizeof(v));
+    };
+    const uint64_t count_offset = 16, free_list_offset = 28,
+                   head_forward_offset = 76;
+    auto get_node_size = [](uint32_t level) -> uint64_t {
+        return (8 + 4 * level + 7) & ~7ull;
+    };
+
+    // a node of level 2 is unlinked from level 0 only, and links to itself
+    // there. lookups going down from it would never end.
+    uint64_t prev_link = head_forward_offset, offset = 128;
+    while (get_u32(data, offset + 4) < 2) {
+        prev_link = offset + 8;
+        offset += get_node_size(get_u32(data, offset + 4));
+    }
+    {
+        vector<char> bad(data);
+        set_u32(&bad, prev_link, get_u32(data, offset + 8));
+        set_u32(&bad, offset + 8, offset / 8);
+        set_u32(&bad, count_offset, 999);
+        assert(!loaded.Load(bad.data(), bad.size()));
+        assert(loaded.size() == 1001);
+    }
+
+    // the last node is also put into the free list of its level
+    uint64_t last = 128;
+    while (last + get_node_size(get_u32(data, last + 4)) < data.size()) {
+        last += get_node_size(get_u32(data, last + 4));
+    }
+    {
+        vector<char> bad(data);
+        const uint32_t level = get_u32(data, last + 4);
+        set_u32(&bad, free_list_offset + 4 * (level - 1), last / 8);
+        assert(!loaded.Load(bad.data(), bad.size()));
+        assert(loaded.size() == 1001);
+    }
+}
+
+static void TestUnalignedValue() {
+    // link offsets following 1-byte values are aligned
+    CompactSkipListSet<char> sl;
+    for (int i = 126; i >= 0; i -= 3) {
+        assert(sl.Insert((char)i).second);
+    }
+    char expected = 0;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(*it == expected);
+        expected += 3;
+    }
+
+    CompactSkipListSet<char> loaded;
+    assert(loaded.Load(sl.GetBuffer(), sl.GetBufferSize()));
+    assert(loaded.size() == sl.size());
+    assert(*loaded.LookupGreaterEqual(100) == 102);
+}
+
+static void TestRandomOps() {
+    CompactSkipListSet<int> sl;
+    set<int> expected;
+    mt19937 gen(12345);
+    uniform_int_distribution<int> dist(0, 999);
+
+    for (int i = 0; i < 100000; ++i) {
+        const int v = dist(gen);
+        if (gen() % 3 == 0) {
+            assert(sl.Remove(v) == (expected.erase(v) == 1));
+        } else {
+            assert(sl.Insert(v).second == expected.insert(v).second);
+        }
+    }
+
+    assert(sl.size() == expected.size());
+    auto eit = expected.begin();
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(*it == *eit);
+        ++eit;
+    }
+    assert(eit == expected.end());
+}
+
+int main(void) {
+    TestBasic();
+    TestGrowAndReuse();
+    TestLoad();
+    TestUnalignedValue();
+    TestRandomOps();
+    cout << "all tests passed." << endl;
+    return 0;
+}
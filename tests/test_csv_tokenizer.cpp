@@ -0,0 +1,155 @@
+#include "cpputils/csv_tokenizer.h"
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+typedef vector<vector<string>> Records;
+
+static Records Tokenize(const string& text, char delim = ',') {
+    Records records(1);
+    CsvTokenizer tokenizer(text.data(), text.size(), delim);
+    CsvField field;
+    string unescaped;
+    while (tokenizer.Next(&field)) {
+        if (field.need_unescape) {
+            CsvUnescape(field.data, field.size, &unescaped);
+            records.back().push_back(unescaped);
+        } else {
+            records.back().push_back(string(field.data, field.size));
+        }
+        if (field.is_last) {
+            records.push_back(vector<string>());
+        }
+    }
+    records.pop_back();
+    return records;
+}
+
+/* parses char by char */
+static Records SimpleTokenize(const string& text) {
+    Records records;
+    vector<string> record;
+    string field;
+    bool in_quote = false, has_field = false;
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        has_field = true;
+        if (in_quote) {
+            if (c == '"') {
+                if (i + 1 < text.size() && text[i + 1] == '"') {
+                    field.push_back('"');
+                    ++i;
+                } else {
+                    in_quote = false;
+                }
+            } else {
+                field.push_back(c);
+            }
+        } else if (c == '"') {
+            in_quote = true;
+        } else if (c == ',') {
+            record.push_back(field);
+            field.clear();
+        } else if (c == '\n') {
+            record.push_back(field);
+            field.clear();
+            records.push_back(record);
+            record.clear();
+            has_field = false;
+        } else {
+            field.push_back(c);
+        }
+    }
+    if (has_field) {
+        record.push_back(field);
+        records.push_back(record);
+    }
+    return records;
+}
+
+static void TestBasic() {
+    cout << "----- test basic -----" << endl;
+
+    assert(Tokenize("").empty());
+
+    auto records = Tokenize("a,b\r\nc,,d\n");
+    assert(records.size() == 2);
+    assert(records[0].size() == 2 && records[0][1] == "b");
+    assert(records[1].size() == 3 && records[1][1] == "" &&
+           records[1][2] == "d");
+
+    records = Tokenize("a,");
+    assert(records.size() == 1 && records[0].size() == 2);
+    assert(records[0][1] == "");
+
+    // an empty field at the end of a 64-byte block
+    records = Tokenize(string(63, 'a') + ",");
+    assert(records.size() == 1 && records[0].size() == 2);
+    assert(records[0][1] == "");
+
+    records = Tokenize("a|\"b|c\"", '|');
+    assert(records.size() == 1 && records[0].size() == 2);
+    assert(records[0][1] == "b|c");
+
+    // quotes around a field are removed without copying
+    const string text = "\"x,y\",\"say \"\"hi\"\"\"\n";
+    CsvTokenizer tokenizer(text.data(), text.size());
+    CsvField field;
+    assert(tokenizer.Next(&field));
+    assert(!field.need_unescape && !field.is_last);
+    assert(field.data == text.data() + 1);
+    assert(string(field.data, field.size) == "x,y");
+    assert(tokenizer.Next(&field));
+    assert(field.need_unescape && field.is_last);
+    string unescaped;
+    CsvUnescape(field.data, field.size, &unescaped);
+    assert(unescaped == "say \"hi\"");
+    assert(!tokenizer.Next(&field));
+    assert(!tokenizer.Next(&field));
+}
+
+static void TestRandom() {
+    cout << "----- test random -----" << endl;
+
+    // quoted fields cross 64-byte blocks
+    mt19937 gen(1234);
+    const char chars[] = {'a', 'b', ',', '\n', '"', ' '};
+    for (int round = 0; round < 2000; ++round) {
+        string text;
+        const int field_num = gen() % 100;
+        for (int i = 0; i < field_num; ++i) {
+            const bool quoted = (gen() % 3 == 0);
+            if (quoted) {
+                text.push_back('"');
+            }
+            const int len = gen() % 90;
+            for (int j = 0; j < len; ++j) {
+                char c = chars[gen() % sizeof(chars)];
+                if (!quoted && (c == ',' || c == '\n' || c == '"')) {
+                    c = 'x';
+                }
+                text.push_back(c);
+                if (c == '"') {
+                    text.push_back('"');
+                }
+            }
+            if (quoted) {
+                text.push_back('"');
+            }
+            text.push_back((gen() % 4 == 0) ? '\n' : ',');
+        }
+        assert(Tokenize(text) == SimpleTokenize(text));
+    }
+}
+
+int main(void) {
+    TestBasic();
+    TestRandom();
+    return 0;
+}
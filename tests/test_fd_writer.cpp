@@ -0,0 +1,72 @@
+#include "cpputils/fd_writer.h"
+using namespace cpputils;
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+static string ReadAll(int fd) {
+    string content;
+    char buf[4096];
+    assert(lseek(fd, 0, SEEK_SET) == 0);
+    while (true) {
+        auto n = read(fd, buf, sizeof(buf));
+        assert(n >= 0);
+        if (n == 0) {
+            return content;
+        }
+        content.append(buf, n);
+    }
+}
+
+static void TestWrite() {
+    cout << "----- test write -----" << endl;
+
+    char filename[] = "/tmp/test_fd_writer_XXXXXX";
+    const int fd = mkstemp(filename);
+    assert(fd >= 0);
+    unlink(filename);
+
+    string expected;
+    {
+        FdWriter writer(fd, 64);
+        mt19937 gen(1357);
+        for (int i = 0; i < 1000; ++i) {
+            // mostly small pieces, sometimes larger than the buffer
+            string piece((gen() % 10 == 0) ? gen() % 300 : gen() % 20,
+                         'a' + i % 26);
+            assert(writer.Write(piece.data(), piece.size()));
+            expected += piece;
+        }
+        assert(writer.GetWrittenSize() <= expected.size());
+        assert(writer.Flush());
+        assert(writer.GetWrittenSize() == expected.size());
+
+        // flushed by the destructor
+        assert(writer.Write("tail", 4));
+        expected += "tail";
+    }
+    assert(ReadAll(fd) == expected);
+    close(fd);
+}
+
+static void TestWriteError() {
+    cout << "----- test write error -----" << endl;
+
+    FdWriter writer(-1, 16);
+    assert(writer.Write("buffered", 8));
+    assert(!writer.Flush());
+    assert(!writer.Write("larger than the buffer", 22));
+}
+
+int main(void) {
+    TestWrite();
+    TestWriteError();
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include "cpputils/filtered_skiplist.h"
+using namespace cpputils;
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <string>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestRandomOperations() {
+    cout << "----- test random operations -----" << endl;
+
+    FilteredSkipListSet<uint32_t> list;
+    set<uint32_t> expected;
+    mt19937 gen(2233);
+    for (int i = 0; i < 200000; ++i) {
+        // keys are inserted and then mostly removed in phases
+        const bool inserting = (i / 50000) % 2 == 0;
+        const uint32_t key = gen() % 20000;
+        if (gen() % 4 != 0 ? inserting : !inserting) {
+            assert(list.Insert(key).second == expected.insert(key).second);
+        } else {
+            assert(list.Remove(key) == (expected.erase(key) > 0));
+        }
+
+        const uint32_t probe = gen() % 40000;
+        auto it = list.Lookup(probe);
+        assert((it != list.GetEndIterator()) == (expected.count(probe) > 0));
+    }
+    assert(list.size() == expected.size());
+
+    auto stats = list.GetFilterStats();
+    assert(stats.lookups == 200000);
+    assert(stats.rebuilds > 0);
+    assert(stats.capacity >= list.size());
+    assert(stats.memory_bytes > 0);
+    cout << "filtered: " << stats.filtered
+         << ", false positives: " << stats.false_positives << endl;
+    // stale keys of removals are false positives until rebuilt
+    assert(stats.false_positives < stats.filtered / 10);
+
+    list.ResetFilterStats();
+    assert(list.GetFilterStats().lookups == 0);
+}
+
+static void TestMap() {
+    cout << "----- test map -----" << endl;
+
+    FilteredSkipListMap<string, uint32_t> m;
+    for (uint32_t i = 0; i < 5000; ++i) {
+        assert(m.TryEmplace("key-" + to_string(i), i).second);
+    }
+    assert(!m.InsertOrAssign(string("key-1"), 100u).second);
+    assert(m.Lookup("key-1")->second == 100);
+    assert(m.Lookup("key-4999")->second == 4999);
+    assert(m.Lookup("key-5000") == m.GetEndIterator());
+    assert(m.LookupGreaterEqual(string("key-5"))->first == "key-5");
+
+    pair<string, uint32_t> removed;
+    assert(m.Remove("key-2", &removed) && removed.second == 2);
+    assert(m.Lookup("key-2") == m.GetEndIterator());
+
+    m.Clear();
+    assert(m.IsEmpty() && m.size() == 0);
+    assert(m.Lookup("key-3") == m.GetEndIterator());
+}
+
+int main(void) {
+    TestRandomOperations();
+    TestMap();
+    return 0;
+}
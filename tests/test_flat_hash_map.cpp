@@ -0,0 +1,143 @@
+#include "cpputils/flat_hash_map.h"
+#include "cpputils/arena_allocator.h"
+using namespace cpputils;
+
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+template <typename Map>
+static void CheckEqual(const Map& m,
+                       const unordered_map<uint32_t, uint64_t>& expected) {
+    assert(m.size() == expected.size());
+    uint64_t n = 0;
+    for (auto it = m.GetBeginIterator(); it != m.GetEndIterator(); ++it) {
+        auto e = expected.find(it->first);
+        assert(e != expected.end() && e->second == it->second);
+        ++n;
+    }
+    assert(n == expected.size());
+}
+
+static void TestRandomOperations() {
+    cout << "----- test random operations -----" << endl;
+
+    FlatHashMap<uint32_t, uint64_t> m;
+    unordered_map<uint32_t, uint64_t> expected;
+    mt19937 gen(9876);
+    for (int i = 0; i < 200000; ++i) {
+        // a small key range makes many deletions and reuses of slots
+        const uint32_t key = gen() % 5000;
+        switch (gen() % 4) {
+            case 0: {
+                auto ret = m.Insert(make_pair(key, (uint64_t)i));
+                auto e = expected.insert(make_pair(key, (uint64_t)i));
+                assert(ret.second == e.second);
+                assert(ret.first->second == e.first->second);
+                break;
+            }
+            case 1: {
+                pair<uint32_t, uint64_t> value;
+                const bool removed = m.Remove(key, &value);
+                auto e = expected.find(key);
+                assert(removed == (e != expected.end()));
+                if (removed) {
+                    assert(value.second == e->second);
+                    expected.erase(e);
+                }
+                break;
+            }
+            case 2: {
+                auto it = m.Lookup(key);
+                auto e = expected.find(key);
+                if (e == expected.end()) {
+                    assert(it == m.GetEndIterator());
+                } else {
+                    assert(it != m.GetEndIterator() && it->second == e->second);
+                }
+                break;
+            }
+            default:
+                m.InsertOrAssign(key, (uint64_t)i);
+                expected[key] = i;
+                break;
+        }
+    }
+
+    CheckEqual(m, expected);
+    assert(m.size() * 8 <= m.GetCapacity() * 7);
+}
+
+static void TestStringKeys() {
+    cout << "----- test string keys -----" << endl;
+
+    FlatHashMap<string, uint32_t> m;
+    for (uint32_t i = 0; i < 10000; ++i) {
+        auto ret = m.TryEmplace("key-" + to_string(i), i);
+        assert(ret.second && ret.first->second == i);
+    }
+    assert(!m.TryEmplace("key-1", 0).second);
+    assert(m.Lookup("key-1")->second == 1);
+    assert(m.Lookup("key-10000") == m.GetEndIterator());
+
+    auto moved = std::move(m);
+    assert(m.IsEmpty() && m.Lookup("key-1") == m.GetEndIterator());
+    assert(moved.size() == 10000 && moved.Lookup("key-9999")->second == 9999);
+
+    moved.Clear();
+    assert(moved.IsEmpty() && moved.GetCapacity() == 0);
+}
+
+static void TestSetAndReserve() {
+    cout << "----- test set and reserve -----" << endl;
+
+    FlatHashSet<uint64_t, internal::FlatHash<uint64_t>, equal_to<uint64_t>,
+                ArenaAllocator>
+        s;
+    assert(s.Reserve(1000));
+    const uint64_t capacity = s.GetCapacity();
+    for (uint64_t i = 0; i < 1000; ++i) {
+        assert(s.Emplace(i << 32).second);
+    }
+    assert(s.GetCapacity() == capacity);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        assert(*s.Lookup(i << 32) == (i << 32));
+        assert(s.Lookup(i) == s.GetEndIterator() || i == 0);
+    }
+
+    // insertions after many removals reuse the capacity
+    for (int round = 0; round < 10; ++round) {
+        for (uint64_t i = 0; i < 1000; ++i) {
+            assert(s.Remove(i << 32));
+        }
+        for (uint64_t i = 0; i < 1000; ++i) {
+            assert(s.Insert(i << 32).second);
+        }
+    }
+    assert(s.size() == 1000 && s.GetCapacity() == capacity);
+
+    // the arena holding the slots is moved along with them
+    auto moved = std::move(s);
+    assert(s.IsEmpty() && s.GetAllocatedSize() == 0);
+    assert(moved.size() == 1000 && *moved.Lookup(999ull << 32) == 999ull << 32);
+    assert(s.Insert(1).second && *s.Lookup(1) == 1);
+
+    s = std::move(moved);
+    assert(moved.IsEmpty());
+    for (uint64_t i = 0; i < 1000; ++i) {
+        assert(*s.Lookup(i << 32) == (i << 32));
+    }
+    assert(s.Lookup(1) == s.GetEndIterator());
+}
+
+int main(void) {
+    TestRandomOperations();
+    TestStringKeys();
+    TestSetAndReserve();
+    return 0;
+}
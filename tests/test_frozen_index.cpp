@@ -0,0 +1,168 @@
+#include "cpputils/frozen_index.h"
+using namespace cpputils;
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <set>
+#include <unistd.h>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+template <typename Index>
+static void CheckIndex(const Index& index, const set<uint32_t>& expected) {
+    assert(index.size() == expected.size());
+    auto eit = expected.begin();
+    for (auto it = index.GetBeginIterator(); it != index.GetEndIterator();
+         ++it) {
+        assert(*it == *eit);
+        ++eit;
+    }
+    assert(eit == expected.end());
+
+    // probes between and around all values
+    for (uint32_t key = 0; key <= 2 * expected.size() + 2; ++key) {
+        auto it = index.Lookup(key);
+        if (expected.count(key)) {
+            assert(it != index.GetEndIterator() && *it == key);
+        } else {
+            assert(it == index.GetEndIterator());
+        }
+
+        it = index.LookupGreaterEqual(key);
+        auto ge = expected.lower_bound(key);
+        if (ge == expected.end()) {
+            assert(it == index.GetEndIterator());
+        } else {
+            assert(*it == *ge);
+        }
+
+        it = index.LookupLessThan(key);
+        if (ge == expected.begin()) {
+            assert(it == index.GetEndIterator());
+        } else {
+            --ge;
+            assert(*it == *ge);
+        }
+    }
+}
+
+static void TestLookup() {
+    cout << "----- test lookup -----" << endl;
+
+    mt19937 gen(3579);
+    for (uint32_t n = 0; n < 300; ++n) {
+        SkipListSet<uint32_t> list;
+        set<uint32_t> expected;
+        while (expected.size() < n) {
+            const uint32_t key = 1 + gen() % (2 * n);
+            list.Insert(key);
+            expected.insert(key);
+        }
+
+        FrozenSet<uint32_t> index;
+        assert(Freeze(list, &index));
+        CheckIndex(index, expected);
+    }
+}
+
+static void TestMultiSet() {
+    cout << "----- test multi set -----" << endl;
+
+    SkipListMultiMap<uint32_t, uint32_t> list;
+    for (uint32_t i = 0; i < 100; ++i) {
+        list.Insert(make_pair(i / 10, i));
+    }
+
+    FrozenMap<uint32_t, uint32_t> index;
+    assert(Freeze(list, &index));
+    auto it = index.LookupGreaterEqual(3u);
+    for (uint32_t i = 30; i < 40; ++i) {
+        assert(it->first == 3 && it->second == i);
+        ++it;
+    }
+    assert(index.Lookup(5u)->second == 50);
+    assert(index.LookupLessThan(5u)->second == 49);
+}
+
+/* the number of mappings of `filename` in this process */
+static uint32_t CountMappings(const char* filename) {
+    ifstream maps("/proc/self/maps");
+    uint32_t n = 0;
+    string line;
+    while (getline(maps, line)) {
+        if (line.find(filename) != string::npos) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+static void TestFile() {
+    cout << "----- test file -----" << endl;
+
+    SkipListSet<uint32_t> list;
+    set<uint32_t> expected;
+    for (uint32_t i = 1; i < 1000; i += 3) {
+        list.Insert(i);
+        expected.insert(i);
+    }
+    FrozenSet<uint32_t> index;
+    assert(Freeze(list, &index));
+
+    char filename[] = "/tmp/test_frozen_index_XXXXXX";
+    const int fd = mkstemp(filename);
+    assert(fd >= 0);
+    close(fd);
+
+    string errmsg;
+    assert(index.WriteToFile(filename, &errmsg));
+
+    FrozenSet<uint32_t> mapped;
+    assert(mapped.Open(filename, &errmsg));
+    CheckIndex(mapped, expected);
+
+    // reopening unmaps the previous file
+    for (int i = 0; i < 5; ++i) {
+        FrozenSet<uint32_t> reopened;
+        assert(reopened.Open(filename, &errmsg));
+        assert(reopened.Open(filename, &errmsg));
+        CheckIndex(reopened, expected);
+    }
+    assert(CountMappings(filename) == 1);
+
+    FrozenSet<uint32_t> loaded;
+    assert(loaded.Load(mapped.GetBuffer(), mapped.GetBufferSize(), &errmsg));
+    CheckIndex(loaded, expected);
+
+    // truncated data
+    assert(!loaded.Load(mapped.GetBuffer(), mapped.GetBufferSize() - 1,
+                        &errmsg));
+    CheckIndex(loaded, expected);
+
+    // a count that overflows the size check. it follows the magic and the
+    // value size in the header.
+    string corrupted((const char*)mapped.GetBuffer(), mapped.GetBufferSize());
+    const uint64_t huge_count = UINT64_MAX;
+    memcpy(&corrupted[8], &huge_count, sizeof(huge_count));
+    assert(!loaded.Load(corrupted.data(), corrupted.size(), &errmsg));
+    CheckIndex(loaded, expected);
+
+    // values of a different size
+    FrozenSet<uint64_t> other;
+    assert(!other.Open(filename, &errmsg));
+    assert(!errmsg.empty());
+
+    unlink(filename);
+    assert(!other.Open(filename, &errmsg));
+}
+
+int main(void) {
+    TestLookup();
+    TestMultiSet();
+    TestFile();
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "cpputils/indexed_skiplist_map.h"
+using namespace cpputils;
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestRandomOperations() {
+    cout << "----- test random operations -----" << endl;
+
+    IndexedSkipListMap<uint32_t, uint64_t> m;
+    map<uint32_t, uint64_t> expected;
+    mt19937 gen(1122);
+    for (int i = 0; i < 100000; ++i) {
+        const uint32_t key = gen() % 3000;
+        switch (gen() % 4) {
+            case 0: {
+                auto ret = m.Insert(make_pair(key, (uint64_t)i));
+                auto e = expected.insert(make_pair(key, (uint64_t)i));
+                assert(ret.second == e.second);
+                assert(ret.first->second == e.first->second);
+                break;
+            }
+            case 1: {
+                pair<uint32_t, uint64_t> value;
+                const bool removed = m.Remove(key, &value);
+                auto e = expected.find(key);
+                assert(removed == (e != expected.end()));
+                if (removed) {
+                    assert(value.second == e->second);
+                    expected.erase(e);
+                }
+                break;
+            }
+            case 2: {
+                auto p = m.Find(key);
+                auto e = expected.find(key);
+                assert((p == nullptr) == (e == expected.end()));
+                assert(!p || p->second == e->second);
+
+                auto it = m.LookupGreaterEqual(key);
+                auto eit = expected.lower_bound(key);
+                if (eit == expected.end()) {
+                    assert(it == m.GetEndIterator());
+                } else {
+                    assert(it->first == eit->first);
+                }
+                break;
+            }
+            default: {
+                auto ret = m.InsertOrAssign(key, (uint64_t)i);
+                assert(ret.first->second == (uint64_t)i);
+                expected[key] = i;
+                break;
+            }
+        }
+    }
+
+    assert(m.size() == expected.size());
+    auto eit = expected.begin();
+    for (auto it = m.GetBeginIterator(); it != m.GetEndIterator(); ++it) {
+        assert(it->first == eit->first && it->second == eit->second);
+        ++eit;
+    }
+    assert(eit == expected.end());
+}
+
+static void TestStringKeys() {
+    cout << "----- test string keys -----" << endl;
+
+    IndexedSkipListMap<string, uint32_t> m;
+    assert(m.TryEmplace("b", 2).second);
+    assert(m.Insert(make_pair(string("a"), 1u)).second);
+    assert(m.Insert(make_pair(string("c"), 3u)).second);
+    assert(!m.TryEmplace("a", 10).second);
+    assert(m.Find("a")->second == 1);
+    assert(m.LookupLessThan(string("c"))->first == "b");
+
+    m.Clear();
+    assert(m.IsEmpty() && !m.Find("a"));
+}
+
+int main(void) {
+    TestRandomOperations();
+    TestStringKeys();
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "cpputils/mvcc_skiplist.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+class CountingAllocator : public GenericCpuAllocator {
+public:
+    uint32_t GetLiveNum() const {
+        return m_live_num;
+    }
+
+protected:
+    void* DoAlloc(uint64_t bytes, uint64_t alignment) override {
+        ++m_live_num;
+        auto ptr = GenericCpuAllocator::DoAlloc(bytes, alignment);
+        // nodes MUST be aligned for their atomics
+        assert(((uintptr_t)ptr % alignment) == 0 && alignment >= 8);
+        return ptr;
+    }
+    void DoFree(void* ptr, uint64_t bytes) override {
+        --m_live_num;
+        GenericCpuAllocator::DoFree(ptr, bytes);
+    }
+
+private:
+    uint32_t m_live_num = 0;
+};
+
+typedef MvccSkipListSet<int, internal::GenericComparator<int>,
+                        CountingAllocator>
+    TestSet;
+
+static vector<int> Collect(const TestSet::Snapshot& snapshot) {
+    vector<int> res;
+    for (auto it = snapshot.GetBeginIterator();
+         it != snapshot.GetEndIterator(); ++it) {
+        res.push_back(*it);
+    }
+    return res;
+}
+
+static void TestSnapshot() {
+    cout << "----- test snapshot -----" << endl;
+
+    TestSet sl;
+    for (int i = 0; i < 10; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    assert(!sl.Insert(5).second);
+
+    auto s1 = sl.GetSnapshot();
+    assert(s1.IsValid());
+
+    int value = -1;
+    assert(sl.Remove(5, &value));
+    assert(value == 5);
+    assert(!sl.Remove(5));
+    assert(!sl.Lookup(5));
+    assert(sl.Insert(5).second); // a new version
+    assert(sl.Remove(3));
+    assert(sl.Insert(100).second);
+
+    auto s2 = sl.GetSnapshot();
+
+    assert((Collect(s1) == vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    assert((Collect(s2) == vector<int>{0, 1, 2, 4, 5, 6, 7, 8, 9, 100}));
+
+    assert(s1.Lookup(3) != s1.GetEndIterator());
+    assert(s2.Lookup(3) == s2.GetEndIterator());
+    assert(s1.Lookup(100) == s1.GetEndIterator());
+    assert(*s2.LookupGreaterEqual(3) == 4);
+    assert(*s1.LookupGreaterEqual(3) == 3);
+
+    // nodes removed are kept for `s1`
+    sl.Reclaim();
+    assert(sl.GetLiveNum() == 12);
+    assert(s1.Lookup(3) != s1.GetEndIterator());
+
+    // unlinked but `s2` may still be positioned on them
+    s1.Release();
+    sl.Reclaim();
+    assert(sl.GetLiveNum() == 12);
+    assert((Collect(s2) == vector<int>{0, 1, 2, 4, 5, 6, 7, 8, 9, 100}));
+
+    s2.Release();
+    sl.Reclaim();
+    assert(sl.GetLiveNum() == 10);
+}
+
+static void TestTooManySnapshots() {
+    cout << "----- test too many snapshots -----" << endl;
+
+    MvccSkipList<int, int, internal::GenericComparator<int>,
+                 internal::SkipListReturnSelfFromValue<int>,
+                 GenericCpuAllocator, 2>
+        sl;
+    auto s1 = sl.GetSnapshot();
+    auto s2 = sl.GetSnapshot();
+    auto s3 = sl.GetSnapshot();
+    assert(s1.IsValid() && s2.IsValid());
+    assert(!s3.IsValid());
+    s1.Release();
+    s3 = sl.GetSnapshot();
+    assert(s3.IsValid());
+}
+
+/*
+  the writer inserts keys in ascending order and removes the smallest one, so
+  every consistent snapshot contains consecutive keys.
+*/
+static void TestConcurrentReaders() {
+    cout << "----- test concurrent readers -----" << endl;
+
+    MvccSkipListSet<int> sl;
+    atomic<bool> stop(false);
+
+    vector<thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back([&sl, &stop]() -> void {
+            while (!stop.load()) {
+                auto snapshot = sl.GetSnapshot();
+                assert(snapshot.IsValid());
+                int prev = -1;
+                for (auto it = snapshot.GetBeginIterator();
+                     it != snapshot.GetEndIterator(); ++it) {
+                    assert(prev == -1 || *it == prev + 1);
+                    prev = *it;
+                }
+            }
+        });
+    }
+
+    const int window = 1000;
+    for (int i = 0; i < window; ++i) {
+        sl.Insert(i);
+    }
+    for (int i = window; i < 200000; ++i) {
+        sl.Insert(i);
+        assert(sl.Remove(i - window));
+    }
+
+    stop.store(true);
+    for (auto it = readers.begin(); it != readers.end(); ++it) {
+        it->join();
+    }
+}
+
+int main(void) {
+    TestSnapshot();
+    TestTooManySnapshots();
+    TestConcurrentReaders();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#include "cpputils/numa_allocator.h"
+#include "cpputils/skiplist.h"
+#include <cstring>
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestAllocAndFree() {
+    const uint32_t node = NumaAllocator::GetCurrentNode();
+    NumaAllocator ar(node);
+
+    auto p1 = ar.Alloc(100);
+    assert(p1);
+    assert(((uintptr_t)p1 % 16) == 0);
+    memset(p1, 0, 100);
+    assert(ar.GetNodeUsage(node) == 112);
+
+    auto p2 = ar.Alloc(100, 64);
+    assert(p2);
+    assert(((uintptr_t)p2 % 64) == 0);
+
+    auto p3 = ar.Alloc(1 << 20, 4096);
+    assert(p3);
+    assert(((uintptr_t)p3 % 4096) == 0);
+    memset(p3, 0, 1 << 20);
+
+    ar.Free(p3);
+    ar.Free(p2, 100);
+    ar.Free(p1);
+    assert(ar.GetNodeUsage(node) == 0);
+
+    // freed blocks are reused
+    assert(ar.Alloc(100) == p1);
+    ar.Free(p1);
+}
+
+static void TestSkipListPolicy() {
+    SkipListSet<int, internal::GenericComparator<int>, NumaAllocator> sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    assert(sl.GetNodeUsage(NumaAllocator::GetCurrentNode()) > 0);
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Remove(i));
+    }
+    assert(sl.GetNodeUsage(NumaAllocator::GetCurrentNode()) == 0);
+}
+
+static void TestVMAllocator() {
+    NumaVMAllocator vmr;
+    assert(vmr.Init(1 << 20));
+
+    CompactAddrManager mgr(&vmr);
+    auto addr = mgr.Alloc(100);
+    assert(addr == vmr.GetReservedBase());
+    memset((void*)addr, 0, 100);
+    assert(vmr.GetAllocatedSize() > 0);
+    assert(vmr.GetNodeUsage(NumaAllocator::GetCurrentNode()) ==
+           vmr.GetAllocatedSize());
+    mgr.Free(addr, 100);
+
+    // exceeds the reserved size
+    assert(mgr.Alloc(2 << 20) == UINTPTR_MAX);
+}
+
+int main(void) {
+    TestAllocAndFree();
+    TestSkipListPolicy();
+    TestVMAllocator();
+    return 0;
+}
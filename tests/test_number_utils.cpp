@@ -0,0 +1,181 @@
+#include "cpputils/number_utils.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static bool ParseUInt(const string& s, uint64_t* v) {
+    return ParseUInt(s.data(), s.size(), v);
+}
+
+static bool ParseInt(const string& s, int64_t* v) {
+    return ParseInt(s.data(), s.size(), v);
+}
+
+static bool ParseDouble(const string& s, double* v) {
+    return ParseDouble(s.data(), s.size(), v);
+}
+
+static void TestParseInt() {
+    cout << "----- test parse int -----" << endl;
+
+    uint64_t u;
+    assert(ParseUInt("0", &u) && u == 0);
+    assert(ParseUInt("000123", &u) && u == 123);
+    assert(ParseUInt("1234567890123", &u) && u == 1234567890123);
+    assert(ParseUInt("18446744073709551615", &u) && u == UINT64_MAX);
+    assert(ParseUInt("0018446744073709551615", &u) && u == UINT64_MAX);
+    assert(!ParseUInt("18446744073709551616", &u));
+    assert(!ParseUInt("99999999999999999999", &u));
+    assert(!ParseUInt("", &u));
+    assert(!ParseUInt("-1", &u));
+    assert(!ParseUInt("12345678a", &u));
+    assert(!ParseUInt("1234567:", &u));
+    assert(!ParseUInt(" 1", &u));
+
+    int64_t i;
+    assert(ParseInt("-9223372036854775808", &i) && i == INT64_MIN);
+    assert(ParseInt("9223372036854775807", &i) && i == INT64_MAX);
+    assert(ParseInt("+42", &i) && i == 42);
+    assert(ParseInt("-0", &i) && i == 0);
+    assert(!ParseInt("-9223372036854775809", &i));
+    assert(!ParseInt("9223372036854775808", &i));
+    assert(!ParseInt("-", &i));
+    assert(!ParseInt("1.0", &i));
+
+    mt19937_64 gen(1234);
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    for (int n = 0; n < 100000; ++n) {
+        const int64_t v = (int64_t)(gen() >> (gen() % 64));
+        const int64_t expected = (n % 2) ? v : -v;
+        const unsigned int len = FormatInt(expected, buf);
+        assert(string(buf, len) == to_string(expected));
+        assert(ParseInt(buf, len, &i) && i == expected);
+    }
+
+    assert(string(buf, FormatInt(INT64_MIN, buf)) == to_string(INT64_MIN));
+    assert(string(buf, FormatUInt(UINT64_MAX, buf)) == to_string(UINT64_MAX));
+    assert(string(buf, FormatUInt(0, buf)) == "0");
+}
+
+static void TestParseDouble() {
+    cout << "----- test parse double -----" << endl;
+
+    double d;
+    assert(ParseDouble("0", &d) && d == 0);
+    assert(ParseDouble("-0.0", &d) && d == 0 && signbit(d));
+    assert(ParseDouble("3.25", &d) && d == 3.25);
+    assert(ParseDouble("-.5", &d) && d == -0.5);
+    assert(ParseDouble("5.", &d) && d == 5);
+    assert(ParseDouble("1e10", &d) && d == 1e10);
+    assert(ParseDouble("1.5E-3", &d) && d == 1.5e-3);
+    assert(ParseDouble("0.1", &d) && d == 0.1);
+    assert(ParseDouble("123456789012345678901234567890", &d) &&
+           d == 123456789012345678901234567890.0);
+    assert(ParseDouble("1e300", &d) && d == 1e300);
+    assert(ParseDouble("4.9406564584124654e-324", &d) &&
+           d == numeric_limits<double>::denorm_min());
+    assert(ParseDouble("1e-400", &d) && d == 0);
+    assert(ParseDouble("inf", &d) && isinf(d));
+    assert(ParseDouble("nan", &d) && isnan(d));
+    assert(!ParseDouble("", &d));
+    assert(!ParseDouble(".", &d));
+    assert(!ParseDouble("1e", &d));
+    assert(!ParseDouble("1.2.3", &d));
+    assert(!ParseDouble(" 1", &d));
+    assert(!ParseDouble("1 ", &d));
+    assert(!ParseDouble("e5", &d));
+
+    // agrees with strtod
+    mt19937 gen(1234);
+    for (int n = 0; n < 100000; ++n) {
+        string s;
+        if (gen() % 2) {
+            s.push_back('-');
+        }
+        const int int_len = gen() % 12, frac_len = gen() % 25;
+        for (int i = 0; i < int_len; ++i) {
+            s.push_back('0' + gen() % 10);
+        }
+        s.push_back('.');
+        for (int i = 0; i < frac_len; ++i) {
+            s.push_back('0' + gen() % 10);
+        }
+        if (int_len + frac_len == 0) {
+            s.push_back('0');
+        }
+        if (gen() % 2) {
+            s += "e" + to_string((int)(gen() % 80) - 40);
+        }
+        assert(ParseDouble(s, &d));
+        assert(d == strtod(s.c_str(), nullptr));
+    }
+}
+
+static void TestFormatDouble() {
+    cout << "----- test format double -----" << endl;
+
+    char buf[NUMBER_FORMAT_BUF_SIZE];
+    assert(string(buf, FormatDouble(0.1, buf)) == "0.1");
+    assert(string(buf, FormatDouble(-2.5, buf)) == "-2.5");
+    assert(string(buf, FormatDouble(100, buf)) == "100");
+    assert(string(buf, FormatDouble(-0.0, buf)) == "-0");
+    assert(string(buf, FormatDouble(1e100, buf)) == "1e+100");
+    assert(string(buf, FormatDouble(INFINITY, buf)) == "inf");
+    assert(string(buf, FormatDouble(NAN, buf)) == "nan");
+    assert(string(buf, FormatDouble(1.15, buf)) == "1.15");
+    assert(string(buf, FormatDouble(4.35, buf)) == "4.35");
+    assert(string(buf, FormatDouble(0.29, buf)) == "0.29");
+    assert(string(buf, FormatDouble(-0.57, buf)) == "-0.57");
+    assert(string(buf, FormatDouble(4.015, buf)) == "4.015");
+    assert(string(buf, FormatDouble(5e-324, buf)) == "5e-324");
+    assert(string(buf, FormatDouble(1.5e-10, buf)) == "1.5e-10");
+    assert(string(buf, FormatDouble(1.7976931348623157e308, buf)) ==
+           "1.7976931348623157e+308");
+    assert(string(buf, FormatDouble(0.1 + 0.2, buf)) == "0.30000000000000004");
+
+    // round trip
+    mt19937_64 gen(5678);
+    for (int n = 0; n < 100000; ++n) {
+        double expected;
+        if (n % 2) {
+            const uint64_t bits = gen();
+            memcpy(&expected, &bits, sizeof(expected));
+            if (isnan(expected)) {
+                continue;
+            }
+        } else {
+            expected = (double)(gen() % 100000000) / 1000.0;
+        }
+
+        const unsigned int len = FormatDouble(expected, buf);
+        assert(len < NUMBER_FORMAT_BUF_SIZE);
+        double d;
+        assert(ParseDouble(buf, len, &d));
+        assert(d == expected);
+
+        // agrees with strtod
+        buf[len] = '\0';
+        assert(strtod(buf, nullptr) == expected);
+
+        // no trailing zeros after the decimal point
+        const string s(buf, len);
+        assert(s.find('.') == string::npos || s.find('e') != string::npos ||
+               s.back() != '0');
+    }
+}
+
+int main(void) {
+    TestParseInt();
+    TestParseDouble();
+    TestFormatDouble();
+    return 0;
+}
@@ -0,0 +1,52 @@
+#include "cpputils/pool_allocator.h"
+#include "cpputils/skiplist.h"
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestAllocAndFree() {
+    PoolAllocator<24, 4> ar;
+
+    assert(!ar.Alloc(25));
+
+    void* ptrs[10];
+    for (int i = 0; i < 10; ++i) {
+        ptrs[i] = ar.Alloc(24);
+        assert(ptrs[i]);
+        assert(((uintptr_t)ptrs[i] % sizeof(void*)) == 0);
+    }
+
+    // freed blocks are reused first
+    ar.Free(ptrs[3]);
+    ar.Free(ptrs[7]);
+    assert(ar.Alloc(8) == ptrs[7]);
+    assert(ar.Alloc(8) == ptrs[3]);
+}
+
+static void TestSkipListPolicy() {
+    // large enough for nodes of any level
+    SkipListSet<int, internal::GenericComparator<int>, PoolAllocator<128>> sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        assert(sl.Remove(i));
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        assert(sl.Insert(i).second);
+    }
+
+    int expected = 0;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(*it == expected);
+        ++expected;
+    }
+    assert(expected == 1000);
+}
+
+int main(void) {
+    TestAllocAndFree();
+    TestSkipListPolicy();
+    return 0;
+}
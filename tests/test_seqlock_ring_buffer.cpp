@@ -0,0 +1,163 @@
+#include "cpputils/seqlock_ring_buffer.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestBasic() {
+    cout << "----- test basic -----" << endl;
+
+    SeqlockRingBuffer<int> rb(3);
+    assert(rb.capacity() == 4);
+    assert(rb.size() == 0);
+
+    int items[8];
+    assert(rb.Snapshot(items, 8) == 0);
+
+    rb.PushBack(10);
+    rb.PushBack(20);
+    assert(rb.size() == 2);
+    assert(rb.Snapshot(items, 8) == 2);
+    assert(items[0] == 10 && items[1] == 20);
+
+    for (int i = 3; i <= 6; ++i) {
+        rb.PushBack(i * 10);
+    }
+    assert(rb.size() == 4);
+    assert(rb.Snapshot(items, 8) == 4);
+    assert(items[0] == 30 && items[3] == 60);
+    assert(rb.Snapshot(items, 2) == 2);
+    assert(items[0] == 50 && items[1] == 60);
+}
+
+struct Event final {
+    uint64_t idx;
+    uint64_t check[3];
+};
+
+static void TestConcurrentReaders() {
+    cout << "----- test concurrent readers -----" << endl;
+
+    constexpr uint32_t K = 64;
+    constexpr uint64_t EVENT_NUM = 2000000;
+
+    SeqlockRingBuffer<Event> rb(256);
+    atomic<bool> stop(false);
+
+    vector<thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&rb, &stop]() -> void {
+            Event events[K];
+            uint64_t snapshot_num = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint32_t n = rb.Snapshot(events, K);
+                for (uint32_t i = 0; i < n; ++i) {
+                    const Event& e = events[i];
+                    for (uint32_t j = 0; j < 3; ++j) {
+                        assert(e.check[j] == e.idx * (j + 2));
+                    }
+                    if (i > 0) {
+                        assert(e.idx == events[i - 1].idx + 1);
+                    }
+                }
+                ++snapshot_num;
+            }
+            assert(snapshot_num > 0);
+        });
+    }
+
+    for (uint64_t i = 0; i < EVENT_NUM; ++i) {
+        Event e;
+        e.idx = i;
+        for (uint32_t j = 0; j < 3; ++j) {
+            e.check[j] = i * (j + 2);
+        }
+        rb.PushBack(e);
+    }
+    stop.store(true);
+
+    for (auto it = readers.begin(); it != readers.end(); ++it) {
+        it->join();
+    }
+
+    Event events[K];
+    assert(rb.Snapshot(events, K) == K);
+    assert(events[K - 1].idx == EVENT_NUM - 1);
+}
+
+static void TestReadFrom() {
+    cout << "----- test read from -----" << endl;
+
+    SeqlockRingBuffer<int> rb(4);
+    int items[8];
+    uint64_t next = 0;
+    assert(rb.ReadFrom(&next, items, 8) == 0);
+    assert(next == 0);
+
+    rb.PushBack(10);
+    rb.PushBack(20);
+    rb.PushBack(30);
+    assert(rb.ReadFrom(&next, items, 2) == 2);
+    assert(next == 2 && items[0] == 10 && items[1] == 20);
+    assert(rb.ReadFrom(&next, items, 8) == 1);
+    assert(next == 3 && items[0] == 30);
+
+    // 40 and 50 are overwritten before being read
+    for (int i = 4; i <= 9; ++i) {
+        rb.PushBack(i * 10);
+    }
+    assert(rb.ReadFrom(&next, items, 8) == 4);
+    assert(next == 9 && items[0] == 60 && items[3] == 90);
+
+    // a consumer reads every item in order or skips it
+    constexpr uint64_t EVENT_NUM = 2000000;
+    SeqlockRingBuffer<Event> events(256);
+    atomic<bool> stop(false);
+    thread reader([&events, &stop]() -> void {
+        Event buf[64];
+        uint64_t next = 0, read_num = 0, last_idx = 0;
+        while (true) {
+            const bool stopped = stop.load(std::memory_order_acquire);
+            const uint64_t prev = next;
+            const uint32_t n = events.ReadFrom(&next, buf, 64);
+            for (uint32_t i = 0; i < n; ++i) {
+                const Event& e = buf[i];
+                for (uint32_t j = 0; j < 3; ++j) {
+                    assert(e.check[j] == e.idx * (j + 2));
+                }
+                assert(e.idx >= prev && e.idx < next);
+                assert(read_num == 0 || e.idx > last_idx);
+                last_idx = e.idx;
+            }
+            read_num += n;
+            if (stopped && n == 0) {
+                break;
+            }
+        }
+        assert(next == EVENT_NUM);
+        assert(read_num > 0 && last_idx == EVENT_NUM - 1);
+    });
+
+    for (uint64_t i = 0; i < EVENT_NUM; ++i) {
+        Event e;
+        e.idx = i;
+        for (uint32_t j = 0; j < 3; ++j) {
+            e.check[j] = i * (j + 2);
+        }
+        events.PushBack(e);
+    }
+    stop.store(true, std::memory_order_release);
+    reader.join();
+}
+
+int main(void) {
+    TestBasic();
+    TestConcurrentReaders();
+    TestReadFrom();
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "cpputils/shm_ring_buffer.h"
+#include "cpputils/file_mapping.h"
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static const string g_filename =
+    "/tmp/cpputils_test_shm_ring_buffer." + to_string(getpid());
+
+static void TestPushAndPop() {
+    cout << "----- test push and pop -----" << endl;
+
+    ShmRingBuffer rb;
+    string errmsg;
+    assert(!rb.Create(g_filename.c_str(), 16, 10, &errmsg));
+    assert(rb.Create(g_filename.c_str(), 16, 8, &errmsg));
+    assert(rb.GetSlotSize() == 16);
+    assert(rb.GetCapacity() == 8);
+
+    char buf[16];
+    uint32_t size = 0;
+    uint64_t dropped = 0;
+    assert(!rb.Pop(buf, &size));
+    assert(!rb.Push(buf, 17));
+
+    assert(rb.Push("hello", 5));
+    assert(rb.Pop(buf, &size, &dropped));
+    assert(size == 5 && memcmp(buf, "hello", 5) == 0);
+    assert(dropped == 0);
+    assert(!rb.Pop(buf, &size));
+
+    // the oldest records are overwritten
+    for (uint32_t i = 0; i < 20; ++i) {
+        assert(rb.Push(&i, sizeof(i)));
+    }
+    assert(rb.Pop(buf, &size, &dropped));
+    assert(dropped == 12);
+    assert(*(uint32_t*)buf == 12);
+    for (uint32_t i = 13; i < 20; ++i) {
+        assert(rb.Pop(buf, &size, &dropped));
+        assert(dropped == 0);
+        assert(*(uint32_t*)buf == i);
+    }
+    assert(!rb.Pop(buf, &size));
+    assert(!rb.Wait(10));
+
+    // another mapping starts from the oldest record available
+    ShmRingBuffer reader;
+    assert(reader.Init(g_filename.c_str(), &errmsg));
+    assert(reader.Pop(buf, &size));
+    assert(*(uint32_t*)buf == 12);
+}
+
+static void TestMultiProducers() {
+    cout << "----- test multiple producers -----" << endl;
+
+    constexpr uint32_t THREAD_NUM = 4;
+    constexpr uint32_t RECORD_NUM = 100000;
+
+    ShmRingBuffer consumer;
+    assert(consumer.Create(g_filename.c_str(), sizeof(uint64_t), 1024));
+
+    vector<thread> producers;
+    for (uint32_t t = 0; t < THREAD_NUM; ++t) {
+        producers.emplace_back([t]() -> void {
+            ShmRingBuffer rb;
+            assert(rb.Init(g_filename.c_str()));
+            for (uint64_t i = 0; i < RECORD_NUM; ++i) {
+                uint64_t record = ((uint64_t)t << 32) | i;
+                assert(rb.Push(&record, sizeof(record)));
+            }
+        });
+    }
+
+    // records of each producer are in order
+    uint64_t last[THREAD_NUM];
+    for (uint32_t i = 0; i < THREAD_NUM; ++i) {
+        last[i] = UINT64_MAX;
+    }
+
+    uint64_t received = 0, total_dropped = 0;
+    while (received + total_dropped < THREAD_NUM * RECORD_NUM) {
+        uint64_t record, dropped;
+        uint32_t size;
+        if (!consumer.Pop(&record, &size, &dropped)) {
+            consumer.Wait(100);
+            continue;
+        }
+        assert(size == sizeof(record));
+        const uint32_t t = record >> 32;
+        const uint64_t i = record & 0xffffffff;
+        assert(t < THREAD_NUM);
+        assert(last[t] == UINT64_MAX || i > last[t]);
+        last[t] = i;
+        ++received;
+        total_dropped += dropped;
+    }
+
+    for (auto it = producers.begin(); it != producers.end(); ++it) {
+        it->join();
+    }
+    cout << "received " << received << ", dropped " << total_dropped << endl;
+}
+
+static void TestCrossProcess() {
+    cout << "----- test cross process -----" << endl;
+
+    constexpr uint32_t RECORD_NUM = 1000;
+
+    ShmRingBuffer consumer;
+    assert(consumer.Create(g_filename.c_str(), 64, 2048));
+
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        ShmRingBuffer producer;
+        if (!producer.Init(g_filename.c_str())) {
+            _exit(1);
+        }
+        for (uint32_t i = 0; i < RECORD_NUM; ++i) {
+            string record = "record " + to_string(i);
+            producer.Push(record.data(), record.size());
+            if (i % 100 == 0) {
+                usleep(1000);
+            }
+        }
+        _exit(0);
+    }
+
+    char buf[64];
+    uint32_t size;
+    uint64_t dropped;
+    for (uint32_t i = 0; i < RECORD_NUM;) {
+        if (!consumer.Pop(buf, &size, &dropped)) {
+            assert(consumer.Wait(5000));
+            continue;
+        }
+        assert(dropped == 0);
+        assert(string(buf, size) == "record " + to_string(i));
+        ++i;
+    }
+
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void TestCrashedWriter() {
+    cout << "----- test crashed writer -----" << endl;
+
+    ShmRingBuffer rb;
+    assert(rb.Create(g_filename.c_str(), 16, 4));
+    assert(rb.Push("0", 1));
+
+    // a pid of a process which has exited
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        _exit(0);
+    }
+    assert(waitpid(pid, nullptr, 0) == pid);
+
+    // as if `pid` crashed while writing record 1 to slot 1. the header takes
+    // 192 bytes and each slot takes 64 bytes, starting with `seq` and
+    // followed by `size` and the pid of the writer.
+    FileMapping fm;
+    assert(fm.Init(g_filename.c_str(),
+                   FileMapping::READ | FileMapping::WRITE | FileMapping::SHARED,
+                   0, UINT64_MAX));
+    auto base = (char*)fm.data();
+    uint64_t head = 2, seq = 1 * 2 + 1;
+    uint32_t writer = pid;
+    memcpy(base + 64, &head, sizeof(head));
+    memcpy(base + 192 + 64, &seq, sizeof(seq));
+    memcpy(base + 192 + 64 + 12, &writer, sizeof(writer));
+
+    // the consumer skips the record
+    char buf[16];
+    uint32_t size;
+    uint64_t dropped;
+    assert(rb.Pop(buf, &size, &dropped) && dropped == 0);
+    assert(string(buf, size) == "0");
+    assert(!rb.Pop(buf, &size, &dropped) && dropped == 1);
+
+    // record 5 takes over slot 1 instead of waiting forever
+    for (int i = 2; i <= 5; ++i) {
+        const string record = to_string(i);
+        assert(rb.Push(record.data(), record.size()));
+    }
+    for (int i = 2; i <= 5; ++i) {
+        assert(rb.Pop(buf, &size, &dropped) && dropped == 0);
+        assert(string(buf, size) == to_string(i));
+    }
+    assert(!rb.Pop(buf, &size));
+}
+
+static void TestInvalidCapacity() {
+    cout << "----- test invalid capacity -----" << endl;
+
+    {
+        ShmRingBuffer rb;
+        assert(rb.Create(g_filename.c_str(), 16, 4));
+    }
+
+    // `capacity` follows `magic` and `slot_size` in the header
+    FileMapping fm;
+    assert(fm.Init(g_filename.c_str(),
+                   FileMapping::READ | FileMapping::WRITE | FileMapping::SHARED,
+                   0, UINT64_MAX));
+    const uint32_t capacities[] = {0, 3};
+    for (uint32_t i = 0; i < 2; ++i) {
+        memcpy((char*)fm.data() + 8, &capacities[i], sizeof(uint32_t));
+        ShmRingBuffer rb;
+        string errmsg;
+        assert(!rb.Init(g_filename.c_str(), &errmsg));
+        assert(!errmsg.empty());
+    }
+}
+
+int main(void) {
+    TestPushAndPop();
+    TestMultiProducers();
+    TestCrossProcess();
+    TestCrashedWriter();
+    TestInvalidCapacity();
+    unlink(g_filename.c_str());
+    return 0;
+}
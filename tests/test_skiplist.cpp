@@ -1,8 +1,14 @@
 #include "cpputils/skiplist.h"
+#include "cpputils/string_utils.h"
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <set>
+#include <string>
 #include <sys/time.h>
 #include <random>
+#include <vector>
 using namespace std;
 using namespace cpputils;
 
@@ -128,6 +134,495 @@ static void TestSkipListMap(void) {
     }
 }
 
+class SizeCheckingAllocator : public GenericCpuAllocator {
+public:
+    ~SizeCheckingAllocator() {
+        assert(m_ptr2size.empty());
+    }
+    void* Alloc(uint64_t bytes) override {
+        auto ptr = GenericCpuAllocator::Alloc(bytes);
+        m_ptr2size[ptr] = bytes;
+        return ptr;
+    }
+    void Free(void*) override {
+        assert(false);
+    }
+
+protected:
+    void DoFree(void* ptr, uint64_t bytes) override {
+        auto it = m_ptr2size.find(ptr);
+        assert(it != m_ptr2size.end());
+        assert(it->second == bytes);
+        m_ptr2size.erase(it);
+        GenericCpuAllocator::DoFree(ptr, bytes);
+    }
+
+private:
+    map<void*, uint64_t> m_ptr2size;
+};
+
+/* overrides the pure virtual functions only */
+class MinimalAllocator : public Allocator {
+public:
+    void* Alloc(uint64_t bytes) override {
+        ++m_live_num;
+        return malloc(bytes);
+    }
+    void Free(void* ptr) override {
+        --m_live_num;
+        free(ptr);
+    }
+    int64_t GetLiveNum() const {
+        return m_live_num;
+    }
+
+private:
+    int64_t m_live_num = 0;
+};
+
+static void TestSizedFree() {
+    cout << "----- test sized free -----" << endl;
+
+    SkipListSet<int, internal::GenericComparator<int>, SizeCheckingAllocator>
+        sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    for (int i = 0; i < 1000; i += 3) {
+        assert(sl.Remove(i));
+    }
+}
+
+static void TestMinimalAllocator() {
+    cout << "----- test minimal allocator -----" << endl;
+
+    SkipListSet<int, internal::GenericComparator<int>, MinimalAllocator> sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    assert(sl.GetLiveNum() == 1000);
+    for (int i = 0; i < 1000; i += 2) {
+        assert(sl.Remove(i));
+    }
+    assert(sl.GetLiveNum() == 500);
+    assert(sl.Lookup(501) != sl.GetEndIterator());
+    assert(sl.Lookup(500) == sl.GetEndIterator());
+
+    // the sized and aligned versions fall back to the unsized ones
+    MinimalAllocator minimal;
+    Allocator* a = &minimal;
+    void* ptr = a->Alloc(64, 16);
+    assert(ptr && ((uintptr_t)ptr % 16) == 0);
+    assert(!a->Alloc(64, 4096));
+    a->Free(ptr, 64);
+    assert(minimal.GetLiveNum() == 0);
+}
+
+/* compares `std::string` keys with fields returned by `StringSplitter` */
+struct StringFieldComparator final {
+    typedef void is_transparent;
+
+    uint32_t operator()(const string& a, const string& b) const {
+        return Compare(a.data(), a.size(), b.data(), b.size());
+    }
+    uint32_t operator()(const string& a,
+                        const pair<const char*, unsigned int>& b) const {
+        return Compare(a.data(), a.size(), b.first, b.second);
+    }
+
+private:
+    static uint32_t Compare(const char* a, size_t alen, const char* b,
+                            size_t blen) {
+        int ret = memcmp(a, b, std::min(alen, blen));
+        if (ret == 0) {
+            if (alen == blen) {
+                return SKIPLIST_DIFF_EQ;
+            }
+            return (alen < blen) ? SKIPLIST_DIFF_LT : SKIPLIST_DIFF_GT;
+        }
+        return (ret < 0) ? SKIPLIST_DIFF_LT : SKIPLIST_DIFF_GT;
+    }
+};
+
+static void TestHeterogeneousLookup() {
+    cout << "----- test heterogeneous lookup -----" << endl;
+
+    // `GenericComparator` is not transparent, so keys are converted once
+    SkipListMap<string, int> sl;
+    assert(sl.Insert(make_pair(string("bar"), 1)).second);
+    assert(sl.Insert(make_pair(string("foo"), 2)).second);
+
+    auto it = sl.Lookup("foo");
+    assert(it != sl.GetEndIterator() && it->second == 2);
+    assert(sl.Lookup("baz") == sl.GetEndIterator());
+    assert(sl.LookupGreaterEqual("baz")->first == "foo");
+    assert(sl.LookupLessThan("baz")->first == "bar");
+    assert(sl.Remove("bar"));
+    assert(sl.Lookup("bar") == sl.GetEndIterator());
+
+    SkipListMap<string, int, StringFieldComparator> fields;
+    fields.Insert(make_pair(string("a"), 1));
+    fields.Insert(make_pair(string("bc"), 2));
+
+    const char* text = "bc,a,d";
+    StringSplitter splitter(text, strlen(text));
+    auto field = splitter.Next(",", 1);
+    assert(fields.Lookup(field)->second == 2);
+    field = splitter.Next(",", 1);
+    assert(fields.Lookup(field)->second == 1);
+    field = splitter.Next(",", 1);
+    assert(fields.Lookup(field) == fields.GetEndIterator());
+    assert(fields.Lookup(string("a"))->second == 1);
+    assert(fields.Remove(string("a")));
+
+    // braced initializers and explicit value types need `const Key&`
+    SkipListSet<pair<int, int>> pairs;
+    assert(pairs.Insert(make_pair(1, 2)).second);
+    assert(pairs.Lookup({1, 2}) != pairs.GetEndIterator());
+    assert(pairs.LookupGreaterEqual({1, 0})->second == 2);
+    pair<int, int> removed;
+    const bool ok = pairs.Remove<pair<int, int>>({1, 2}, &removed);
+    assert(ok);
+    assert(removed.second == 2);
+}
+
+struct Counted final {
+    Counted(int v) : value(v) {
+        ++construct_count;
+    }
+    Counted(const Counted& c) : value(c.value) {
+        ++construct_count;
+    }
+    Counted& operator=(int v) {
+        value = v;
+        return *this;
+    }
+    int value;
+    static int construct_count;
+};
+
+int Counted::construct_count = 0;
+
+static void TestEmplace() {
+    cout << "----- test emplace -----" << endl;
+
+    SkipListMap<int, Counted> sl;
+
+    auto ret_pair = sl.TryEmplace(1, 10);
+    assert(ret_pair.second);
+    assert(ret_pair.first->second.value == 10);
+    assert(Counted::construct_count == 1);
+
+    // value is not constructed if the key exists
+    ret_pair = sl.TryEmplace(1, 11);
+    assert(!ret_pair.second);
+    assert(ret_pair.first->second.value == 10);
+    assert(Counted::construct_count == 1);
+
+    ret_pair = sl.InsertOrAssign(1, 12);
+    assert(!ret_pair.second);
+    assert(ret_pair.first->second.value == 12);
+    assert(Counted::construct_count == 1);
+
+    ret_pair = sl.InsertOrAssign(2, 20);
+    assert(ret_pair.second);
+    assert(ret_pair.first->second.value == 20);
+
+    ret_pair = sl.Emplace(3, 30);
+    assert(ret_pair.second);
+    assert(ret_pair.first->second.value == 30);
+
+    ret_pair = sl.Emplace(3, 31);
+    assert(!ret_pair.second);
+    assert(ret_pair.first->second.value == 30);
+
+    int expected = 1;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(it->first == expected);
+        ++expected;
+    }
+    assert(expected == 4);
+}
+
+/* checks both order and towers */
+static void CheckSet(const SkipListSet<int>& sl, const set<int>& expected) {
+    auto it = sl.GetBeginIterator();
+    for (auto e = expected.begin(); e != expected.end(); ++e) {
+        assert(it != sl.GetEndIterator());
+        assert(*it == *e);
+        ++it;
+
+        auto found = sl.Lookup(*e);
+        assert(found != sl.GetEndIterator() && *found == *e);
+        assert(sl.Lookup(*e + 1000000) == sl.GetEndIterator());
+    }
+    assert(it == sl.GetEndIterator());
+    assert(sl.IsEmpty() == expected.empty());
+}
+
+static void FillRandomly(SkipListSet<int>* sl, set<int>* expected, int n,
+                         int mod, std::mt19937* gen) {
+    for (int i = 0; i < n; ++i) {
+        int v = (*gen)() % mod;
+        assert(sl->Insert(v).second == expected->insert(v).second);
+    }
+}
+
+static void TestMergeAndSplit() {
+    cout << "----- test merge and split -----" << endl;
+
+    std::mt19937 gen(1234);
+    SkipListSet<int> a, b;
+    set<int> ea, eb;
+    FillRandomly(&a, &ea, 5000, 20000, &gen);
+    FillRandomly(&b, &eb, 5000, 20000, &gen);
+
+    set<int> merged(ea), left;
+    for (auto v : eb) {
+        if (!merged.insert(v).second) {
+            left.insert(v);
+        }
+    }
+
+    a.Merge(&b);
+    CheckSet(a, merged);
+    CheckSet(b, left);
+
+    SkipListSet<int> tail;
+    assert(a.SplitAt(10000, &tail));
+    assert(!a.SplitAt(5000, &tail)); // not empty
+    set<int> etail(merged.lower_bound(10000), merged.end());
+    merged.erase(merged.lower_bound(10000), merged.end());
+    CheckSet(a, merged);
+    CheckSet(tail, etail);
+
+    SkipListSet<int> empty;
+    assert(a.SplitAt(0, &empty));
+    CheckSet(a, set<int>());
+    CheckSet(empty, merged);
+}
+
+static void TestSetOperations() {
+    cout << "----- test set operations -----" << endl;
+
+    std::mt19937 gen(5678);
+    for (int round = 0; round < 3; ++round) {
+        SkipListSet<int> a, b;
+        set<int> ea, eb;
+        FillRandomly(&a, &ea, 3000, 8000, &gen);
+        FillRandomly(&b, &eb, 3000, 8000, &gen);
+
+        set<int> expected;
+        if (round == 0) {
+            assert(a.UnionWith(b));
+            expected = ea;
+            expected.insert(eb.begin(), eb.end());
+        } else if (round == 1) {
+            a.IntersectWith(b);
+            for (auto v : ea) {
+                if (eb.count(v)) {
+                    expected.insert(v);
+                }
+            }
+        } else {
+            a.SubtractWith(b);
+            for (auto v : ea) {
+                if (!eb.count(v)) {
+                    expected.insert(v);
+                }
+            }
+        }
+
+        CheckSet(a, expected);
+        CheckSet(b, eb);
+    }
+}
+
+static void TestPopFront() {
+    cout << "----- test pop front -----" << endl;
+
+    SkipListSet<int> sl;
+    int value = 0;
+    assert(!sl.PopFront(&value));
+
+    for (int i = 1000; i > 0; --i) {
+        sl.Insert(i);
+    }
+    assert(sl.PopFront(&value));
+    assert(value == 1);
+    assert(sl.PopFront());
+    assert(*sl.GetBeginIterator() == 3);
+
+    vector<int> popped;
+    auto count = sl.PopWhile([](int v) -> bool { return (v < 500); },
+                             [&popped](int v) -> void { popped.push_back(v); });
+    assert(count == 497);
+    assert(popped.size() == 497);
+    for (uint32_t i = 0; i < popped.size(); ++i) {
+        assert(popped[i] == (int)i + 3);
+    }
+
+    // towers are still valid
+    for (int i = 500; i <= 1000; ++i) {
+        assert(sl.Lookup(i) != sl.GetEndIterator());
+    }
+    assert(sl.Lookup(499) == sl.GetEndIterator());
+
+    count = sl.PopWhile([](int) -> bool { return true; }, [](int) -> void {});
+    assert(count == 501);
+    assert(sl.IsEmpty());
+}
+
+static void TestMultiMap() {
+    cout << "----- test multimap -----" << endl;
+
+    // timers sharing the same deadlines
+    SkipListMultiMap<int, int> sl;
+    for (int i = 0; i < 300; ++i) {
+        auto ret_pair = sl.Insert(make_pair(i % 3, i));
+        assert(ret_pair.second);
+        assert(ret_pair.first->second == i);
+    }
+    assert(sl.Emplace(1, 1000).second);
+
+    // equal keys are kept in insertion order
+    int prev_key = 0, prev_value = -1;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        if (it->first != prev_key) {
+            assert(it->first == prev_key + 1);
+            prev_key = it->first;
+            prev_value = -1;
+        }
+        assert(it->second > prev_value);
+        prev_value = it->second;
+    }
+
+    assert(sl.Lookup(1)->second == 1);
+    pair<int, int> removed;
+    assert(sl.Remove(1, &removed));
+    assert(removed.second == 1);
+    assert(sl.Lookup(1)->second == 4);
+
+    vector<int> expired;
+    auto count = sl.PopWhile(
+        [](const pair<int, int>& p) -> bool { return (p.first <= 1); },
+        [&expired](pair<int, int>&& p) -> void {
+            expired.push_back(p.second);
+        });
+    assert(count == 200);
+    assert(expired.front() == 0 && expired.back() == 1000);
+    assert(sl.GetBeginIterator()->first == 2);
+
+    SkipListMultiSet<int> a, b;
+    for (int i = 0; i < 10; ++i) {
+        a.Insert(i % 2);
+        b.Insert(i % 2);
+    }
+    a.Merge(&b);
+    assert(b.IsEmpty());
+    int n = 0;
+    for (auto it = a.GetBeginIterator(); it != a.GetEndIterator(); ++it) {
+        assert(*it == (n < 10 ? 0 : 1));
+        ++n;
+    }
+    assert(n == 20);
+
+    SkipListMultiSet<int> c;
+    c.Insert(0);
+    c.Insert(1);
+    c.Insert(1);
+    a.SubtractWith(c);
+    n = 0;
+    for (auto it = a.GetBeginIterator(); it != a.GetEndIterator(); ++it) {
+        ++n;
+    }
+    assert(n == 17);
+}
+
+template <typename List>
+static void CheckStats(const List& sl, uint64_t count, uint32_t max_level) {
+    auto stats = sl.GetStructureStats();
+    assert(stats.count == count);
+    assert(stats.level_node_num.size() <= max_level);
+    if (count == 0) {
+        assert(stats.level_node_num.empty());
+        return;
+    }
+    assert(stats.level_node_num[0] == count);
+    for (size_t i = 1; i < stats.level_node_num.size(); ++i) {
+        assert(stats.level_node_num[i] <= stats.level_node_num[i - 1]);
+    }
+    assert(stats.avg_search_path >= 1);
+    assert(stats.memory_bytes > count * sizeof(*sl.GetBeginIterator()));
+}
+
+static void TestLevelsAndStats() {
+    cout << "----- test levels and stats -----" << endl;
+
+    SkipListSet<int> a(12345), b(12345);
+    for (int i = 0; i < 10000; ++i) {
+        a.Insert(i);
+        b.Insert(i);
+    }
+    CheckStats(a, 10000, 12);
+    auto sa = a.GetStructureStats(), sb = b.GetStructureStats();
+    assert(sa.level_node_num == sb.level_node_num);
+    assert(sa.avg_search_path == sb.avg_search_path);
+    assert(sa.avg_search_path < 100);
+
+    // a linked list visits (n + 1) / 2 nodes on average
+    SkipListSet<int, internal::GenericComparator<int>, GenericCpuAllocator, 1>
+        flat;
+    for (int i = 0; i < 99; ++i) {
+        flat.Insert(i);
+    }
+    CheckStats(flat, 99, 1);
+    assert(flat.GetStructureStats().avg_search_path == 50);
+
+    SkipListSet<int, internal::GenericComparator<int>, GenericCpuAllocator, 4,
+                2>
+        low;
+    SkipListSet<int, internal::GenericComparator<int>, GenericCpuAllocator,
+                16, 3>
+        tri;
+    for (int i = 0; i < 5000; ++i) {
+        low.Insert(i);
+        tri.Insert(i);
+    }
+    CheckStats(low, 5000, 4);
+    assert(low.GetStructureStats().level_node_num.size() == 4);
+    CheckStats(tri, 5000, 16);
+
+    SkipListMap<int, string> m(1);
+    for (int i = 0; i < 10000; ++i) {
+        m.InsertOrAssign(i, std::to_string(i));
+    }
+    for (int i = 0; i < 10000; ++i) {
+        if (i % 100 != 0) {
+            assert(m.Remove(i));
+        }
+    }
+    m.Rebalance();
+    CheckStats(m, 100, 12);
+    int n = 0;
+    for (auto it = m.GetBeginIterator(); it != m.GetEndIterator(); ++it) {
+        assert(it->first == n * 100);
+        assert(it->second == std::to_string(n * 100));
+        ++n;
+    }
+    assert(n == 100);
+    for (int i = 0; i < 10000; ++i) {
+        auto it = m.Lookup(i);
+        assert((it != m.GetEndIterator()) == (i % 100 == 0));
+    }
+    assert(m.InsertOrAssign(50, "50").second);
+    assert(m.Lookup(50)->second == "50");
+
+    SkipListMap<int, string> empty;
+    empty.Rebalance();
+    CheckStats(empty, 0, 12);
+}
+
 static void PrepareTestData(vector<uint32_t>* data) {
     std::mt19937 gen(time(nullptr));
     for (uint32_t i = 0; i < 555555; ++i) {
@@ -210,6 +705,15 @@ static void TestPerf() {
 int main(void) {
     TestSkipListSet();
     TestSkipListMap();
+    TestSizedFree();
+    TestMinimalAllocator();
+    TestHeterogeneousLookup();
+    TestEmplace();
+    TestMergeAndSplit();
+    TestSetOperations();
+    TestPopFront();
+    TestMultiMap();
+    TestLevelsAndStats();
     TestPerf();
     return 0;
 }
@@ -0,0 +1,43 @@
+#include "cpputils/stl_allocator.h"
+#include "cpputils/arena_allocator.h"
+#include "cpputils/generic_cpu_allocator.h"
+#include <map>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestVector() {
+    ArenaAllocator ar;
+    vector<int, StlAllocator<int>> vec{StlAllocator<int>(&ar)};
+    for (int i = 0; i < 1000; ++i) {
+        vec.push_back(i);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        assert(vec[i] == i);
+    }
+    assert(ar.GetAllocatedSize() > 0);
+}
+
+static void TestMap() {
+    GenericCpuAllocator ar;
+    typedef StlAllocator<pair<const int, int>> AllocatorType;
+    map<int, int, less<int>, AllocatorType> m{less<int>(), AllocatorType(&ar)};
+    for (int i = 0; i < 100; ++i) {
+        m[i] = i * 2;
+    }
+    assert(m.size() == 100);
+    assert(m[50] == 100);
+
+    // rebinding keeps the underlying allocator
+    StlAllocator<char> other(m.get_allocator());
+    assert(other == m.get_allocator());
+}
+
+int main(void) {
+    TestVector();
+    TestMap();
+    return 0;
+}
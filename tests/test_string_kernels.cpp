@@ -0,0 +1,176 @@
+/* tests every variant of internal string kernels supported by the cpu */
+#include "../src/string_kernels.h"
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+using namespace std;
+using namespace cpputils::internal;
+
+#undef NDEBUG
+#include <assert.h>
+
+static vector<StringKernels> GetVariants() {
+    vector<StringKernels> variants;
+
+    StringKernels kernels;
+    kernels.mem_mem = MemMemGeneric;
+    kernels.count_trailing = CountTrailingGeneric;
+    kernels.find_first = FindFirstGeneric;
+    kernels.find_last = FindLastGeneric;
+    kernels.count_set = CountSetGeneric;
+    kernels.count_char = CountCharGeneric;
+    variants.push_back(kernels);
+
+#ifdef CPPUTILS_X86_DISPATCH
+    const uint32_t features = GetCpuFeatures();
+    if (features & CPU_FEATURE_AVX2) {
+        kernels.mem_mem = MemMemAvx2;
+        kernels.count_trailing = CountTrailingAvx2;
+        kernels.find_first = FindFirstAvx2;
+        kernels.find_last = FindLastAvx2;
+        kernels.count_set = CountSetAvx2;
+        kernels.count_char = CountCharAvx2;
+        variants.push_back(kernels);
+        cout << "avx2 supported" << endl;
+    }
+    if (features & CPU_FEATURE_AVX512BW) {
+        kernels.mem_mem = MemMemAvx512;
+        kernels.count_trailing = CountTrailingAvx512;
+        kernels.find_first = FindFirstAvx512;
+        kernels.find_last = FindLastAvx512;
+        kernels.count_set = CountSetAvx512;
+        kernels.count_char = CountCharAvx512;
+        variants.push_back(kernels);
+        cout << "avx512bw supported" << endl;
+    }
+#endif
+
+    return variants;
+}
+
+static const char* SimpleMemMem(const string& text, const string& pattern) {
+    auto pos = text.find(pattern);
+    return (pos == string::npos) ? nullptr : text.data() + pos;
+}
+
+static unsigned int SimpleCountTrailing(const string& text, char c) {
+    unsigned int n = 0;
+    while (n < text.size() && text[text.size() - 1 - n] == c) {
+        ++n;
+    }
+    return n;
+}
+
+static void TestMemMem(const vector<StringKernels>& variants) {
+    cout << "----- test mem mem -----" << endl;
+
+    mt19937 gen(1234);
+    for (int round = 0; round < 20000; ++round) {
+        // a small alphabet makes many partial matches
+        string text(gen() % 300, 'a');
+        for (auto it = text.begin(); it != text.end(); ++it) {
+            *it = 'a' + gen() % 3;
+        }
+        string pattern(1 + gen() % 8, 'a');
+        for (auto it = pattern.begin(); it != pattern.end(); ++it) {
+            *it = 'a' + gen() % 3;
+        }
+
+        auto expected = SimpleMemMem(text, pattern);
+        for (auto v = variants.begin(); v != variants.end(); ++v) {
+            assert(v->mem_mem(text.data(), text.size(), pattern.data(),
+                              pattern.size()) == expected);
+        }
+    }
+
+    for (auto v = variants.begin(); v != variants.end(); ++v) {
+        assert(v->mem_mem("abc", 3, "", 0) != nullptr);
+        assert(v->mem_mem("abc", 3, "abcd", 4) == nullptr);
+    }
+}
+
+static void TestCountTrailing(const vector<StringKernels>& variants) {
+    cout << "----- test count trailing -----" << endl;
+
+    mt19937 gen(5678);
+    for (int round = 0; round < 20000; ++round) {
+        string text(gen() % 200, 'x');
+        const unsigned int prefix = text.empty() ? 0 : gen() % text.size();
+        for (unsigned int i = 0; i < prefix; ++i) {
+            text[i] = (gen() % 4 == 0) ? 'y' : 'x';
+        }
+
+        const unsigned int expected = SimpleCountTrailing(text, 'x');
+        for (auto v = variants.begin(); v != variants.end(); ++v) {
+            assert(v->count_trailing(text.data(), text.size(), 'x') ==
+                   expected);
+        }
+    }
+}
+
+/* random bytes with about 1/4 of them in `set` */
+static string GenByteSetText(mt19937* gen, const vector<uint8_t>& set) {
+    string text((*gen)() % 300, '\0');
+    for (auto it = text.begin(); it != text.end(); ++it) {
+        const uint32_t r = (*gen)();
+        *it = (r % 4 == 0) ? set[(r >> 8) % set.size()] : (char)(r >> 8);
+    }
+    return text;
+}
+
+static void TestByteSet(const vector<StringKernels>& variants) {
+    cout << "----- test byte set -----" << endl;
+
+    mt19937 gen(4321);
+    for (int round = 0; round < 20000; ++round) {
+        bool model[256] = {false};
+        uint8_t table[32] = {0};
+        vector<uint8_t> set(1 + gen() % 8);
+        for (auto it = set.begin(); it != set.end(); ++it) {
+            *it = gen();
+            model[*it] = true;
+            table[(*it >> 7) * 16 + (*it & 0xf)] |= 1 << ((*it >> 4) & 7);
+        }
+
+        auto text = GenByteSetText(&gen, set);
+        for (int in_set = 0; in_set < 2; ++in_set) {
+            unsigned int first = text.size(), last = 0;
+            for (unsigned int i = 0; i < text.size(); ++i) {
+                if (model[(uint8_t)text[i]] == (bool)in_set) {
+                    if (first == text.size()) {
+                        first = i;
+                    }
+                    last = i + 1;
+                }
+            }
+            for (auto v = variants.begin(); v != variants.end(); ++v) {
+                assert(v->find_first(text.data(), text.size(), table,
+                                     in_set) == first);
+                assert(v->find_last(text.data(), text.size(), table,
+                                    in_set) == last);
+            }
+        }
+
+        unsigned int num_in_set = 0, num_char = 0;
+        for (auto it = text.begin(); it != text.end(); ++it) {
+            num_in_set += model[(uint8_t)*it];
+            num_char += (*it == (char)set[0]);
+        }
+        for (auto v = variants.begin(); v != variants.end(); ++v) {
+            assert(v->count_set(text.data(), text.size(), table) ==
+                   num_in_set);
+            assert(v->count_char(text.data(), text.size(), set[0]) ==
+                   num_char);
+        }
+    }
+}
+
+int main(void) {
+    auto variants = GetVariants();
+    TestMemMem(variants);
+    TestCountTrailing(variants);
+    TestByteSet(variants);
+    return 0;
+}
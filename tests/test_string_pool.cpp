@@ -0,0 +1,118 @@
+#include "cpputils/string_pool.h"
+#include "cpputils/string_utils.h"
+using namespace cpputils;
+
+#include <iostream>
+#include <set>
+#include <string>
+using namespace std;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestStringHash() {
+    cout << "----- test string hash -----" << endl;
+
+    // every length takes a different path
+    set<uint64_t> hashes;
+    const string text(100, 'a');
+    for (unsigned int len = 0; len <= text.size(); ++len) {
+        const uint64_t h = StringHash(text.data(), len);
+        assert(h == StringHash(string(len, 'a').c_str(), len));
+        hashes.insert(h);
+    }
+    assert(hashes.size() == text.size() + 1);
+
+    assert(StringHash("abc", 3) != StringHash("abd", 3));
+    assert(StringHash("abc", 3) != StringHash("abc", 3, 1));
+}
+
+static void TestInternAndFind() {
+    cout << "----- test intern and find -----" << endl;
+
+    StringPool pool;
+    assert(pool.Find("a", 1) == StringPool::INVALID_ID);
+
+    const string text = "host1,200,host2,404,host1,200,,host3";
+    StringSplitter splitter(text.data(), text.size());
+    vector<uint32_t> ids;
+    while (true) {
+        auto field = splitter.Next(",", 1);
+        if (!field.first) {
+            break;
+        }
+        ids.push_back(pool.Intern(field.first, field.second));
+    }
+
+    const vector<uint32_t> expected = {0, 1, 2, 3, 0, 1, 4, 5};
+    assert(ids == expected);
+    assert(pool.size() == 6);
+
+    auto s = pool.Get(2);
+    assert(string(s.first, s.second) == "host2");
+    assert(s.first[s.second] == '\0');
+    assert(pool.Get(4).second == 0);
+    assert(pool.Find("404", 3) == 3);
+    assert(pool.Find("40", 2) == StringPool::INVALID_ID);
+
+    // embedded '\0'
+    const uint32_t id = pool.Intern("a\0b", 3);
+    assert(id == 6 && pool.Find("a\0c", 3) == StringPool::INVALID_ID);
+    assert(memcmp(pool.Get(id).first, "a\0b", 3) == 0);
+
+    pool.Clear();
+    assert(pool.size() == 0);
+    assert(pool.Find("host1", 5) == StringPool::INVALID_ID);
+    assert(pool.Intern("404", 3) == 0);
+}
+
+static void TestManyStrings() {
+    cout << "----- test many strings -----" << endl;
+
+    StringPool pool(4096);
+    const uint32_t n = 100000;
+    for (uint32_t round = 0; round < 2; ++round) {
+        for (uint32_t i = 0; i < n; ++i) {
+            auto s = to_string(i * 7919);
+            assert(pool.Intern(s.data(), s.size()) == i);
+        }
+    }
+    assert(pool.size() == n);
+
+    for (uint32_t i = 0; i < n; ++i) {
+        auto s = to_string(i * 7919);
+        auto v = pool.Get(i);
+        assert(string(v.first, v.second) == s);
+        assert(pool.Find(s.data(), s.size()) == i);
+    }
+}
+
+static void TestIdComparator() {
+    cout << "----- test id comparator -----" << endl;
+
+    StringPool pool;
+    SkipListMap<uint32_t, uint32_t, StringPoolIdComparator> counter;
+    const string text = "get,put,get,del,get,put";
+    StringSplitter splitter(text.data(), text.size());
+    while (true) {
+        auto field = splitter.Next(",", 1);
+        if (!field.first) {
+            break;
+        }
+        const uint32_t id = pool.Intern(field.first, field.second);
+        auto ret = counter.TryEmplace(id, 0);
+        ++ret.first->second;
+    }
+
+    assert(counter.Lookup(pool.Find("get", 3))->second == 3);
+    assert(counter.Lookup(pool.Find("put", 3))->second == 2);
+    assert(counter.Lookup(pool.Find("del", 3))->second == 1);
+}
+
+int main(void) {
+    TestStringHash();
+    TestInternAndFind();
+    TestManyStrings();
+    TestIdComparator();
+    return 0;
+}
@@ -1,7 +1,9 @@
 #include "cpputils/string_utils.h"
+#include "cpputils/file_mapping.h"
 using namespace cpputils;
 
 #include <iostream>
+#include <random>
 using namespace std;
 
 #undef NDEBUG
@@ -59,9 +61,128 @@ static void TestStringReplace() {
          << endl;
 }
 
+static void TestByteSet() {
+    const string text = " \t abc, d\te\r\n";
+    const auto ws = ByteSet::Whitespace();
+    assert(ws.Contains('\n') && !ws.Contains('a') && !ws.Contains('\0'));
+    assert(StringTrimLeft(text.data(), text.size(), ws) == 3);
+    assert(StringTrimRight(text.data(), text.size(), ws) == 2);
+    auto ret = StringTrimBoth(text.data(), text.size(), ws);
+    assert(string(ret.first, ret.second) == "abc, d\te");
+
+    ret = StringTrimBoth(" \t\n", 3, ws);
+    assert(ret.second == 0);
+
+    const ByteSet punct(",.", 2);
+    assert(StringFindFirstOf(text.data(), text.size(), punct) == 6);
+    assert(StringFindFirstOf("abc", 3, punct) == 3);
+    assert(StringFindFirstNotOf(text.data(), text.size(), ws) == 3);
+    assert(StringCount(text.data(), text.size(), ws) == 7);
+    assert(StringCount(text.data(), text.size(), 'd') == 1);
+
+    ByteSet high;
+    high.Add('\xff');
+    assert(high.Contains('\xff') && !high.Contains('\x7f'));
+}
+
+static void TestStringReplacer() {
+    cout << "----- test string replacer -----" << endl;
+
+    mt19937 gen(2468);
+    for (int round = 0; round < 5000; ++round) {
+        string text(gen() % 200, 'a');
+        for (auto it = text.begin(); it != text.end(); ++it) {
+            *it = 'a' + gen() % 2;
+        }
+        string search(1 + gen() % 4, 'a');
+        for (auto it = search.begin(); it != search.end(); ++it) {
+            *it = 'a' + gen() % 2;
+        }
+        const string replace = (round % 3 == 0) ? "" : "<X>";
+
+        string output;
+        StringReplacer replacer(search.data(), search.size(), replace.data(),
+                                replace.size(),
+                                [&output](const char* data, unsigned int len) {
+                                    output.append(data, len);
+                                    return true;
+                                });
+        // chunks of random sizes, including empty ones
+        for (unsigned int pos = 0; pos < text.size();) {
+            const unsigned int len =
+                min<unsigned int>(gen() % 8, text.size() - pos);
+            assert(replacer.Feed(text.data() + pos, len));
+            pos += len;
+        }
+        assert(replacer.Finish());
+
+        string expected = StringReplace(text.data(), text.size(),
+                                        search.data(), search.size(),
+                                        replace.data(), replace.size());
+        if (replace.empty()) {
+            // `StringReplace()` keeps the text if `replace` is empty
+            expected.clear();
+            for (size_t pos = 0;;) {
+                auto found = text.find(search, pos);
+                expected.append(text, pos, found - pos);
+                if (found == string::npos) {
+                    break;
+                }
+                pos = found + search.size();
+            }
+        }
+        assert(output == expected);
+    }
+
+    // stopped by the sink
+    unsigned int calls = 0;
+    StringReplacer replacer("b", 1, "c", 1,
+                            [&calls](const char*, unsigned int) {
+                                return (++calls < 2);
+                            });
+    assert(!replacer.Feed("abab", 4));
+}
+
+static void TestStringReplacerFeedFile() {
+    cout << "----- test string replacer feed file -----" << endl;
+
+    FileMapping fm;
+    assert(fm.Init(__FILE__, FileMapping::READ));
+    const string search = "assert", replace = "ASSERT";
+    const string expected =
+        StringReplace((const char*)fm.data(), fm.size(), search.data(),
+                      search.size(), replace.data(), replace.size());
+
+    string output;
+    auto sink = [&output](const char* data, unsigned int len) {
+        output.append(data, len);
+        return true;
+    };
+    StringReplacer replacer(search.data(), search.size(), replace.data(),
+                            replace.size(), sink);
+    // windows smaller than `search`
+    assert(replacer.FeedFile(__FILE__, 0, UINT64_MAX, 5));
+    assert(replacer.Finish());
+    assert(output == expected);
+
+    output.clear();
+    assert(replacer.FeedFile(__FILE__, 10, 100, 4096));
+    assert(replacer.Finish());
+    assert(output ==
+           StringReplace((const char*)fm.data() + 10, 100, search.data(),
+                         search.size(), replace.data(), replace.size()));
+
+    string errmsg;
+    assert(!replacer.FeedFile("nonexist", 0, UINT64_MAX, 4096, &errmsg));
+    assert(!errmsg.empty());
+}
+
 int main(void) {
     TestStringReplace();
     TestStringSplitter();
+    TestByteSet();
+    TestStringReplacer();
+    TestStringReplacerFeedFile();
 
     return 0;
 }
@@ -0,0 +1,152 @@
+#include "cpputils/timing_wheel.h"
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+struct Timer final : public TimerNode {
+    uint32_t id = 0;
+    uint64_t fired_tick = UINT64_MAX;
+};
+
+static void TestBasic() {
+    cout << "----- test basic -----" << endl;
+
+    TimingWheel wheel(1000, 0); // 1us per tick
+    assert(wheel.IsEmpty());
+    assert(wheel.GetTickLength() == 1000);
+
+    Timer timers[4];
+    wheel.Add(&timers[0], 0);
+    wheel.Add(&timers[1], 1500); // rounded up to 2 ticks
+    wheel.Add(&timers[2], 100000);
+    wheel.Add(&timers[3], 100000);
+    assert(wheel.size() == 4);
+    assert(timers[1].IsPending() && timers[1].GetExpireTick() == 2);
+
+    vector<Timer*> fired;
+    auto cb = [&fired](TimerNode* node) -> void {
+        fired.push_back(static_cast<Timer*>(node));
+    };
+
+    assert(wheel.Advance(1999, cb) == 1);
+    assert(fired.size() == 1 && fired[0] == &timers[0]);
+    assert(!timers[0].IsPending());
+    assert(wheel.GetCurrentTick() == 2);
+
+    assert(wheel.Cancel(&timers[3]));
+    assert(!wheel.Cancel(&timers[3]));
+    assert(wheel.size() == 2);
+
+    // reschedules a pending timer
+    wheel.Add(&timers[1], 5000);
+    assert(wheel.size() == 2);
+    assert(wheel.Advance(2000, cb) == 0);
+    assert(wheel.Advance(7000, cb) == 1);
+    assert(fired.back() == &timers[1]);
+
+    assert(wheel.Advance(99999, cb) == 0);
+    assert(wheel.Advance(100000, cb) == 1);
+    assert(fired.back() == &timers[2]);
+    assert(wheel.IsEmpty());
+
+    // time before the base is ignored
+    TimingWheel later(1000, 1000000);
+    assert(later.Advance(0, cb) == 0);
+    assert(later.GetCurrentTick() == 0);
+}
+
+static void TestCallback() {
+    cout << "----- test callback -----" << endl;
+
+    TimingWheel wheel(1, 0);
+    Timer periodic, victim;
+    uint32_t periodic_num = 0;
+    wheel.AddAtTick(&periodic, 10);
+    wheel.AddAtTick(&victim, 10);
+
+    // cancels another timer of the same batch and reschedules itself
+    auto cb = [&](TimerNode* node) -> void {
+        assert(node == &periodic);
+        ++periodic_num;
+        wheel.Cancel(&victim);
+        if (periodic_num < 100) {
+            wheel.Add(&periodic, 7);
+        }
+    };
+    assert(wheel.Advance(1000, cb) == 100);
+    assert(periodic_num == 100);
+    assert(!victim.IsPending());
+    assert(wheel.IsEmpty());
+
+    // a timer in the past expires at the next tick
+    wheel.AddAtTick(&victim, 5);
+    uint64_t fired_tick = 0;
+    assert(wheel.Advance(1001, [&](TimerNode*) -> void {
+        fired_tick = wheel.GetCurrentTick() - 1;
+    }) == 1);
+    assert(fired_tick == 1001);
+}
+
+static void TestRandom() {
+    cout << "----- test random -----" << endl;
+
+    constexpr uint32_t N = 200000;
+    std::mt19937_64 gen(1234);
+    TimingWheel wheel(1, 0);
+    vector<Timer> timers(N);
+
+    uint64_t cancelled = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        timers[i].id = i;
+        // delays of all levels, including ones beyond the range of the wheel
+        const uint32_t bits = gen() % 40;
+        wheel.Add(&timers[i], gen() & ((1ull << bits) - 1));
+        if (gen() % 4 == 0) {
+            // moves the wheel forward between adds
+            wheel.Advance(wheel.GetCurrentTick() + gen() % 100,
+                          [&](TimerNode* node) -> void {
+                              auto t = static_cast<Timer*>(node);
+                              t->fired_tick = wheel.GetCurrentTick() - 1;
+                          });
+        }
+        if (i > 0 && gen() % 8 == 0) {
+            cancelled += wheel.Cancel(&timers[gen() % i]);
+        }
+    }
+
+    uint64_t fired = 0;
+    auto cb = [&](TimerNode* node) -> void {
+        auto t = static_cast<Timer*>(node);
+        t->fired_tick = wheel.GetCurrentTick() - 1;
+    };
+    uint64_t now = wheel.GetCurrentTick();
+    while (!wheel.IsEmpty()) {
+        now += (gen() % 2) ? (gen() % 1000) : (1ull << (gen() % 40));
+        fired += wheel.Advance(now, cb);
+    }
+
+    uint64_t total_fired = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+        const Timer& t = timers[i];
+        assert(!t.IsPending());
+        if (t.fired_tick != UINT64_MAX) {
+            ++total_fired;
+            assert(t.fired_tick == t.GetExpireTick());
+        }
+    }
+    assert(total_fired + cancelled == N);
+    assert(fired <= total_fired);
+}
+
+int main(void) {
+    TestBasic();
+    TestCallback();
+    TestRandom();
+    return 0;
+}
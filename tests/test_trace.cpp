@@ -0,0 +1,171 @@
+#include "cpputils/trace.h"
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestHistogram() {
+    cout << "----- test histogram -----" << endl;
+
+    TraceHistogram h;
+    assert(h.GetCount() == 0);
+    assert(h.GetPercentile(50) == 0);
+
+    for (uint64_t i = 1; i <= 1000; ++i) {
+        h.Record(i);
+    }
+    assert(h.GetCount() == 1000);
+    assert(h.GetMin() == 1 && h.GetMax() == 1000);
+    assert(h.GetMean() == 500.5);
+    assert(h.GetPercentile(0) == 1);
+    assert(h.GetPercentile(100) <= 1000 && h.GetPercentile(100) >= 992);
+
+    const uint64_t p50 = h.GetPercentile(50);
+    const uint64_t p99 = h.GetPercentile(99);
+    assert(p50 <= 500 && p50 >= 500 * 15 / 16);
+    assert(p99 <= 990 && p99 >= 990 * 15 / 16);
+
+    TraceHistogram big;
+    big.Record(UINT64_MAX);
+    assert(big.GetPercentile(50) == UINT64_MAX);
+}
+
+static void Work(int n) {
+    TraceSpan span("work");
+    volatile int sum = 0;
+    for (int i = 0; i < n; ++i) {
+        sum = sum + i;
+    }
+}
+
+static void TestSpans() {
+    cout << "----- test spans -----" << endl;
+
+    TraceCollector collector;
+    {
+        TraceSpan outer("main \"outer\"");
+        for (int i = 0; i < 10; ++i) {
+            Work(1000);
+        }
+    }
+
+    vector<thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([]() -> void {
+            for (int i = 0; i < 100; ++i) {
+                Work(100);
+            }
+        });
+    }
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        it->join();
+    }
+
+    assert(collector.Collect() == 311);
+    assert(collector.Collect() == 0);
+    assert(collector.GetDroppedCount() == 0);
+
+    auto histograms = collector.GetHistograms();
+    assert(histograms.size() == 2);
+    auto& work = histograms["work"];
+    auto& outer = histograms["main \"outer\""];
+    assert(work.GetCount() == 310);
+    assert(outer.GetCount() == 1);
+    assert(outer.GetMax() >= work.GetMax());
+
+    string json;
+    collector.ExportChromeTrace(&json);
+    assert(json.find("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[{") == 0);
+    assert(json.find("\"name\":\"main \\\"outer\\\"\"") != string::npos);
+    assert(json.find("\"ph\":\"X\"") != string::npos);
+    assert(json.substr(json.size() - 3) == "}]}");
+
+    collector.Clear();
+    assert(collector.GetHistograms().empty());
+    json.clear();
+    collector.ExportChromeTrace(&json);
+    assert(json == "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[]}");
+}
+
+static void TestDropped() {
+    cout << "----- test dropped -----" << endl;
+
+    SetTraceBufferCapacity(16);
+    thread t([]() -> void {
+        for (int i = 0; i < 100; ++i) {
+            TraceRecord("dropped", TraceNow(), TraceNow());
+        }
+    });
+    t.join();
+    SetTraceBufferCapacity(4096);
+
+    TraceCollector collector(10);
+    assert(collector.Collect() == 16);
+    assert(collector.GetDroppedCount() == 84);
+    assert(collector.GetHistograms()["dropped"].GetCount() == 16);
+
+    // only `max_events` events are kept for the trace
+    string json;
+    collector.ExportChromeTrace(&json);
+    uint32_t n = 0;
+    for (size_t pos = 0; (pos = json.find("\"ph\"", pos)) != string::npos;
+         ++pos) {
+        ++n;
+    }
+    assert(n == 10);
+}
+
+static void TestReusedNames() {
+    cout << "----- test reused names -----" << endl;
+
+    TraceCollector collector;
+    char name[16] = "first";
+    TraceRecord(name, TraceNow(), TraceNow());
+    assert(collector.Collect() == 1);
+
+    // the same address with different contents
+    strcpy(name, "second");
+    TraceRecord(name, TraceNow(), TraceNow());
+    assert(collector.Collect() == 1);
+    memset(name, 0, sizeof(name));
+
+    auto histograms = collector.GetHistograms();
+    assert(histograms.size() == 2);
+    assert(histograms["first"].GetCount() == 1);
+    assert(histograms["second"].GetCount() == 1);
+
+    string json;
+    collector.ExportChromeTrace(&json);
+    assert(json.find("\"name\":\"first\"") != string::npos);
+    assert(json.find("\"name\":\"second\"") != string::npos);
+}
+
+static void TestBackground() {
+    cout << "----- test background -----" << endl;
+
+    TraceCollector collector;
+    assert(collector.Start(1));
+    assert(!collector.Start(1));
+
+    for (int i = 0; i < 20000; ++i) {
+        TraceSpan span("background");
+    }
+    collector.Stop();
+    assert(collector.GetHistograms()["background"].GetCount() +
+               collector.GetDroppedCount() ==
+           20000);
+}
+
+int main(void) {
+    TestHistogram();
+    TestSpans();
+    TestDropped();
+    TestReusedNames();
+    TestBackground();
+    return 0;
+}
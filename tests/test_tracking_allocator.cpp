@@ -0,0 +1,91 @@
+#include "cpputils/tracking_allocator.h"
+#include "cpputils/arena_allocator.h"
+#include "cpputils/skiplist.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+static void TestCounters() {
+    TrackingAllocator<> ar;
+
+    auto p1 = ar.Alloc(100);
+    auto p2 = ar.Alloc(1000);
+    auto stats = ar.GetStats();
+    assert(stats.alloc_count == 2);
+    assert(stats.live_bytes == 1100);
+    assert(stats.peak_bytes == 1100);
+    assert(stats.size_histogram[6] == 1); // [64, 128)
+    assert(stats.size_histogram[9] == 1); // [512, 1024)
+
+    ar.Free(p2, 1000);
+    ar.Free(p1);
+    stats = ar.GetStats();
+    assert(stats.free_count == 2);
+    assert(stats.unsized_free_count == 1);
+    assert(stats.live_bytes == 100);
+    assert(stats.peak_bytes == 1100);
+
+    ar.ResetStats();
+    stats = ar.GetStats();
+    assert(stats.alloc_count == 0);
+    assert(stats.peak_bytes == 100);
+}
+
+static void TestMultiThreads() {
+    TrackingAllocator<> ar;
+    vector<thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([&ar]() -> void {
+            for (int j = 0; j < 1000; ++j) {
+                auto ptr = ar.Alloc(64);
+                ar.Free(ptr, 64);
+            }
+        });
+    }
+    for (auto it = threads.begin(); it != threads.end(); ++it) {
+        it->join();
+    }
+
+    auto stats = ar.GetStats();
+    assert(stats.alloc_count == 4000);
+    assert(stats.free_count == 4000);
+    assert(stats.live_bytes == 0);
+    assert(stats.peak_bytes >= 64 && stats.peak_bytes <= 4 * 64);
+}
+
+static void TestSkipListPolicy() {
+    SkipListSet<int, internal::GenericComparator<int>,
+                TrackingAllocator<ArenaAllocator>>
+        sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(i).second);
+    }
+    for (int i = 0; i < 500; ++i) {
+        assert(sl.Remove(i));
+    }
+
+    auto stats = sl.GetStats();
+    assert(stats.alloc_count == 1000);
+    assert(stats.free_count == 500);
+    assert(stats.unsized_free_count == 0);
+
+    string output;
+    ExportAllocStats(stats, "skiplist", &output);
+    cout << output;
+    assert(output.find("cpputils_alloc_alloc_count{allocator=\"skiplist\"} "
+                       "1000\n") != string::npos);
+    assert(output.find("cpputils_alloc_size_bucket{allocator=\"skiplist\","
+                       "le=\"+Inf\"} 1000\n") != string::npos);
+}
+
+int main(void) {
+    TestCounters();
+    TestMultiThreads();
+    TestSkipListPolicy();
+    return 0;
+}
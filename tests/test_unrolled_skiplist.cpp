@@ -0,0 +1,114 @@
+#include "cpputils/unrolled_skiplist.h"
+#include <iostream>
+#include <random>
+#include <set>
+using namespace std;
+using namespace cpputils;
+
+#undef NDEBUG
+#include <assert.h>
+
+typedef UnrolledSkipListSet<int, internal::GenericComparator<int>,
+                            GenericCpuAllocator, 4>
+    TestSet;
+
+static void CheckEqual(const TestSet& sl, const set<int>& expected) {
+    auto it = sl.GetBeginIterator();
+    for (auto e = expected.begin(); e != expected.end(); ++e) {
+        assert(it != sl.GetEndIterator());
+        assert(*it == *e);
+        ++it;
+    }
+    assert(it == sl.GetEndIterator());
+    assert(sl.IsEmpty() == expected.empty());
+}
+
+static void TestBasic() {
+    cout << "----- test basic -----" << endl;
+
+    TestSet sl;
+    for (int i = 100; i > 0; i -= 10) {
+        assert(sl.Insert(i).second);
+    }
+    assert(!sl.Insert(50).second);
+
+    auto it = sl.Lookup(50);
+    assert(it != sl.GetEndIterator() && *it == 50);
+    assert(sl.Lookup(55) == sl.GetEndIterator());
+    assert(sl.Lookup(5) == sl.GetEndIterator());
+
+    assert(*sl.LookupGreaterEqual(21) == 30);
+    assert(*sl.LookupGreaterEqual(5) == 10);
+    assert(sl.LookupGreaterEqual(101) == sl.GetEndIterator());
+
+    assert(*sl.LookupLessThan(21) == 20);
+    assert(*sl.LookupLessThan(20) == 10);
+    assert(*sl.LookupLessThan(1000) == 100);
+    assert(sl.LookupLessThan(10) == sl.GetEndIterator());
+
+    int value = 0;
+    assert(sl.Remove(10, &value));
+    assert(value == 10);
+    assert(!sl.Remove(10));
+
+    sl.Clear();
+    assert(sl.IsEmpty());
+}
+
+static void TestRandomOps() {
+    cout << "----- test random ops -----" << endl;
+
+    TestSet sl;
+    set<int> expected;
+    mt19937 gen(0);
+    uniform_int_distribution<int> d(0, 999);
+    for (int round = 0; round < 20000; ++round) {
+        int key = d(gen);
+        if (gen() % 3 == 0) {
+            assert(sl.Remove(key) == (expected.erase(key) > 0));
+        } else {
+            assert(sl.Insert(key).second == expected.insert(key).second);
+        }
+
+        auto it = sl.LookupGreaterEqual(key);
+        auto e = expected.lower_bound(key);
+        if (e == expected.end()) {
+            assert(it == sl.GetEndIterator());
+        } else {
+            assert(*it == *e);
+        }
+    }
+    CheckEqual(sl, expected);
+
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Remove(i) == (expected.erase(i) > 0));
+    }
+    CheckEqual(sl, expected);
+}
+
+static void TestMap() {
+    cout << "----- test map -----" << endl;
+
+    UnrolledSkipListMap<int, string> sl;
+    for (int i = 0; i < 1000; ++i) {
+        assert(sl.Insert(make_pair(i, to_string(i))).second);
+    }
+    for (int i = 0; i < 1000; i += 2) {
+        assert(sl.Remove(i));
+    }
+
+    int expected = 1;
+    for (auto it = sl.GetBeginIterator(); it != sl.GetEndIterator(); ++it) {
+        assert(it->first == expected);
+        assert(it->second == to_string(expected));
+        expected += 2;
+    }
+    assert(expected == 1001);
+}
+
+int main(void) {
+    TestBasic();
+    TestRandomOps();
+    TestMap();
+    return 0;
+}